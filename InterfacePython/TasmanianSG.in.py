@@ -143,6 +143,7 @@ class TasmanianSparseGrid:
         self.pLibTSG.tsgGetNumNeeded.restype = c_int
         self.pLibTSG.tsgGetNumPoints.restype = c_int
         self.pLibTSG.tsgRead.restype = c_int
+        self.pLibTSG.tsgReadMapped.restype = c_int
         self.pLibTSG.tsgGetAlpha.restype = c_double
         self.pLibTSG.tsgGetBeta.restype = c_double
         self.pLibTSG.tsgGetOrder.restype = c_int
@@ -171,6 +172,10 @@ class TasmanianSparseGrid:
         self.pLibTSG.tsgWrite.argtypes = [c_void_p, c_char_p]
         self.pLibTSG.tsgWriteBinary.argtypes = [c_void_p, c_char_p]
         self.pLibTSG.tsgRead.argtypes = [c_void_p, c_char_p]
+        self.pLibTSG.tsgWriteMapped.argtypes = [c_void_p, c_char_p]
+        self.pLibTSG.tsgWriteChunked.argtypes = [c_void_p, c_char_p]
+        self.pLibTSG.tsgWriteCompressed.argtypes = [c_void_p, c_char_p, c_double]
+        self.pLibTSG.tsgReadMapped.argtypes = [c_void_p, c_char_p]
         self.pLibTSG.tsgMakeGlobalGrid.argtypes = [c_void_p, c_int, c_int, c_int, c_char_p, c_char_p, POINTER(c_int), c_double, c_double, c_char_p, POINTER(c_int)]
         self.pLibTSG.tsgMakeSequenceGrid.argtypes = [c_void_p, c_int, c_int, c_int, c_char_p, c_char_p, POINTER(c_int), POINTER(c_int)]
         self.pLibTSG.tsgMakeLocalPolynomialGrid.argtypes = [c_void_p, c_int, c_int, c_int, c_int, c_char_p, POINTER(c_int)]
@@ -240,6 +245,7 @@ class TasmanianSparseGrid:
         self.pLibTSG.tsgGetCandidateConstructionPointsPythonStatic.argtypes = [c_void_p, POINTER(c_double)]
         self.pLibTSG.tsgGetCandidateConstructionPointsPythonDeleteVect.argtypes = [c_void_p]
         self.pLibTSG.tsgLoadConstructedPoint.argtypes = [c_void_p, POINTER(c_double), POINTER(c_double)]
+        self.pLibTSG.tsgLoadConstructedPoints.argtypes = [c_void_p, POINTER(c_double), c_int, POINTER(c_double)]
         self.pLibTSG.tsgFinishConstruction.argtypes = [c_void_p]
         self.pLibTSG.tsgPrintStats.argtypes = [c_void_p]
         self.pLibTSG.tsgEnableAcceleration.argtypes = [c_void_p, c_char_p]
@@ -357,6 +363,74 @@ class TasmanianSparseGrid:
         else:
             self.pLibTSG.tsgWrite(self.pGrid, c_char_p(sFilename))
 
+    def readMapped(self, sFilename):
+        '''
+        reads the grid from a file written with writeMapped()
+        the file is memory mapped and the values and hierarchical
+        coefficients are used directly from the mapping, i.e.,
+        the data is not copied and multiple processes share the memory
+        the file should not be modified while the grid is in use
+
+        sFilename: string indicating a grid file
+
+        output: boolean
+                True: the read was successful
+                False: the read failed,
+                       check the CLI output for an error message
+
+        '''
+        if (sys.version_info.major == 3):
+            sFilename = bytes(sFilename, encoding='utf8')
+        return (self.pLibTSG.tsgReadMapped(self.pGrid, c_char_p(sFilename)) != 0)
+
+    def writeMapped(self, sFilename):
+        '''
+        writes the grid to a binary file with aligned data
+        that can be used with readMapped()
+
+        sFilename: string indicating a grid file where a grid will
+                   be written
+
+        '''
+        if (sys.version_info.major == 3):
+            sFilename = bytes(sFilename, encoding='utf8')
+        self.pLibTSG.tsgWriteMapped(self.pGrid, c_char_p(sFilename))
+
+    def writeChunked(self, sFilename):
+        '''
+        writes the grid to a binary file in the chunked format,
+        the large arrays are split into chunks with checksums
+        that are written and read by multiple threads,
+        intended for very large grids, the file is read with read()
+
+        sFilename: string indicating a grid file where a grid will
+                   be written
+
+        '''
+        if (sys.version_info.major == 3):
+            sFilename = bytes(sFilename, encoding='utf8')
+        self.pLibTSG.tsgWriteChunked(self.pGrid, c_char_p(sFilename))
+
+    def writeCompressed(self, sFilename, fTolerance = 0.0):
+        '''
+        writes the grid to a binary file in the compressed format,
+        the values and hierarchical coefficients are compressed
+        and grouped by level, the file is read with read()
+
+        sFilename: string indicating a grid file where a grid will
+                   be written
+
+        fTolerance: non-negative float, the largest error allowed in
+                    the stored values and coefficients,
+                    0.0 indicates lossless compression
+
+        '''
+        if (fTolerance < 0.0):
+            raise TasmanianInputError("fTolerance", "ERROR: fTolerance must be non-negative")
+        if (sys.version_info.major == 3):
+            sFilename = bytes(sFilename, encoding='utf8')
+        self.pLibTSG.tsgWriteCompressed(self.pGrid, c_char_p(sFilename), fTolerance)
+
     def makeGlobalGrid(self, iDimension, iOutputs, iDepth, sType, sRule, liAnisotropicWeights=[], fAlpha=0.0, fBeta=0.0, sCustomFilename="", liLevelLimits=[]):
         '''
         creates a new sparse grid using a global rule
@@ -1659,6 +1733,33 @@ class TasmanianSparseGrid:
 
         self.pLibTSG.tsgLoadConstructedPoint(self.pGrid, np.ctypeslib.as_ctypes(lfX), np.ctypeslib.as_ctypes(lfY))
 
+    def loadConstructedPoints(self, llfX, llfY):
+        '''
+        load a batch of computed points, the grid is updated once for the whole batch
+
+        llfX: numpy.ndarray of dimension two
+              each row is a point, the number of columns must match the grid dimension
+        llfY: numpy.ndarray of dimension two
+              each row is the model output at the corresponding point,
+              the number of columns must match the number of outputs
+        '''
+        if (not self.isUsingConstruction()):
+            raise TasmanianInputError("loadConstructedPoints", "ERROR: calling loadConstructedPoints() before beginConstruction()")
+        if (not isinstance(llfX, np.ndarray)):
+            llfX = np.array(llfX)
+        if (not isinstance(llfY, np.ndarray)):
+            llfY = np.array(llfY)
+        if (len(llfX.shape) != 2) or (llfX.shape[1] != self.getNumDimensions()):
+            raise TasmanianInputError("llfX", "ERROR: llfX should be a 2-D numpy.ndarray with number of columns equal to the grid dimension")
+        if (len(llfY.shape) != 2) or (llfY.shape[1] != self.getNumOutputs()) or (llfY.shape[0] != llfX.shape[0]):
+            raise TasmanianInputError("llfY", "ERROR: llfY should be a 2-D numpy.ndarray with one row per point and number of columns equal to the model outputs")
+        if (llfX.shape[0] == 0):
+            return
+
+        llfX = np.ascontiguousarray(llfX, dtype=np.float64)
+        llfY = np.ascontiguousarray(llfY, dtype=np.float64)
+        self.pLibTSG.tsgLoadConstructedPoints(self.pGrid, np.ctypeslib.as_ctypes(llfX.reshape([llfX.size,])), llfX.shape[0], np.ctypeslib.as_ctypes(llfY.reshape([llfY.size,])))
+
     def finishConstruction(self):
         '''
         end the dynamic construction procedure
@@ -109,6 +109,21 @@ class TestTasClass(unittest.TestCase):
             gridB.read("testSave")
             ttc.compareGrids(gridA, gridB)
 
+            gridA.writeMapped("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.readMapped("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeChunked("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeCompressed("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
             gridB.makeGlobalGrid(1, 0, 1, "level", "rleja")
             gridB.makeLocalPolynomialGrid(1, 1, 0)
             gridB.copyGrid(gridA)
@@ -170,6 +185,21 @@ class TestTasClass(unittest.TestCase):
             gridB.read("testSave")
             ttc.compareGrids(gridA, gridB)
 
+            gridA.writeMapped("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.readMapped("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeChunked("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeCompressed("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
             gridB.makeGlobalGrid(1, 0, 1, "level", "rleja")
             gridB.makeLocalPolynomialGrid(1, 1, 0)
             gridB.copyGrid(gridA)
@@ -212,6 +242,21 @@ class TestTasClass(unittest.TestCase):
             gridB.read("testSave")
             ttc.compareGrids(gridA, gridB)
 
+            gridA.writeMapped("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.readMapped("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeChunked("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeCompressed("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
             gridB.makeGlobalGrid(1, 0, 1, "level", "rleja")
             gridB.makeLocalPolynomialGrid(1, 1, 0)
             gridB.copyGrid(gridA)
@@ -253,6 +298,21 @@ class TestTasClass(unittest.TestCase):
             gridB.read("testSave")
             ttc.compareGrids(gridA, gridB)
 
+            gridA.writeMapped("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.readMapped("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeChunked("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeCompressed("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
             gridB.makeGlobalGrid(1, 0, 1, "level", "rleja")
             gridB.makeLocalPolynomialGrid(1, 1, 0)
             gridB.copyGrid(gridA)
@@ -293,6 +353,21 @@ class TestTasClass(unittest.TestCase):
             gridB.read("testSave")
             ttc.compareGrids(gridA, gridB)
 
+            gridA.writeMapped("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.readMapped("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeChunked("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeCompressed("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
             gridB.makeGlobalGrid(1, 0, 1, "level", "rleja")
             gridB.makeLocalPolynomialGrid(1, 1, 0)
             gridB.copyGrid(gridA)
@@ -323,6 +398,21 @@ class TestTasClass(unittest.TestCase):
             gridB.read("testSave")
             ttc.compareGrids(gridA, gridB)
 
+            gridA.writeMapped("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.readMapped("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeChunked("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
+            gridA.writeCompressed("testSave")
+            gridB.makeLocalPolynomialGrid(1, 1, 0)
+            gridB.read("testSave")
+            ttc.compareGrids(gridA, gridB)
+
             gridB.makeSequenceGrid(1, 1, 0, "level", "leja");
             gridB.makeLocalPolynomialGrid(1, 1, 0)
             gridB.copyGrid(gridA)
@@ -50,7 +50,21 @@ bool benchmark_evaluate(std::deque<std::string> &args){
         long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(time_end - time_start).count();
         int normalized = int( double(elapsed) / double(iteratons) );
 
-        cout << setw(7) << normalized << endl;
+        cout << setw(7) << normalized;
+
+        if (grid_family == GridFamily::localp){ // compare the tree walk to the support index
+            grid.enableSupportIndex(true);
+            grid.evaluateBatch(inputs.back(), result);
+
+            time_start = std::chrono::system_clock::now();
+            for(size_t i=0; i < (size_t) iteratons; i++)
+                grid.evaluateBatch(inputs[i], result);
+            time_end = std::chrono::system_clock::now();
+
+            elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(time_end - time_start).count();
+            cout << "  (support index: " << setw(7) << int( double(elapsed) / double(iteratons) ) << ")";
+        }
+        cout << endl;
         num_outputs *= 2;
     }
 
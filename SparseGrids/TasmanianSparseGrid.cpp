@@ -33,6 +33,8 @@
 
 #include "TasmanianSparseGrid.hpp"
 
+#include <sstream>
+
 #include "tsgUtils.hpp"
 
 template<class T> std::unique_ptr<T> make_unique_ptr(){ return std::unique_ptr<T>(new T()); }
@@ -104,14 +106,21 @@ void TasmanianSparseGrid::write(const char *filename, bool binary) const{
 }
 void TasmanianSparseGrid::read(const char *filename){
     std::ifstream ifs;
-    char TSG[3];
+    char TSG[4];
     bool binary_format = false;
     ifs.open(filename, std::ios::in | std::ios::binary);
-    ifs.read(TSG, 3 * sizeof(char));
+    ifs.read(TSG, 4 * sizeof(char));
     if ((TSG[0] == 'T') && (TSG[1] == 'S') && (TSG[2] == 'G')){
         binary_format = true;
     }
     ifs.close();
+    if (binary_format && (TSG[3] == '7')){ // chunked format, the arrays are read in parallel
+        IO::ChunkedReader reader;
+        std::istringstream iss(IO::readChunkedFile(filename, reader));
+        IO::setChunkedReader(iss, &reader);
+        readBinary(iss);
+        return;
+    }
     if (binary_format){
         ifs.open(filename, std::ios::in | std::ios::binary);
     }else{
@@ -121,6 +130,33 @@ void TasmanianSparseGrid::read(const char *filename){
     ifs.close();
 }
 
+void TasmanianSparseGrid::writeMapped(const char *filename) const{
+    std::ofstream ofs(filename, std::ios::out | std::ios::binary);
+    IO::setMappedFormat(ofs, true);
+    writeBinary(ofs);
+    ofs.close();
+}
+void TasmanianSparseGrid::writeChunked(const char *filename) const{
+    IO::ChunkedWriter writer;
+    std::ostringstream metadata;
+    IO::setChunkedWriter(metadata, &writer);
+    writeBinary(metadata);
+    IO::writeChunkedFile(filename, metadata.str(), writer);
+}
+void TasmanianSparseGrid::writeCompressed(const char *filename, double tolerance) const{
+    if (tolerance < 0.0) throw std::invalid_argument("ERROR: writeCompressed() requires non-negative tolerance");
+    IO::CompressedFormat format = {tolerance};
+    std::ofstream ofs(filename, std::ios::out | std::ios::binary);
+    IO::setCompressedFormat(ofs, &format);
+    writeBinary(ofs);
+    ofs.close();
+}
+void TasmanianSparseGrid::readMapped(const char *filename){
+    IO::MappedBuffer buffer(std::make_shared<IO::MappedFile>(filename));
+    std::istream ifs(&buffer);
+    readBinary(ifs); // the mapped file is kept alive by the arrays that use it
+}
+
 void TasmanianSparseGrid::write(std::ostream &ofs, bool binary) const{
     if (binary){
         writeBinary(ofs);
@@ -443,6 +479,17 @@ void TasmanianSparseGrid::evaluateBatch(const double x[], int num_x, double y[])
     #endif
     base->evaluateBatch(x_canonical, num_x, y);
 }
+void TasmanianSparseGrid::evaluateBatch(const float x[], int num_x, float y[]) const{
+    Data2D<double> x_tmp;
+    const double *x_canonical = formCanonicalPoints(x, x_tmp, num_x);
+    #ifdef Tasmanian_ENABLE_BLAS
+    if (acceleration == accel_cpu_blas){
+        base->evaluateBlas(x_canonical, num_x, y);
+        return;
+    }
+    #endif
+    base->evaluateBatch(x_canonical, num_x, y); // there is no single precision GPU variant, the CUDA modes fallback to the CPU
+}
 #ifdef Tasmanian_ENABLE_CUDA
 void TasmanianSparseGrid::evaluateBatchGPU(const double gpu_x[], int cpu_num_x, double gpu_y[]) const{
     if (!engine) throw std::runtime_error("ERROR: evaluateBatchGPU() requires that a cuda gpu acceleration is enabled.");
@@ -485,6 +532,12 @@ void TasmanianSparseGrid::evaluateBatch(const std::vector<double> &x, std::vecto
     y.resize(num_outputs * num_x);
     evaluateBatch(x.data(), (int) num_x, y.data());
 }
+void TasmanianSparseGrid::evaluateBatch(const std::vector<float> &x, std::vector<float> &y) const{
+    int num_outputs = getNumOutputs();
+    size_t num_x = x.size() / getNumDimensions();
+    y.resize(num_outputs * num_x);
+    evaluateBatch(x.data(), (int) num_x, y.data());
+}
 void TasmanianSparseGrid::integrate(std::vector<double> &q) const{
     size_t num_outputs = getNumOutputs();
     q.resize(num_outputs);
@@ -802,6 +855,14 @@ const double* TasmanianSparseGrid::formCanonicalPoints(const double *x, Data2D<d
         return x;
     }
 }
+const double* TasmanianSparseGrid::formCanonicalPoints(const float *x, Data2D<double> &x_temp, int num_x) const{
+    int num_dimensions = base->getNumDimensions();
+    x_temp.resize(num_dimensions, num_x);
+    std::transform(x, x + Utils::size_mult(num_dimensions, num_x), x_temp.getStrip(0), [](float v)->double{ return (double) v; });
+    mapConformalTransformedToCanonical(num_dimensions, num_x, x_temp);
+    if (domain_transform_a.size() != 0) mapTransformedToCanonical(num_dimensions, num_x, base->getRule(), x_temp.getStrip(0));
+    return x_temp.getStrip(0);
+}
 void TasmanianSparseGrid::formTransformedPoints(int num_points, double x[]) const{
     mapConformalCanonicalToTransformed(base->getNumDimensions(), num_points, x); // internally switch based on the conformal transform
     if (domain_transform_a.size() != 0){ // check the basic domain
@@ -1041,6 +1102,19 @@ void TasmanianSparseGrid::loadConstructedPoint(const double x[], const double y[
     std::vector<double> vecx(x, x + getNumDimensions()), vecy(y, y + getNumOutputs());
     loadConstructedPoint(vecx, vecy);
 }
+void TasmanianSparseGrid::loadConstructedPoints(const std::vector<double> &x, const std::vector<double> &y){
+    if (!usingDynamicConstruction) throw std::runtime_error("ERROR: loadConstructedPoints() called before beginConstruction()");
+    int num_x = (int) (x.size() / Utils::size_mult(1, getNumDimensions()));
+    if (x.size() != Utils::size_mult(num_x, getNumDimensions())) throw std::runtime_error("ERROR: loadConstructedPoints() called with incorrect size for x");
+    if (y.size() != Utils::size_mult(num_x, getNumOutputs())) throw std::runtime_error("ERROR: loadConstructedPoints() called with incorrect size for y");
+    loadConstructedPoints(x.data(), num_x, y.data());
+}
+void TasmanianSparseGrid::loadConstructedPoints(const double x[], int num_x, const double y[]){
+    if (!usingDynamicConstruction) throw std::runtime_error("ERROR: loadConstructedPoints() called before beginConstruction()");
+    if (num_x < 1) return;
+    Data2D<double> x_tmp;
+    base->loadConstructedPoints(formCanonicalPoints(x, x_tmp, num_x), num_x, y);
+}
 void TasmanianSparseGrid::finishConstruction(){
     if (usingDynamicConstruction) base->finishConstruction();
     usingDynamicConstruction = false;
@@ -1067,6 +1141,17 @@ void TasmanianSparseGrid::evaluateHierarchicalFunctions(const std::vector<double
     y.resize(expected_size);
     evaluateHierarchicalFunctions(x.data(), (int) num_x, y.data());
 }
+void TasmanianSparseGrid::evaluateHierarchicalFunctions(const float x[], int num_x, float y[]) const{
+    Data2D<double> x_tmp;
+    base->evaluateHierarchicalFunctions(formCanonicalPoints(x, x_tmp, num_x), num_x, y);
+}
+void TasmanianSparseGrid::evaluateHierarchicalFunctions(const std::vector<float> &x, std::vector<float> &y) const{
+    int num_points = getNumPoints();
+    size_t num_x = x.size() / getNumDimensions();
+    size_t expected_size = num_points * num_x * (isFourier() ? 2 : 1);
+    y.resize(expected_size);
+    evaluateHierarchicalFunctions(x.data(), (int) num_x, y.data());
+}
 #ifdef Tasmanian_ENABLE_CUDA
 void TasmanianSparseGrid::evaluateHierarchicalFunctionsGPU(const double gpu_x[], int cpu_num_x, double gpu_y[]) const{
     if (isGlobal() || isWavelet()) throw std::runtime_error("ERROR: evaluateHierarchicalFunctionsGPU() is not available for Wavelet and Global grids.");
@@ -1354,7 +1439,12 @@ void TasmanianSparseGrid::writeAscii(std::ostream &ofs) const{
     ofs << "TASMANIAN SG end" << endl;
 }
 void TasmanianSparseGrid::writeBinary(std::ostream &ofs) const{
-    const char *TSG = "TSG5"; // last char indicates version (update only if necessary, no need to sync with getVersionMajor())
+    // last char indicates version (update only if necessary, no need to sync with getVersionMajor())
+    // version 6 is the mapped format, same as 5 but the large arrays are aligned
+    // version 7 is the chunked format, same as 5 but the large arrays are stored in separate blocks of the file
+    // version 8 is the compressed format, same as 5 but the surpluses and values are compressed and grouped by level
+    const char *TSG = (IO::getChunkedWriter(ofs) != nullptr) ? "TSG7" :
+                      ((IO::isMappedFormat(ofs)) ? "TSG6" : ((IO::isCompressedFormat(ofs)) ? "TSG8" : "TSG5"));
     ofs.write(TSG, 4 * sizeof(char)); // mark Tasmanian files
     char flag;
     // use Integers to indicate grid types, empty 'e', global 'g', sequence 's', pwpoly 'p', wavelet 'w', Fourier 'f'
@@ -1518,9 +1608,15 @@ void TasmanianSparseGrid::readBinary(std::istream &ifs){
     if ((TSG[0] != 'T') || (TSG[1] != 'S') || (TSG[2] != 'G')){
         throw std::runtime_error("ERROR: wrong binary file format, first 3 bytes are not 'TSG'");
     }
-    if (TSG[3] != '5'){
-        throw std::runtime_error("ERROR: wrong binary file format, version number is not '5'");
+    if ((TSG[3] != '5') && (TSG[3] != '6') && (TSG[3] != '7') && (TSG[3] != '8')){
+        throw std::runtime_error("ERROR: wrong binary file format, version number is not '5', '6', '7' or '8'");
+    }
+    if ((TSG[3] == '7') && (IO::getChunkedReader(ifs) == nullptr)){
+        throw std::runtime_error("ERROR: binary files in the chunked format (version '7') must be read with read(filename)");
     }
+    IO::setMappedFormat(ifs, (TSG[3] == '6'));
+    static const IO::CompressedFormat compressed_format = {0.0}; // the tolerance is not used when reading
+    IO::setCompressedFormat(ifs, (TSG[3] == '8') ? &compressed_format : nullptr);
     ifs.read(TSG.data(), sizeof(char)); // what type of grid is it?
     clear();
     if (TSG[0] == 'g'){
@@ -1582,6 +1678,7 @@ void TasmanianSparseGrid::readBinary(std::istream &ifs){
             throw std::runtime_error("ERROR: wrong binary file format, did not reach correct end of Tasmanian block");
         }
     }
+    IO::setMappedFormat(ifs, false);
 }
 
 void TasmanianSparseGrid::enableAcceleration(TypeAcceleration acc){
@@ -1603,6 +1700,15 @@ void TasmanianSparseGrid::enableAcceleration(TypeAcceleration acc){
 void TasmanianSparseGrid::favorSparseAcceleration(bool favor){
     if (isLocalPolynomial()) getGridLocalPolynomial()->setFavorSparse(favor);
 }
+void TasmanianSparseGrid::favorLevelSurpluses(bool favor){
+    if (isLocalPolynomial()) getGridLocalPolynomial()->setFavorLevelSurpluses(favor);
+}
+void TasmanianSparseGrid::enableSupportIndex(bool enable){
+    if (isLocalPolynomial()) getGridLocalPolynomial()->setSupportIndex(enable);
+}
+void TasmanianSparseGrid::enableInterleavedCoefficients(bool enable){
+    if (isFourier()) getGridFourier()->setInterleavedCoefficients(enable);
+}
 TypeAcceleration TasmanianSparseGrid::getAccelerationType() const{
     return acceleration;
 }
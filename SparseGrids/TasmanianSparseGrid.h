@@ -46,6 +46,10 @@ int tsgIsOpenMPEnabled();
 void tsgWrite(void *grid, const char* filename);
 void tsgWriteBinary(void *grid, const char* filename);
 int tsgRead(void *grid, const char* filename);
+void tsgWriteMapped(void *grid, const char* filename);
+void tsgWriteChunked(void *grid, const char* filename);
+void tsgWriteCompressed(void *grid, const char* filename, double tolerance);
+int tsgReadMapped(void *grid, const char* filename);
 void tsgMakeGlobalGrid(void *grid, int dimensions, int outputs, int depth, const char * sType, const char *sRule, const int *anisotropic_weights, double alpha, double beta, const char* custom_filename, const int *limit_levels);
 void tsgMakeSequenceGrid(void *grid, int dimensions, int outputs, int depth, const char *sType, const char *sRule, const int *anisotropic_weights, const int *limit_levels);
 void tsgMakeLocalPolynomialGrid(void *grid, int dimensions, int outputs, int depth, int order, const char *sRule, const int *limit_levels);
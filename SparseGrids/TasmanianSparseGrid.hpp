@@ -84,6 +84,41 @@ public:
     void write(std::ostream &ofs, bool binary = false) const;
     void read(std::istream &ifs, bool binary = false);
 
+    /*!
+     * \brief Write the grid in the mapped binary format, i.e., binary format with the large arrays aligned for use with \b readMapped().
+     *
+     * The file can also be read with \b read() (the data will be copied) but not with versions of Tasmanian prior to this one.
+     */
+    void writeMapped(const char *filename) const;
+    /*!
+     * \brief Read a grid from a file written with \b writeMapped(), the file is mapped into memory and the large arrays are not copied.
+     *
+     * The values and hierarchical coefficients of the grid are used directly from the read-only memory mapping,
+     * thus evaluations can start without reading the entire file and multiple processes that map the same file share the memory pages.
+     * The file must not be modified while the grid (or a copy of the grid) is in use.
+     * The grid remains fully functional, an operation that modifies the values or coefficients (e.g., loading values)
+     * will first make a private copy of the data.
+     * Files written in the regular binary format are also accepted, but then the data is copied.
+     */
+    void readMapped(const char *filename);
+    /*!
+     * \brief Write the grid in the chunked binary format, the large arrays are split into chunks written by multiple threads.
+     *
+     * The chunked format is intended for very large grids, e.g., checkpoints of grids with hundreds of millions of values.
+     * Each chunk, the header and the tables of the file have checksums that are verified when the file is read with \b read(const char*),
+     * the chunks are read in parallel; the threads are controlled by OpenMP.
+     */
+    void writeChunked(const char *filename) const;
+    /*!
+     * \brief Write the grid in the compressed binary format, the values and hierarchical coefficients are compressed and grouped by level.
+     *
+     * If the \b tolerance is zero, the compression is lossless and the grid read with \b read(const char*) is identical to this one.
+     * Otherwise, every stored value and coefficient is within the \b tolerance of the original (up to round-off error),
+     * the coefficients on the fine levels are usually much smaller than the tolerance and take a single byte or less.
+     * Throws \b std::invalid_argument if the \b tolerance is negative.
+     */
+    void writeCompressed(const char *filename, double tolerance = 0.0) const;
+
     void makeGlobalGrid(int dimensions, int outputs, int depth, TypeDepth type, TypeOneDRule rule,
                         std::vector<int> const &anisotropic_weights, double alpha = 0.0, double beta = 0.0,
                         const char* custom_filename = nullptr, std::vector<int> const &level_limits = std::vector<int>());
@@ -155,6 +190,8 @@ public:
     void evaluate(const double x[], double y[]) const; // has size num_dimensions, y has size num_outputs
     void evaluateBatch(std::vector<double> const &x, std::vector<double> &y) const;
     void evaluateBatch(const double x[], int num_x, double y[]) const; // uses acceleration, OpenMP, BLAS, GPU, etc., x is num_dimensions X num_x, y is num_outputs X num_x
+    void evaluateBatch(std::vector<float> const &x, std::vector<float> &y) const;
+    void evaluateBatch(const float x[], int num_x, float y[]) const; // single precision, uses OpenMP and BLAS (sgemm) with a float copy of the coefficients, accuracy is about 1.E-6
     void evaluateBatchGPU(const double gpu_x[], int cpu_num_x, double gpu_y[]) const; // both arrays sit on the cuda device
     void evaluateFast(std::vector<double> const &x, std::vector<double> &y) const{ evaluateBatch(x, y); }
     void evaluateFast(const double x[], double y[]) const{ evaluateBatch(x, 1, y); }; // evaluate that is potentially not thread safe!
@@ -229,10 +266,25 @@ public:
     std::vector<double> getCandidateConstructionPoints(double tolerance, TypeRefinement criteria, int output = -1,
                                                        std::vector<int> const &level_limits = std::vector<int>(),
                                                        std::vector<double> const &scale_correction = std::vector<double>());
-    //! \brief Add the value of a single point (if the tensor of the point is not complete, the grid will not be updated but the value will be stored)
+    /*!
+     * \brief Add the value of a single point (if the tensor of the point is not complete, the grid will not be updated but the value will be stored)
+     *
+     * For Global grids, the method can be called concurrently from multiple threads, e.g., when the results of remote model evaluations arrive asynchronously;
+     * the grid is fully updated once all concurrent calls return, no other method should be called in the mean time.
+     */
     void loadConstructedPoint(std::vector<double> const &x, std::vector<double> const &y);
     //! \brief Same as \b loadConstructedPoint() but using arrays in place of vectors (array size is not checked)
     void loadConstructedPoint(const double x[], const double y[]);
+    /*!
+     * \brief Add the values of a batch of points, the points are converted to indexes in bulk and the grid is updated with a single merge.
+     *
+     * Equivalent to calling \b loadConstructedPoint() for each point but avoids rebuilding the grid data structures after every point;
+     * \b x has size \b getNumDimensions() times \b num_x and \b y has size \b getNumOutputs() times \b num_x.
+     * If a point appears more than once in the batch, the last value is used.
+     */
+    void loadConstructedPoints(std::vector<double> const &x, std::vector<double> const &y);
+    //! \brief Same as \b loadConstructedPoints() but using arrays in place of vectors (array size is not checked)
+    void loadConstructedPoints(const double x[], int num_x, const double y[]);
     //! \brief End the procedure, clears flags and unused constructed points, can go back to using regular refinement
     void finishConstruction();
 
@@ -247,6 +299,8 @@ public:
         return y;
     }
     void evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const;
+    void evaluateHierarchicalFunctions(std::vector<float> const &x, std::vector<float> &y) const;
+    void evaluateHierarchicalFunctions(const float x[], int num_x, float y[]) const; // the basis is computed in double precision and rounded
 
     void evaluateSparseHierarchicalFunctions(const std::vector<double> &x, std::vector<int> &pntr, std::vector<int> &indx, std::vector<double> &vals) const;
 
@@ -256,6 +310,9 @@ public:
 
     void enableAcceleration(TypeAcceleration acc);
     void favorSparseAcceleration(bool favor);
+    void favorLevelSurpluses(bool favor); // local polynomial grids only, compute the surpluses one level at a time with batched evaluations (true) or by walking the graph of parents (false), works the same way as favorSparseAcceleration()
+    void enableSupportIndex(bool enable); // local polynomial grids only, use an index instead of the tree to find the supported basis functions
+    void enableInterleavedCoefficients(bool enable); // Fourier grids only, store the real and imaginary parts of each coefficient together, changes the order (but not the values) of getHierarchicalCoefficients() and setHierarchicalCoefficients(), kept by copies but reset by read()
     TypeAcceleration getAccelerationType() const;
     static bool isAccelerationAvailable(TypeAcceleration acc);
 
@@ -310,6 +367,7 @@ protected:
     void mapConformalWeights(int num_dimensions, int num_points, double weights[]) const;
 
     const double* formCanonicalPoints(const double *x, Data2D<double> &x_temp, int num_x) const;
+    const double* formCanonicalPoints(const float *x, Data2D<double> &x_temp, int num_x) const;
     #ifdef Tasmanian_ENABLE_CUDA
     const double* formCanonicalPointsGPU(const double *gpu_x, int num_x, CudaVector<double> &gpu_x_temp) const;
     #endif
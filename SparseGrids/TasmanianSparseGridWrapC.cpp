@@ -53,6 +53,20 @@ int tsgIsOpenMPEnabled(){ return (TasmanianSparseGrid::isOpenMPEnabled()) ? 1 :
 
 void tsgWrite(void *grid, const char* filename){ ((TasmanianSparseGrid*) grid)->write(filename); }
 void tsgWriteBinary(void *grid, const char* filename){ ((TasmanianSparseGrid*) grid)->write(filename, true); }
+void tsgWriteMapped(void *grid, const char* filename){ ((TasmanianSparseGrid*) grid)->writeMapped(filename); }
+void tsgWriteChunked(void *grid, const char* filename){ ((TasmanianSparseGrid*) grid)->writeChunked(filename); }
+void tsgWriteCompressed(void *grid, const char* filename, double tolerance){ ((TasmanianSparseGrid*) grid)->writeCompressed(filename, tolerance); }
+int tsgReadMapped(void *grid, const char* filename){
+    try{
+        ((TasmanianSparseGrid*) grid)->readMapped(filename);
+        return 1;
+    }catch(std::runtime_error &e){
+        #ifndef NDEBUG
+        cerr << e.what() << endl;
+        #endif // NDEBUG
+        return 0;
+    }
+}
 int tsgRead(void *grid, const char* filename){
     try{
         ((TasmanianSparseGrid*) grid)->read(filename);
@@ -355,6 +369,9 @@ void tsgGetCandidateConstructionPointsPythonDeleteVect(void *vecx){ delete ((std
 void tsgLoadConstructedPoint(void *grid, const double *x, const double *y){
     ((TasmanianSparseGrid*) grid)->loadConstructedPoint(x, y);
 }
+void tsgLoadConstructedPoints(void *grid, const double *x, int num_x, const double *y){
+    ((TasmanianSparseGrid*) grid)->loadConstructedPoints(x, num_x, y);
+}
 void tsgFinishConstruction(void *grid){
     ((TasmanianSparseGrid*) grid)->finishConstruction();
 }
@@ -45,6 +45,8 @@
 #include <random>
 #include <deque>
 #include <cctype>
+#include <clocale>
+#include <limits>
 
 #include "TasmanianSparseGrid.hpp"
 
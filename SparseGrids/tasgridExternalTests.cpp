@@ -860,7 +860,20 @@ bool ExternalTester::testDynamicRefinement(const BaseFunction *f, TasmanianSpars
         for(size_t i=0; i<num_points; i++) pindex[i] = i;
         std::shuffle(pindex.begin(), pindex.end(), park_miller);
 
-        for(auto i : pindex){
+        if (itr % 2 == 1){ // every other iteration loads the whole batch at once
+            std::vector<double> x(num_points * dims), y(num_points * outs);
+            for(size_t k=0; k<num_points; k++){
+                std::copy_n(&(points[pindex[k] * dims]), dims, &(x[k * dims]));
+                f->eval(&(x[k * dims]), &(y[k * outs]));
+            }
+            grid->loadConstructedPoints(x, y);
+            num_points = 0;
+        }
+
+        // global grids accept the points from multiple threads
+        #pragma omp parallel for if(grid->isGlobal())
+        for(int k=0; k<(int) num_points; k++){
+            size_t i = pindex[k];
             std::vector<double> x(&(points[i * dims]), &(points[i * dims]) + dims);
             std::vector<double> y(outs);
             f->eval(x.data(), y.data());
@@ -1713,6 +1726,36 @@ bool ExternalTester::testAcceleration(const BaseFunction *f, TasmanianSparseGrid
             grid->printStats();
         }
 
+        //cout << "Testing single precision evaluations" << endl;
+        std::vector<float> xf(x.begin(), x.end()), yf;
+        grid->evaluateBatch(xf, yf);
+
+        double scale = 1.0;
+        for(auto b : baseline_y) scale = std::max(scale, std::abs(b));
+        err = 0.0;
+        for(int i=0; i<outs*num_x; i++) if (std::abs(yf[i] - baseline_y[i]) > err) err = std::abs(yf[i] - baseline_y[i]);
+
+        if (err > 1.E-4 * scale){
+            pass = false;
+            cout << "Failed single precision evaluation for acceleration c = " << c << " gpuID = " << testGpuID << endl;
+            cout << "Observed error: " << err << " for function: " << f->getDescription() << endl;
+            grid->printStats();
+        }
+
+        if (c == 0){
+            std::vector<double> hier;
+            std::vector<float> hierf;
+            grid->evaluateHierarchicalFunctions(std::vector<double>(x.begin(), x.begin() + num_fast * dims), hier);
+            grid->evaluateHierarchicalFunctions(std::vector<float>(xf.begin(), xf.begin() + num_fast * dims), hierf);
+            err = (hier.size() == hierf.size()) ? 0.0 : 1.0;
+            for(size_t i=0; i<std::min(hier.size(), hierf.size()); i++) err = std::max(err, std::abs(hier[i] - hierf[i]) / std::max(1.0, std::abs(hier[i])));
+            if (err > 1.E-4){
+                pass = false;
+                cout << "Failed single precision hierarchical functions, observed error: " << err << " for function: " << f->getDescription() << endl;
+                grid->printStats();
+            }
+        }
+
         if (c > 1){ // gpu test
             if (gpuid == -1){ // gpuid is not set, then cycle trough all GPUs
                 testGpuID++;
@@ -2034,6 +2077,60 @@ bool ExternalTester::testAllAcceleration() const{
     grid.makeLocalPolynomialGrid(f1out->getNumInputs(), f1out->getNumOutputs(), 5, 2, TasGrid::rule_semilocalp);
     grid.favorSparseAcceleration(false);
     pass = pass && testAcceleration(f1out, &grid);
+    { // many outputs use the tiled sparse kernel and the dense/sparse cost model
+        int num_outputs = 4200, num_x = 70;
+        grid.makeLocalPolynomialGrid(3, num_outputs, 4, 1, TasGrid::rule_localp);
+        std::vector<double> vals(Utils::size_mult(num_outputs, grid.getNumNeeded()));
+        for(size_t i=0; i<vals.size(); i++) vals[i] = std::sin(0.01 * (double) i);
+        grid.loadNeededPoints(vals);
+        std::vector<double> x(3 * num_x), baseline_y(Utils::size_mult(num_outputs, num_x)), test_y;
+        setRandomX((int) x.size(), x.data());
+        for(int i=0; i<num_x; i++) grid.evaluate(&(x[3*i]), &(baseline_y[Utils::size_mult(i, num_outputs)]));
+        for(auto acc : {TasGrid::accel_none, TasGrid::accel_cpu_blas}){
+            grid.enableAcceleration(acc);
+            for(int favor=0; favor<3; favor++){ // auto, sparse, dense
+                if (favor == 1) grid.favorSparseAcceleration(true);
+                if (favor == 2){ grid.favorSparseAcceleration(false); grid.favorSparseAcceleration(false); }
+                grid.evaluateBatch(x, test_y);
+                double err = 0.0;
+                for(size_t i=0; i<baseline_y.size(); i++) err = std::max(err, std::abs(test_y[i] - baseline_y[i]));
+                if (err > 1.E-11){
+                    cout << "Failed local polynomial evaluations with many outputs, acceleration " << AccelerationMeta::getIOAccelerationString(acc) << " favor " << favor << endl;
+                    pass = false;
+                }
+            }
+            grid.favorSparseAcceleration(true); // back to auto
+        }
+    }
+    for(auto rule : {TasGrid::rule_localp, TasGrid::rule_semilocalp, TasGrid::rule_localp0, TasGrid::rule_localpb}){
+        for(int order=0; order<3; order++){ // the support index must find the same basis functions as the tree
+            if ((order == 0) && (rule != TasGrid::rule_localp)) continue;
+            grid.makeLocalPolynomialGrid(3, 2, 4, order, rule);
+            grid.enableSupportIndex(true);
+            for(int iteration=0; iteration<2; iteration++){ // second iteration checks the index after refinement
+                std::vector<double> pnts = grid.getNeededPoints(), vals(2 * grid.getNumNeeded());
+                for(int i=0; i<grid.getNumNeeded(); i++){
+                    vals[2*i]   = std::exp(pnts[3*i] + 0.5 * pnts[3*i+1] * pnts[3*i+2]);
+                    vals[2*i+1] = std::cos(pnts[3*i] - pnts[3*i+2]);
+                }
+                if (grid.getNumNeeded() > 0) grid.loadNeededPoints(vals);
+                if (iteration == 0) grid.setSurplusRefinement(1.E-3, TasGrid::refine_classic, 0);
+            }
+            int num_x = 300;
+            std::vector<double> x(3 * num_x), index_y, tree_y;
+            setRandomX((int) x.size(), x.data());
+            x[0] = 1.0; x[1] = -1.0; x[2] = 0.5; // points on the edges of the supports
+            grid.evaluateBatch(x, index_y);
+            grid.enableSupportIndex(false);
+            grid.evaluateBatch(x, tree_y);
+            double err = 0.0;
+            for(size_t i=0; i<tree_y.size(); i++) err = std::max(err, std::abs(index_y[i] - tree_y[i]));
+            if (err > 1.E-12){
+                cout << "Failed local polynomial support index, rule " << TasGrid::IO::getRuleString(rule) << " order " << order << " error " << err << endl;
+                pass = false;
+            }
+        }
+    }
     if (pass){
         if (verbose) cout << "      Accelerated" << setw(wsecond) << "local polynomial" << setw(wthird) << "Pass" << endl;
     }else{
@@ -2044,6 +2141,9 @@ bool ExternalTester::testAllAcceleration() const{
     pass = pass && testAcceleration(f, &grid);
     grid.makeFourierGrid(f1out->getNumInputs(), f1out->getNumOutputs(), 4, TasGrid::type_level);
     pass = pass && testAcceleration(f1out, &grid);
+    grid.makeFourierGrid(f->getNumInputs(), f->getNumOutputs(), 4, TasGrid::type_level);
+    grid.enableInterleavedCoefficients(true);
+    pass = pass && testAcceleration(f, &grid);
     if (pass){
         if (verbose) cout << "      Accelerated" << setw(wsecond) << "fourier" << setw(wthird) << "Pass" << endl;
     }else{
@@ -112,7 +112,7 @@ bool GridUnitTester::testAllException(){
     pass = true;
 
     // perform std::runtime_error tests
-    for(int i=0; i<41; i++){
+    for(int i=0; i<43; i++){
         try{
             runtimeErrorCall(i);
             cout << "Missed run exception i = " << i << " see GridUnitTester::runtimeErrorCall()" << endl;
@@ -273,6 +273,9 @@ void GridUnitTester::runtimeErrorCall(int i){
     case 39: custom.read(ExternalTester::findGaussPattersonTable()); custom.getIExact(11); break;
     case 40: custom.read(ExternalTester::findGaussPattersonTable()); custom.getQExact(11); break;
 
+    case 41: grid.makeLocalPolynomialGrid(2, 1, 3); grid.beginConstruction(); grid.loadConstructedPoints(std::vector<double>() = {0.3, 0.0}, std::vector<double>() = {1.0}); break; // x is not a node
+    case 42: grid.makeLocalPolynomialGrid(2, 1, 3); grid.beginConstruction(); grid.loadConstructedPoints(std::vector<double>() = {0.0, 1.5}, std::vector<double>() = {1.0}); break; // x is outside of the domain
+
     default: break;
     }
 }
@@ -386,6 +389,477 @@ bool GridUnitTester::testAPIconsistency(){
     if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "level limits" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
     passAll = pass && passAll;
 
+    // test the mapped file format, the mapped grid must match the original and must allow modifications
+    pass = true;
+    grid.makeLocalPolynomialGrid(2, 1, 4, 2);
+    gridLoadEN2(&grid);
+    grid.writeMapped("testSaveMapped");
+    {
+        TasmanianSparseGrid mapped, copied;
+        mapped.readMapped("testSaveMapped");
+        copied = mapped;
+        std::vector<double> vya, vyb, vyc;
+        grid.evaluate(x, vya);
+        mapped.evaluate(x, vyb);
+        copied.evaluate(x, vyc);
+        pass = pass && doesMatch(vya, vyb, 0.0) && doesMatch(vya, vyc, 0.0);
+
+        grid.setSurplusRefinement(1.E-4, refine_classic);
+        mapped.setSurplusRefinement(1.E-4, refine_classic);
+        gridLoadEN2(&grid);
+        gridLoadEN2(&mapped);
+        grid.evaluate(x, vya);
+        mapped.evaluate(x, vyb);
+        pass = pass && doesMatch(vya, vyb, 0.0) && (mapped.getNumPoints() == grid.getNumPoints()) && (copied.getNumPoints() < grid.getNumPoints());
+
+        // the const accessors of a view must read the external data
+        std::vector<double> external = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+        Data2D<double> const view(2, 3, external.data(), std::shared_ptr<void const>());
+        pass = pass && view.isView() && (view.getTotalEntries() == external.size());
+        for(int i=0; i<3; i++)
+            pass = pass && (view.getStrip(i) == external.data() + 2 * i) && std::equal(view.getIStrip(i), view.getIStrip(i) + 2, external.begin() + 2 * i);
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "mapped file" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the chunked file format, use enough outputs so that the values are stored in separate chunks
+    pass = true;
+    grid.makeLocalPolynomialGrid(2, 64, 5, 2);
+    gridLoadEN2(&grid);
+    grid.setSurplusRefinement(1.E-4, refine_classic);
+    grid.writeChunked("testSaveChunked");
+    {
+        TasmanianSparseGrid chunked;
+        chunked.read("testSaveChunked");
+        std::vector<double> vya, vyb;
+        grid.evaluate(x, vya);
+        chunked.evaluate(x, vyb);
+        pass = pass && doesMatch(vya, vyb, 0.0) && (chunked.getNumPoints() == grid.getNumPoints()) && (chunked.getNumNeeded() == grid.getNumNeeded());
+
+        // damaged files must throw, flip a byte in the arrays, the header, the tables, or truncate the file
+        std::string file_data;
+        {
+            std::ifstream ifs("testSaveChunked", std::ios::in | std::ios::binary);
+            std::stringstream ss;
+            ss << ifs.rdbuf();
+            file_data = ss.str();
+        }
+        for(int damage=0; damage<4; damage++){
+            std::string bad = file_data;
+            if (damage == 0) bad[bad.size() - 8] ^= 1; // the values and surpluses are the last arrays
+            if (damage == 1) bad[12] ^= 1; // the number of arrays
+            if (damage == 2) bad[4 + 6 * sizeof(unsigned long long)] ^= 1; // the offset of the first array
+            if (damage == 3) bad.resize(bad.size() / 2);
+            {
+                std::ofstream ofs("testSaveChunkedBad", std::ios::out | std::ios::binary | std::ios::trunc);
+                ofs.write(bad.data(), bad.size());
+            }
+            try{
+                chunked.read("testSaveChunkedBad");
+                pass = false;
+            }catch(std::runtime_error &){}
+        }
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "chunked file" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the compressed file format, lossless must match exactly and lossy must keep the coefficients within the tolerance
+    pass = true;
+    grid.makeLocalPolynomialGrid(2, 3, 6, 2);
+    gridLoadEN2(&grid);
+    grid.setSurplusRefinement(1.E-4, refine_classic);
+    grid.writeCompressed("testSaveCompressed");
+    {
+        TasmanianSparseGrid compressed;
+        compressed.read("testSaveCompressed");
+        std::vector<double> vya, vyb;
+        grid.evaluate(x, vya);
+        compressed.evaluate(x, vyb);
+        pass = pass && doesMatch(vya, vyb, 0.0) && (compressed.getNumPoints() == grid.getNumPoints()) && (compressed.getNumNeeded() == grid.getNumNeeded());
+
+        double tolerance = 1.E-6;
+        grid.writeCompressed("testSaveCompressed", tolerance);
+        compressed.read("testSaveCompressed");
+        size_t num_coeffs = (size_t) grid.getNumPoints() * (size_t) grid.getNumOutputs();
+        double const *ca = grid.getHierarchicalCoefficients();
+        double const *cb = compressed.getHierarchicalCoefficients();
+        for(size_t i=0; i<num_coeffs; i++)
+            if (std::abs(ca[i] - cb[i]) > tolerance) pass = false;
+
+        // large values with tight tolerance, the bound must hold and the block must not grow past the lossless size
+        std::vector<double> large(100000);
+        for(size_t i=0; i<large.size(); i++) large[i] = 1.E+4 * std::sin(0.37 * (double) i + 0.1);
+        for(auto tol : std::vector<double>{1.E-6, 1.E-12, 1.E-14}){
+            std::stringstream ss;
+            IO::writeCompressedBlock(large.data(), large.size(), tol, ss);
+            std::string block = ss.str();
+            std::vector<double> lread(large.size());
+            IO::readCompressedBlock(ss, large.size(), lread.data());
+            for(size_t i=0; i<large.size(); i++)
+                if (std::abs(large[i] - lread[i]) > tol) pass = false;
+            if (block.size() > large.size() * sizeof(double) + 64) pass = false;
+        }
+
+        // damaged sizes must be rejected with the file format error, before any memory is allocated
+        auto rejects = [](std::string const &bytes, std::function<void(std::istream &)> reader)->bool{
+            std::stringstream ss(bytes);
+            try{
+                reader(ss);
+            }catch(std::runtime_error &){
+                return true;
+            }
+            return false;
+        };
+        std::vector<double> small = {1.0, 2.0, 3.0, 4.0}, sread(small.size());
+        for(auto tol : std::vector<double>{0.0, 1.E-3}){
+            std::stringstream ss;
+            IO::writeCompressedBlock(small.data(), small.size(), tol, ss);
+            std::string block = ss.str();
+            size_t sizes_offset = (block[0] == 'q') ? 1 + sizeof(double) : 1;
+            for(size_t s=0; s<2; s++){
+                std::string damaged = block;
+                unsigned long long huge = 1ULL << 60;
+                std::copy_n(reinterpret_cast<char const*>(&huge), sizeof(unsigned long long), &damaged[sizes_offset + s * sizeof(unsigned long long)]);
+                pass = pass && rejects(damaged, [&](std::istream &is)->void{ IO::readCompressedBlock(is, small.size(), sread.data()); });
+            }
+            pass = pass && rejects(block.substr(0, block.size() - 1), [&](std::istream &is)->void{ IO::readCompressedBlock(is, small.size(), sread.data()); });
+        }
+        for(int num_levels : {-1, 1 << 30}){
+            std::stringstream ss;
+            IO::writeNumbers<false, IO::pad_none>(ss, num_levels);
+            pass = pass && rejects(ss.str(), [&](std::istream &is)->void{ IO::readLevelArray(is, 1, small.size(), std::vector<int>(), sread.data()); });
+        }
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "compressed file" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the ascii numbers, the shortest format must read back exactly in both the stream and the parallel parser
+    pass = true;
+    {
+        std::vector<double> vals = {0.0, -0.0, 0.1, 0.3, -3.5, 25.0, 1.E+16, 1.E+17, 1.E-5, 1.E-6, 1.E+23,
+                                    5.E-324, 2.2250738585072014E-308, 1.7976931348623157E+308, 1.0 / 3.0};
+        for(int i=1; i<1000; i++) vals.push_back(std::sin(0.1 * i) * std::pow(10.0, (i % 61) - 30));
+        std::stringstream ss;
+        IO::writeVector<true, IO::pad_line>(vals, ss);
+        std::string text = ss.str();
+        std::vector<double> vread(vals.size()), vparsed(vals.size());
+        IO::readVector<true>(ss, vread);
+        size_t num_parsed = IO::parseAsciiArray(text.c_str(), vals.size(), vparsed.data());
+        pass = pass && (vread == vals) && (vparsed == vals) && (num_parsed == vals.size());
+        pass = pass && (IO::parseAsciiArray("1 2 x 4", 4, vparsed.data()) == 2); // stops at the first invalid token
+
+        { // long tokens must be read in full, the tail of the token cannot shift the following entries
+            std::string long_text = "0." + std::string(100, '0') + "1 " + std::string(100, '0') + "12.5 7";
+            std::vector<double> long_vals = {1.E-101, 12.5, 7.0}, long_read(3, 0.0), long_parsed(3, 0.0);
+            std::stringstream long_ss(long_text);
+            IO::readVector<true>(long_ss, long_read);
+            pass = pass && !long_ss.fail() && (long_read == long_vals);
+            pass = pass && (IO::parseAsciiArray(long_text.c_str(), 3, long_parsed.data()) == 3) && (long_parsed == long_vals);
+        }
+
+        // the decimal point of the file is always '.', even if the user selected a locale that uses ','
+        std::string old_locale = std::setlocale(LC_NUMERIC, nullptr);
+        for(auto name : {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR"}){
+            if (std::setlocale(LC_NUMERIC, name) != nullptr){
+                std::fill(vread.begin(), vread.end(), 0.0);
+                std::fill(vparsed.begin(), vparsed.end(), 0.0);
+                ss.clear();
+                ss.seekg(0);
+                IO::readVector<true>(ss, vread);
+                num_parsed = IO::parseAsciiArray(text.c_str(), vals.size(), vparsed.data());
+                pass = pass && (vread == vals) && (vparsed == vals) && (num_parsed == vals.size());
+                break;
+            }
+        }
+        std::setlocale(LC_NUMERIC, old_locale.c_str());
+
+        grid.makeLocalPolynomialGrid(2, 2, 4, 2);
+        gridLoadEN2(&grid);
+        grid.write("testSaveAscii", false);
+        TasmanianSparseGrid ascii_grid;
+        ascii_grid.read("testSaveAscii");
+        std::vector<double> vya, vyb;
+        grid.evaluate(x, vya);
+        ascii_grid.evaluate(x, vyb);
+        pass = pass && doesMatch(vya, vyb, 0.0);
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "ascii numbers" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the hashed lookup in large multi-index sets, must match the binary search before and after modifying the set
+    pass = true;
+    {
+        MultiIndexSet mset = MultiIndexManipulations::generateLowerMultiIndexSet(4,
+                                [](std::vector<int> const &index)->bool{ return (index[0] + index[1] + index[2] + index[3] <= 12); });
+        auto check_slots = [&](MultiIndexSet const &cset)->bool{
+            bool match = true;
+            for(int i=0; i<cset.getNumIndexes(); i++) // makes enough lookups to trigger the hash
+                if (cset.getSlot(cset.getIndex(i)) != i) match = false;
+            std::vector<int> missing = {0, 0, 0, 13};
+            return match && (cset.getSlot(missing) == -1);
+        };
+        pass = pass && check_slots(mset);
+        mset.addSortedIndexes(std::vector<int>{13, 0, 0, 0});
+        pass = pass && check_slots(mset) && (mset.getSlot(std::vector<int>{13, 0, 0, 0}) == mset.getNumIndexes() - 1);
+        mset.removeIndex(std::vector<int>{13, 0, 0, 0});
+        pass = pass && check_slots(mset);
+        MultiIndexSet mcopy = mset;
+        pass = pass && check_slots(mcopy);
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "hashed lookup" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the interleaved Fourier coefficients, the evaluations and the files must not depend on the layout
+    pass = true;
+    {
+        grid.makeFourierGrid(2, 2, 4, type_level);
+        gridLoadEN2(&grid);
+        size_t num_coeffs = 2 * ((size_t) grid.getNumPoints()) * ((size_t) grid.getNumOutputs());
+        std::vector<double> coeffs(grid.getHierarchicalCoefficients(), grid.getHierarchicalCoefficients() + num_coeffs);
+        std::vector<double> xf = {0.13, 0.71, 0.52, 0.33, 0.91, 0.08}, vya, vyb, vsingle;
+        grid.evaluateBatch(xf, vya);
+
+        grid.enableInterleavedCoefficients(true);
+        grid.evaluateBatch(xf, vyb);
+        grid.evaluate(std::vector<double>(xf.begin(), xf.begin() + 2), vsingle);
+        pass = pass && doesMatch(vya, vyb, 1.E-12) && doesMatch(std::vector<double>(vya.begin(), vya.begin() + 2), vsingle, 1.E-12);
+
+        grid.write("testSaveInterleaved", true);
+        TasmanianSparseGrid fourier;
+        fourier.read("testSaveInterleaved"); // reading resets the layout
+        pass = pass && std::equal(coeffs.begin(), coeffs.end(), fourier.getHierarchicalCoefficients());
+
+        // the set must accept the layout returned by get, the round trip cannot change the grid
+        std::vector<double> interleaved_coeffs(grid.getHierarchicalCoefficients(), grid.getHierarchicalCoefficients() + num_coeffs);
+        pass = pass && !std::equal(coeffs.begin(), coeffs.end(), interleaved_coeffs.begin());
+        { // only the order changes, the real and imaginary parts must be the same in both layouts
+            size_t num_fpoints = (size_t) grid.getNumPoints(), num_fout = (size_t) grid.getNumOutputs();
+            for(size_t i=0; i<num_fpoints; i++){
+                for(size_t k=0; k<num_fout; k++){
+                    pass = pass && (coeffs[i * num_fout + k] == interleaved_coeffs[2 * i * num_fout + k]);
+                    pass = pass && (coeffs[(num_fpoints + i) * num_fout + k] == interleaved_coeffs[(2 * i + 1) * num_fout + k]);
+                }
+            }
+        }
+        grid.setHierarchicalCoefficients(interleaved_coeffs);
+        grid.evaluateBatch(xf, vyb);
+        pass = pass && doesMatch(vya, vyb, 1.E-12) && std::equal(interleaved_coeffs.begin(), interleaved_coeffs.end(), grid.getHierarchicalCoefficients());
+
+        TasmanianSparseGrid copied = grid; // the copy keeps the layout
+        pass = pass && std::equal(interleaved_coeffs.begin(), interleaved_coeffs.end(), copied.getHierarchicalCoefficients());
+        copied.evaluateBatch(xf, vyb);
+        pass = pass && doesMatch(vya, vyb, 1.E-12);
+
+        grid.enableInterleavedCoefficients(false);
+        pass = pass && std::equal(coeffs.begin(), coeffs.end(), grid.getHierarchicalCoefficients());
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "interleaved fourier" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the warm start of the wavelet solver, reloading the values or loading after refinement starts from the current coefficients
+    pass = true;
+    {
+        std::vector<double> xf = {0.13, 0.71, -0.52, 0.33, 0.91, -0.08}, vya, vyb;
+        TasmanianSparseGrid cold;
+        cold.makeWaveletGrid(2, 1, 2, 1);
+        gridLoadEN2(&cold);
+        cold.evaluateBatch(xf, vya);
+
+        auto exp_norm = [](std::vector<double> const &pnts)->std::vector<double>{
+            std::vector<double> vals(pnts.size() / 2);
+            for(size_t i=0; i<vals.size(); i++) vals[i] = std::exp(-pnts[2*i] * pnts[2*i] - pnts[2*i+1] * pnts[2*i+1]);
+            return vals;
+        };
+
+        grid.makeWaveletGrid(2, 1, 2, 1);
+        grid.loadNeededPoints(std::vector<double>((size_t) grid.getNumNeeded(), 1.0));
+        grid.loadNeededPoints(exp_norm(grid.getLoadedPoints())); // same points, warm start from the coefficients of the constant
+        grid.evaluateBatch(xf, vyb);
+        pass = pass && doesMatch(vya, vyb, 1.E-9);
+
+        grid.setSurplusRefinement(1.E-3, refine_classic);
+        pass = pass && (grid.getNumNeeded() > 0);
+        gridLoadEN2(&grid); // the new points start from zero coefficients
+        std::vector<double> points = grid.getLoadedPoints(), vals;
+        std::vector<double> loaded_values = exp_norm(points);
+        grid.evaluateBatch(points, vals);
+        pass = pass && doesMatch(loaded_values, vals, 1.E-9);
+
+        // the interpolation weights must reproduce the interpolant
+        for(size_t i=0; i<xf.size() / 2; i++){
+            std::vector<double> xi = {xf[2*i], xf[2*i+1]}, yi;
+            std::vector<double> weights = grid.getInterpolationWeights(xi);
+            grid.evaluate(xi, yi);
+            double sum = 0.0;
+            for(size_t j=0; j<weights.size(); j++) sum += weights[j] * loaded_values[j];
+            pass = pass && (std::abs(sum - yi[0]) < 1.E-9);
+        }
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "wavelet warm start" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the single precision copy of the coefficients, must follow an update that does not change the number of coefficients
+    pass = true;
+    {
+        std::vector<TasmanianSparseGrid> grids(5);
+        grids[0].makeGlobalGrid(2, 2, 4, type_level, rule_clenshawcurtis);
+        grids[1].makeSequenceGrid(2, 2, 4, type_level, rule_rleja);
+        grids[2].makeLocalPolynomialGrid(2, 2, 4, 2);
+        grids[3].makeWaveletGrid(2, 2, 2, 1);
+        grids[4].makeFourierGrid(2, 2, 3, type_level);
+        std::vector<float> xf = {0.13f, 0.71f, 0.52f, 0.33f, 0.91f, 0.08f};
+        for(auto &g : grids){
+            gridLoadEN2(&g);
+            std::vector<float> yf;
+            g.evaluateBatch(xf, yf); // makes the single precision copy
+            size_t num_coeffs = ((size_t) g.getNumPoints()) * ((size_t) g.getNumOutputs()) * ((g.isFourier()) ? 2 : 1);
+            std::vector<double> coeffs(g.getHierarchicalCoefficients(), g.getHierarchicalCoefficients() + num_coeffs);
+            for(auto &c : coeffs) c *= 2.0;
+            g.setHierarchicalCoefficients(coeffs);
+            std::vector<double> y;
+            g.evaluateBatch(std::vector<double>(xf.begin(), xf.end()), y);
+            g.evaluateBatch(xf, yf);
+            for(size_t i=0; i<y.size(); i++)
+                if (std::abs(y[i] - yf[i]) > 1.E-4 * std::max(1.0, std::abs(y[i]))) pass = false;
+        }
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "float coefficients" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the surpluses computed one level at a time against the default walk over the graph, also after refinement
+    pass = true;
+    {
+        std::vector<double> xr = {0.13, 0.71, -0.52, 0.33, 0.91, -0.08, -0.77, 0.45};
+        for(auto r : {rule_localp, rule_semilocalp, rule_localp0, rule_localpb}){
+            for(int ord : {1, 2, 3}){
+                TasmanianSparseGrid dag_grid, level_grid;
+                dag_grid.makeLocalPolynomialGrid(2, 2, 4, ord, r);
+                level_grid.makeLocalPolynomialGrid(2, 2, 4, ord, r);
+                dag_grid.favorLevelSurpluses(false); // force both algorithms, the defaults depend on the number of threads
+                level_grid.favorLevelSurpluses(true);
+                for(int iter=0; iter<2; iter++){
+                    gridLoadEN2(&dag_grid);
+                    gridLoadEN2(&level_grid);
+                    if (dag_grid.getNumPoints() != level_grid.getNumPoints()){ pass = false; break; }
+                    size_t num_coeffs = ((size_t) dag_grid.getNumPoints()) * ((size_t) dag_grid.getNumOutputs());
+                    std::vector<double> dag_coeffs(dag_grid.getHierarchicalCoefficients(), dag_grid.getHierarchicalCoefficients() + num_coeffs);
+                    pass = pass && doesMatch(dag_coeffs, level_grid.getHierarchicalCoefficients());
+                    std::vector<double> dag_y, level_y;
+                    dag_grid.evaluateBatch(xr, dag_y);
+                    level_grid.evaluateBatch(xr, level_y);
+                    pass = pass && doesMatch(dag_y, level_y);
+                    dag_grid.setSurplusRefinement(1.E-4, refine_classic, 0); // the next iteration loads the refined grid
+                    level_grid.setSurplusRefinement(1.E-4, refine_classic, 0);
+                }
+            }
+        }
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "level surpluses" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the incremental update of the surpluses after refinement against recomputing all surpluses, the results must be identical
+    pass = true;
+    {
+        std::vector<double> xr = {0.13, 0.71, -0.52, 0.33, 0.91, -0.08, -0.77, 0.45};
+        auto model = [](std::vector<double> const &pnts)->std::vector<double>{ // localized and anisotropic, the refinement adds points unevenly
+            std::vector<double> vals(pnts.size());
+            for(size_t i=0; i<pnts.size() / 2; i++){
+                vals[2*i]   = std::exp(-20.0 * (pnts[2*i] - 0.3) * (pnts[2*i] - 0.3) - 3.0 * (pnts[2*i+1] + 0.2) * (pnts[2*i+1] + 0.2));
+                vals[2*i+1] = pnts[2*i] * vals[2*i];
+            }
+            return vals;
+        };
+        for(auto criteria : {refine_classic, refine_parents_first, refine_fds}){
+            for(auto r : {rule_localp, rule_semilocalp, rule_localp0, rule_localpb}){
+                for(int ord : {1, 2, 3}){
+                    TasmanianSparseGrid inc_grid, full_grid;
+                    inc_grid.makeLocalPolynomialGrid(2, 2, 2, ord, r);
+                    full_grid.makeLocalPolynomialGrid(2, 2, 2, ord, r);
+                    inc_grid.favorLevelSurpluses(false); // the incremental update is used only when walking the graph
+                    full_grid.favorLevelSurpluses(false);
+                    for(int iter=0; iter<4; iter++){
+                        inc_grid.loadNeededPoints(model(inc_grid.getNeededPoints())); // after the first iteration, updates the surpluses incrementally
+                        full_grid.loadNeededPoints(model(full_grid.getNeededPoints()));
+                        full_grid.loadNeededPoints(model(full_grid.getLoadedPoints())); // reloading the values without new points recomputes all surpluses
+
+                        if (inc_grid.getNumPoints() != full_grid.getNumPoints()){ pass = false; break; }
+                        size_t num_coeffs = ((size_t) inc_grid.getNumPoints()) * ((size_t) inc_grid.getNumOutputs());
+                        std::vector<double> inc_coeffs(inc_grid.getHierarchicalCoefficients(), inc_grid.getHierarchicalCoefficients() + num_coeffs);
+                        pass = pass && doesMatch(inc_coeffs, full_grid.getHierarchicalCoefficients(), 0.0);
+                        std::vector<double> inc_y, full_y;
+                        inc_grid.evaluateBatch(xr, inc_y);
+                        full_grid.evaluateBatch(xr, full_y);
+                        pass = pass && doesMatch(inc_y, full_y, 0.0);
+                        // the classic refinement can skip parents, the next refinement may add the missing parents of existing points
+                        inc_grid.setSurplusRefinement(1.E-3, (iter == 0) ? refine_classic : criteria, -1);
+                        full_grid.setSurplusRefinement(1.E-3, (iter == 0) ? refine_classic : criteria, -1);
+                        if (inc_grid.getNumNeeded() == 0) break;
+                    }
+                }
+            }
+        }
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "incremental surpluses" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
+    // test the incremental update of the sequence surpluses against recomputing all surpluses, the results must be identical
+    pass = true;
+    {
+        std::vector<double> xr = {0.13, 0.71, -0.52, 0.33, 0.91, -0.08, -0.77, 0.45};
+        auto model = [](std::vector<double> const &pnts)->std::vector<double>{ // anisotropic, the refinement adds points unevenly
+            std::vector<double> vals(pnts.size());
+            for(size_t i=0; i<pnts.size() / 2; i++){
+                vals[2*i]   = std::exp(-2.0 * (pnts[2*i] - 0.3) * (pnts[2*i] - 0.3) - 0.5 * (pnts[2*i+1] + 0.2) * (pnts[2*i+1] + 0.2));
+                vals[2*i+1] = std::cos(pnts[2*i] + 0.1 * pnts[2*i+1]);
+            }
+            return vals;
+        };
+        for(auto r : {rule_rleja, rule_leja, rule_mindelta, rule_rlejashifted}){
+            TasmanianSparseGrid inc_grid, full_grid;
+            inc_grid.makeSequenceGrid(2, 2, 2, type_level, r);
+            full_grid.makeSequenceGrid(2, 2, 2, type_level, r);
+            int num_refined = 0; // number of rounds that loaded new points into the existing grid
+            for(int iter=0; iter<5; iter++){
+                inc_grid.loadNeededPoints(model(inc_grid.getNeededPoints())); // after the first iteration, updates the surpluses incrementally
+                full_grid.loadNeededPoints(model(full_grid.getNeededPoints()));
+                full_grid.loadNeededPoints(model(full_grid.getLoadedPoints())); // reloading the values without new points recomputes all surpluses
+
+                if (inc_grid.getNumPoints() != full_grid.getNumPoints()){ pass = false; break; }
+                size_t num_coeffs = ((size_t) inc_grid.getNumPoints()) * ((size_t) inc_grid.getNumOutputs());
+                std::vector<double> inc_coeffs(inc_grid.getHierarchicalCoefficients(), inc_grid.getHierarchicalCoefficients() + num_coeffs);
+                pass = pass && doesMatch(inc_coeffs, full_grid.getHierarchicalCoefficients(), 0.0);
+                std::vector<double> inc_y, full_y;
+                inc_grid.evaluateBatch(xr, inc_y);
+                full_grid.evaluateBatch(xr, full_y);
+                pass = pass && doesMatch(inc_y, full_y, 0.0);
+                // alternate between the surplus and the anisotropic refinement
+                if (iter % 2 == 0){
+                    inc_grid.setSurplusRefinement(1.E-4, -1);
+                    full_grid.setSurplusRefinement(1.E-4, -1);
+                }else{
+                    inc_grid.setAnisotropicRefinement(type_iptotal, 5, 0);
+                    full_grid.setAnisotropicRefinement(type_iptotal, 5, 0);
+                }
+                if (inc_grid.getNumNeeded() == 0) break;
+                num_refined++;
+            }
+            pass = pass && (num_refined >= 2);
+        }
+    }
+
+    if (verbose) cout << setw(wfirst) << "API variation" << setw(wsecond) << "sequence surpluses" << setw(wthird) << ((pass) ? "Pass" : "FAIL") << endl;
+    passAll = pass && passAll;
+
     // test integer-to-enumerate and string-to-enumerate conversion
     pass = true;
     std::vector<TypeAcceleration> allacc = {accel_none, accel_cpu_blas, accel_gpu_default, accel_gpu_cublas, accel_gpu_cuda, accel_gpu_magma};
@@ -884,7 +884,6 @@ Data2D<double> readMatrixFromOpen(std::istream &is){
 }
 
 Data2D<double> TasgridWrapper::readMatrix(std::string const &filename){
-    constexpr bool use_ascii = true;
     constexpr bool use_binary = false;
     Data2D<double> matrix;
     if (filename.empty()) return matrix;
@@ -899,10 +898,28 @@ Data2D<double> TasgridWrapper::readMatrix(std::string const &filename){
     ifs.read(tsg, 3*sizeof(char));
     if ((tsg[0] == 'T') && (tsg[1] == 'S') && (tsg[2] == 'G')){
         matrix = readMatrixFromOpen<use_binary>(ifs);
-    }else{ // not a binary file
-        ifs.close();
-        ifs.open(filename);
-        matrix = readMatrixFromOpen<use_ascii>(ifs);
+    }else{ // not a binary file, read the text at once and parse with multiple threads
+        ifs.clear(); // files with fewer than 3 bytes set the fail bit
+        ifs.seekg(0, std::ios::end);
+        std::streamoff text_size = ifs.tellg();
+        std::string text((text_size > 0) ? (size_t) text_size : 0, '\0');
+        ifs.seekg(0);
+        if (!text.empty()) ifs.read(&text[0], (std::streamsize) text.size());
+        char const *c = text.c_str();
+        char *end = nullptr;
+        long rows = std::strtol(c, &end, 10);
+        c = end;
+        long cols = std::strtol(c, &end, 10);
+        // each entry takes at least one byte of the file, larger headers are incorrect and could overflow the size of the matrix
+        if (rows > 0 && cols > 0 && ((rows > std::numeric_limits<int>::max()) || (cols > std::numeric_limits<int>::max()) || (rows > (long) (text.size() / (size_t) cols)))){
+            cerr << "ERROR: file " << filename << " has an incorrect header, cannot have " << rows << " by " << cols << " entries" << endl;
+        }else if (rows > 0 && cols > 0){
+            matrix = Data2D<double>((int) cols, (int) rows);
+            if (IO::parseAsciiArray(end, matrix.getTotalEntries(), matrix.getStrip(0)) < matrix.getTotalEntries()){
+                cerr << "ERROR: file " << filename << " has fewer than " << rows << " by " << cols << " entries" << endl;
+                matrix = Data2D<double>();
+            }
+        }
     }
     if (matrix.empty())
         cerr << "WARNING: empty file " << filename << endl;
@@ -911,22 +928,11 @@ Data2D<double> TasgridWrapper::readMatrix(std::string const &filename){
 }
 void TasgridWrapper::writeMatrix(std::string const &filename, int rows, int cols, const double mat[]) const{
     if (filename.empty()) return;
-    size_t cols_t = (size_t) cols;
     std::ofstream ofs;
     if (useASCII){
-        Utils::Wrapper2D<const double> matrix(cols, mat);
         ofs.open(filename);
         ofs << rows << " " << cols << endl;
-        ofs.precision(17);
-        ofs << std::scientific;
-        for(int i=0; i<rows; i++){
-            double const * r = matrix.getStrip(i);
-            ofs << setw(25) << r[0];
-            for(size_t j=1; j<cols_t; j++){
-                ofs << " " << setw(25) << r[j];
-            }
-            ofs << "\n";
-        }
+        IO::writeAsciiMatrix(ofs, (size_t) rows, (size_t) cols, mat);
     }else{
         ofs.open(filename, std::ios::out | std::ios::binary);
         char tsg[3] = {'T', 'S', 'G'};
@@ -940,22 +946,19 @@ void TasgridWrapper::writeMatrix(std::string const &filename, int rows, int cols
 void TasgridWrapper::printMatrix(int rows, int cols, const double mat[], bool isComplex) const{
     if (!printCout) return;
     cout << rows << " " << cols << endl;
-    cout.precision(17);
-    cout << std::scientific;
-    size_t cols_t = (size_t) cols;
-    Utils::Wrapper2D<const double> matrix(cols, mat);
-    for(int i=0; i<rows; i++){
-        double const * r = matrix.getStrip(i);
-        if (isComplex){
-            cout << setw(50) << std::complex<double>(r[0], r[1]);
-            for(size_t j=1; j<cols_t; j++)
+    if (isComplex){
+        cout.precision(17);
+        cout << std::scientific;
+        size_t cols_t = (size_t) cols;
+        Utils::Wrapper2D<const double> matrix(2 * cols, mat);
+        for(int i=0; i<rows; i++){
+            double const * r = matrix.getStrip(i);
+            for(size_t j=0; j<cols_t; j++)
                 cout << setw(50) << std::complex<double>(r[2*j], r[2*j + 1]);
-        }else{
-            cout << setw(25) << r[0];
-            for(size_t j=1; j<cols_t; j++)
-                cout << " " << setw(25) << r[j];
+            cout << '\n';
         }
-        cout << '\n';
+    }else{
+        IO::writeAsciiMatrix(cout, (size_t) rows, (size_t) cols, mat, 25); // padded so that the columns line up on the screen
     }
     cout << endl;
 }
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2017, Miroslav Stoyanov
+ *
+ * This file is part of
+ * Toolkit for Adaptive Stochastic Modeling And Non-Intrusive ApproximatioN: TASMANIAN
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ *    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * UT-BATTELLE, LLC AND THE UNITED STATES GOVERNMENT MAKE NO REPRESENTATIONS AND DISCLAIM ALL WARRANTIES, BOTH EXPRESSED AND IMPLIED.
+ * THERE ARE NO EXPRESS OR IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, OR THAT THE USE OF THE SOFTWARE WILL NOT INFRINGE ANY PATENT,
+ * COPYRIGHT, TRADEMARK, OR OTHER PROPRIETARY RIGHTS, OR THAT THE SOFTWARE WILL ACCOMPLISH THE INTENDED RESULTS OR THAT THE SOFTWARE OR ITS USE WILL NOT RESULT IN INJURY OR DAMAGE.
+ * THE USER ASSUMES RESPONSIBILITY FOR ALL LIABILITIES, PENALTIES, FINES, CLAIMS, CAUSES OF ACTION, AND COSTS AND EXPENSES, CAUSED BY, RESULTING FROM OR ARISING OUT OF,
+ * IN WHOLE OR IN PART THE USE, STORAGE OR DISPOSAL OF THE SOFTWARE.
+ */
+
+#ifndef __TSG_CACHE_LAGRANGE_CPP
+#define __TSG_CACHE_LAGRANGE_CPP
+
+#include "tsgCacheLagrange.hpp"
+
+namespace TasGrid{
+
+/*!
+ * \internal
+ * \ingroup TasmanianAcceleration
+ * \brief Annotates a function that should be compiled for several instruction sets, the widest one supported by the CPU is selected at runtime.
+ *
+ * Uses the GCC \b target_clones attribute, the loops over blocks of points are marked with \b omp \b simd
+ * and the compiler generates AVX-512, AVX2 and generic versions of the function.
+ * Other compilers and platforms use only the generic version.
+ * \endinternal
+ */
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__INTEL_COMPILER) && !defined(__CUDACC__) && (__GNUC__ >= 6) && defined(__x86_64__) && defined(__linux__)
+#define Tasmanian_SIMD_DISPATCH __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define Tasmanian_SIMD_DISPATCH
+#endif
+
+/*!
+ * \internal
+ * \ingroup TasmanianAcceleration
+ * \brief Marks a loop with \b omp \b simd when OpenMP is enabled, avoids unknown pragma warnings otherwise.
+ * \endinternal
+ */
+#ifdef _OPENMP
+#define Tasmanian_OMP_SIMD _Pragma("omp simd")
+#else
+#define Tasmanian_OMP_SIMD
+#endif
+
+template<typename T>
+Tasmanian_SIMD_DISPATCH
+void CacheLagrangeBlock<T>::cacheLevel(int num_points, const double nodes[], const double coeff[], bool zero_at_boundary,
+                                       int num_x, const double x[], T work[], T *cache){
+    Tasmanian_OMP_SIMD
+    for(int i=0; i<num_x; i++){
+        cache[i] = 1.0;
+        work[i] = 1.0;
+    }
+    for(int j=0; j<num_points-1; j++){
+        T *next = &(cache[Utils::size_mult(j+1, num_x)]);
+        double node = nodes[j];
+        Tasmanian_OMP_SIMD
+        for(int i=0; i<num_x; i++){
+            work[i] *= (x[i] - node);
+            next[i] = work[i];
+        }
+    }
+    if (zero_at_boundary){
+        Tasmanian_OMP_SIMD
+        for(int i=0; i<num_x; i++) work[i] = x[i] * x[i] - 1.0;
+    }else{
+        Tasmanian_OMP_SIMD
+        for(int i=0; i<num_x; i++) work[i] = 1.0;
+    }
+    T *last = &(cache[Utils::size_mult(num_points-1, num_x)]);
+    double last_coeff = coeff[num_points-1];
+    Tasmanian_OMP_SIMD
+    for(int i=0; i<num_x; i++) last[i] *= work[i] * last_coeff;
+    for(int j=num_points-2; j>=0; j--){
+        T *current = &(cache[Utils::size_mult(j, num_x)]);
+        double node = nodes[j+1];
+        double cf = coeff[j];
+        Tasmanian_OMP_SIMD
+        for(int i=0; i<num_x; i++){
+            work[i] *= (x[i] - node);
+            current[i] *= work[i] * cf;
+        }
+    }
+}
+
+template void CacheLagrangeBlock<double>::cacheLevel(int, const double[], const double[], bool, int, const double[], double[], double*);
+template void CacheLagrangeBlock<float>::cacheLevel(int, const double[], const double[], bool, int, const double[], float[], float*);
+
+}
+
+#endif
@@ -112,6 +112,66 @@ private:
     std::vector<int> offsets;
 };
 
+/*!
+ * \internal
+ * \ingroup TasmanianAcceleration
+ * \brief Cache that holds the values of 1D Lagrange polynomials for a block of points.
+ *
+ * Similar to CacheLagrange, but the values are computed for a block of canonical points simultaneously,
+ * and the values for all points associated with a (dimension, level, node) triple are stored contiguously.
+ * The layout allows the tensor evaluation of Global grids to process the entire block of points
+ * with a single pass trough the multi-index structure of each tensor,
+ * and the two-pass product in cacheLevel() is vectorized across the points in the block.
+ * \endinternal
+ */
+template <typename T>
+class CacheLagrangeBlock{
+public:
+    /*!
+     * \brief Constructor that takes into account a block of \b num_x canonical points \b x.
+     *
+     * The parameters are the same as in CacheLagrange, the points in \b x are stored in strips of size \b num_dimensions.
+     */
+    CacheLagrangeBlock(int num_dimensions, const std::vector<int> &max_levels, const OneDimensionalWrapper &rule, int cnum_x, const double x[]) :
+        num_x(cnum_x), offsets(rule.getPointsCount()){
+        cache.resize(num_dimensions);
+        std::vector<double> xdim((size_t) num_x);
+        std::vector<T> work((size_t) num_x);
+
+        for(int dim=0; dim<num_dimensions; dim++){
+            for(int i=0; i<num_x; i++) xdim[i] = x[i * num_dimensions + dim];
+            cache[dim].resize(Utils::size_mult(offsets[max_levels[dim] + 1], num_x));
+            for(int level=0; level <= max_levels[dim]; level++)
+                cacheLevel(rule.getNumPoints(level), rule.getNodes(level), rule.getCoefficients(level), (rule.getType() == rule_clenshawcurtis0),
+                           num_x, xdim.data(), work.data(), &(cache[dim][Utils::size_mult(offsets[level], num_x)]));
+        }
+    }
+    //! \brief Destructor, clear all used data.
+    ~CacheLagrangeBlock(){}
+
+    /*!
+     * \brief Computes the values of all Lagrange polynomials for one level at the \b num_x values in \b x (contiguous array).
+     *
+     * The \b num_points, \b nodes and \b coeff describe the level of the rule, \b zero_at_boundary indicates
+     * the rule_clenshawcurtis0 special case, \b work is a scratch array of size \b num_x.
+     * Defined in tsgCacheLagrange.cpp for \b double and \b float, compiled for several instruction sets where the compiler supports it.
+     */
+    static void cacheLevel(int num_points, const double nodes[], const double coeff[], bool zero_at_boundary,
+                           int num_x, const double x[], T work[], T *cache);
+
+    //! \brief Return the Lagrange cache for given \b dimension, \b level and offset local to the level, the values for all points are contiguous.
+    const T* getLagrange(int dimension, int level, int local) const{
+        return &(cache[dimension][Utils::size_mult(offsets[level] + local, num_x)]);
+    }
+
+    //! \brief Return the number of points in the block.
+    int getNumX() const{ return num_x; }
+
+private:
+    int num_x;
+    std::vector<std::vector<T>> cache;
+    std::vector<int> offsets;
+};
 
 }
 
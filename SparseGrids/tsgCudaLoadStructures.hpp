@@ -55,10 +55,11 @@ struct CudaSequenceData{
 //! \brief Wrapper structure for the vectors needed by Fourier grid CUDA methods.
 
 //! The \b real and \b imag values correspond to the real and complex part of the Fourier coefficients.
+//! The \b fused values hold the coefficients in the layout of the CPU contraction (real and imaginary parts stacked or interleaved).
 //! The \b points is a transposed copy of the nodes in the MultiIndexSet and \b num_nodes is the number of nodes in each dimension.
 template<typename FP>
 struct CudaFourierData{
-    CudaVector<FP> real, imag;
+    CudaVector<FP> real, imag, fused;
     CudaVector<int> num_nodes, points;
 };
 
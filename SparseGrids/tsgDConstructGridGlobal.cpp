@@ -36,7 +36,7 @@
 namespace TasGrid{
 
 DynamicConstructorDataGlobal::DynamicConstructorDataGlobal(size_t cnum_dimensions, size_t cnum_outputs)
-    : num_dimensions(cnum_dimensions), num_outputs(cnum_outputs){}
+    : num_dimensions(cnum_dimensions), num_outputs(cnum_outputs), pending(false){}
 DynamicConstructorDataGlobal::~DynamicConstructorDataGlobal(){}
 
 template<bool useAscii> void DynamicConstructorDataGlobal::write(std::ostream &os) const{
@@ -48,7 +48,19 @@ template<bool useAscii> void DynamicConstructorDataGlobal::write(std::ostream &o
         IO::writeNumbers<useAscii, IO::pad_rspace, double>(os, d->weight);
         IO::writeVector<useAscii, IO::pad_line>(d->tensor, os);
     }
-    writeNodeDataList<useAscii>(data, os);
+
+    // the file format keeps all nodes in one list, combine the nodes stored in the tensors with the rest
+    std::forward_list<NodeData> all_data = data;
+    for(auto const &t : tensors){
+        for(int i=0; i<(int) t.loaded.size(); i++){
+            if (t.loaded[i])
+                all_data.emplace_front(NodeData{
+                                       std::vector<int>(t.points.getIndex(i), t.points.getIndex(i) + num_dimensions),
+                                       std::vector<double>(t.values.begin() + Utils::size_mult(i, num_outputs), t.values.begin() + Utils::size_mult(i + 1, num_outputs))
+                                       });
+        }
+    }
+    writeNodeDataList<useAscii>(all_data, os);
 }
 
 template<bool useAscii> void DynamicConstructorDataGlobal::read(std::istream &is){
@@ -59,7 +71,9 @@ template<bool useAscii> void DynamicConstructorDataGlobal::read(std::istream &is
                               std::vector<int>(num_dimensions), // tensor
                               MultiIndexSet(), // points, will be set later
                               std::vector<bool>(), // loaded, will be set later
-                              IO::readNumber<useAscii, double>(is) // weight
+                              IO::readNumber<useAscii, double>(is), // weight
+                              std::vector<double>(), // values, will be set later
+                              0 // num_missing, will be set later
                               });
         IO::readVector<useAscii>(is, tensors.front().tensor);
     }
@@ -79,17 +93,51 @@ int DynamicConstructorDataGlobal::getMaxTensor() const{
     return max_tensor;
 }
 
+void DynamicConstructorDataGlobal::cacheIndexLevels(int max_level, std::function<int(int)> getNumPoints){
+    for(int l = (index_levels.empty()) ? 0 : index_levels.back() + 1; l <= max_level; l++){
+        size_t num_points = (size_t) getNumPoints(l);
+        if (index_levels.size() < num_points) index_levels.resize(num_points, l);
+    }
+}
+
+TensorData* DynamicConstructorDataGlobal::findTensor(const std::vector<int> &point){
+    std::vector<int> tensor(num_dimensions);
+    for(size_t j=0; j<num_dimensions; j++){
+        if ((size_t) point[j] >= index_levels.size()) return nullptr;
+        tensor[j] = index_levels[point[j]];
+    }
+    auto t = tensor_map.find(tensor);
+    return (t == tensor_map.end()) ? nullptr : t->second;
+}
+
+bool DynamicConstructorDataGlobal::loadNode(TensorData &t, const std::vector<int> &point, const std::vector<double> &value){
+    int slot = t.points.getSlot(point);
+    if (slot == -1) return false;
+    std::copy_n(value.begin(), num_outputs, t.values.begin() + Utils::size_mult(slot, num_outputs));
+    if (t.loaded[slot]) return false; // repeated node, the value is overwritten
+    t.loaded[slot] = true;
+    return (--t.num_missing == 0);
+}
+
 void DynamicConstructorDataGlobal::reloadPoints(std::function<int(int)> getNumPoints){
+    cacheIndexLevels(getMaxTensor(), getNumPoints);
+    tensor_map.clear();
     for(auto &t : tensors){
         MultiIndexSet dummy_set(num_dimensions, std::vector<int>(t.tensor));
         t.points = MultiIndexManipulations::generateNestedPoints(dummy_set, getNumPoints);
         t.loaded = std::vector<bool>((size_t) t.points.getNumIndexes(), false);
+        t.values = std::vector<double>(Utils::size_mult(t.points.getNumIndexes(), num_outputs));
+        t.num_missing = t.points.getNumIndexes();
+        tensor_map[t.tensor] = &t;
     }
 
-    for(auto const &p : data){ // rebuild the loaded vectors
-        for(auto &t : tensors){
-            int i = t.points.getSlot(p.point);
-            if (i != -1) t.loaded[i] = true;
+    for(auto d = data.before_begin(), v = data.begin(); v != data.end(); v = std::next(d)){ // move the nodes into the tensors
+        TensorData *t = findTensor(v->point);
+        if (t == nullptr){
+            d = v;
+        }else{
+            loadNode(*t, v->point, v->value);
+            data.erase_after(d);
         }
     }
 }
@@ -97,6 +145,14 @@ void DynamicConstructorDataGlobal::reloadPoints(std::function<int(int)> getNumPo
 void DynamicConstructorDataGlobal::clearTesnors(){
     for(auto t = tensors.begin(), p = tensors.before_begin(); t != tensors.end(); t++){
         if (t->weight >= 0.0){
+            for(int i=0; i<(int) t->loaded.size(); i++){ // keep the nodes for the next set of tensors
+                if (t->loaded[i])
+                    data.emplace_front(NodeData{
+                                       std::vector<int>(t->points.getIndex(i), t->points.getIndex(i) + num_dimensions),
+                                       std::vector<double>(t->values.begin() + Utils::size_mult(i, num_outputs), t->values.begin() + Utils::size_mult(i + 1, num_outputs))
+                                       });
+            }
+            tensor_map.erase(t->tensor);
             tensors.erase_after(p);
             t = p;
         }else{
@@ -119,13 +175,25 @@ void DynamicConstructorDataGlobal::addTensor(const int *tensor, std::function<in
                           std::vector<int>(tensor, tensor + num_dimensions),
                           MultiIndexManipulations::generateNestedPoints(MultiIndexSet(num_dimensions, std::vector<int>(tensor, tensor + num_dimensions)), getNumPoints),
                           std::vector<bool>(),
-                          weight
+                          weight,
+                          std::vector<double>(),
+                          0
                           });
 
-    tensors.front().loaded = std::vector<bool>((size_t) tensors.front().points.getNumIndexes(), false);
-    for(auto const &p : data){
-        int slot = tensors.front().points.getSlot(p.point);
-        if (slot != -1) tensors.front().loaded[slot] = true;
+    TensorData &t = tensors.front();
+    t.loaded = std::vector<bool>((size_t) t.points.getNumIndexes(), false);
+    t.values = std::vector<double>(Utils::size_mult(t.points.getNumIndexes(), num_outputs));
+    t.num_missing = t.points.getNumIndexes();
+    tensor_map[t.tensor] = &t;
+    cacheIndexLevels(*std::max_element(tensor, tensor + num_dimensions), getNumPoints);
+
+    for(auto d = data.before_begin(), v = data.begin(); v != data.end(); v = std::next(d)){ // take the nodes loaded before the tensor was added
+        if (t.points.missing(v->point)){
+            d = v;
+        }else{
+            loadNode(t, v->point, v->value);
+            data.erase_after(d);
+        }
     }
 }
 
@@ -133,7 +201,7 @@ void DynamicConstructorDataGlobal::getNodesIndexes(std::vector<int> &inodes){
     inodes = std::vector<int>();
     tensors.sort([&](const TensorData &a, const TensorData &b)->bool{ return (a.weight < b.weight); });
     for(auto const &t : tensors){
-        if (!t.loaded.empty()){
+        if (t.num_missing > 0){
             for(int i=0; i<t.points.getNumIndexes(); i++){
                 if (!t.loaded[i])
                     inodes.insert(inodes.end(), t.points.getIndex(i), t.points.getIndex(i) + num_dimensions);
@@ -143,48 +211,29 @@ void DynamicConstructorDataGlobal::getNodesIndexes(std::vector<int> &inodes){
 }
 
 bool DynamicConstructorDataGlobal::addNewNode(const std::vector<int> &point, const std::vector<double> &value){
-    data.emplace_front(NodeData{point, value});
-    for(auto &t : tensors){
-        int slot = t.points.getSlot(point);
-        if (slot != -1){
-            t.loaded[slot] = true;
-            if (std::all_of(t.loaded.begin(), t.loaded.end(), [](bool a)-> bool{ return a; })){ // if all entries are true
-                t.loaded = std::vector<bool>();
-                return true; // all points associated with this tensor have been loaded, signal to call ejectCompleteTensor()
-            }else{
-                return false; // point added to the tensor, but the tensor is not complete yet
-            }
-        }
+    std::lock_guard<std::mutex> lock(data_lock);
+    TensorData *t = findTensor(point);
+    if (t == nullptr){ // the node does not belong to a candidate tensor, keep it for later
+        data.emplace_front(NodeData{point, value});
+        return false;
     }
-    return false; // could not find a tensor that contains this node???
+    if (loadNode(*t, point, value)){
+        pending = true;
+        return true; // all points associated with this tensor have been loaded, signal to call ejectCompleteTensor()
+    }
+    return false; // point added to the tensor, but the tensor is not complete yet
 }
 
 bool DynamicConstructorDataGlobal::ejectCompleteTensor(const MultiIndexSet &current_tensors, std::vector<int> &tensor, MultiIndexSet &points, std::vector<double> &vals){
+    std::lock_guard<std::mutex> lock(data_lock);
     for(auto p = tensors.before_begin(), t = tensors.begin(); t != tensors.end(); t++, p++){
-        if (t->loaded.empty()){ // empty loaded means all have been loaded
+        if (t->num_missing == 0){ // all points have been loaded
             if (MultiIndexManipulations::isLowerComplete(t->tensor, current_tensors)){
                 tensor = t->tensor;
-                points = t->points;
-                vals.resize(Utils::size_mult(points.getNumIndexes(),  num_outputs));
-                Data2D<double> wvals(num_outputs, points.getNumIndexes());
-                auto d = data.before_begin();
-                auto v = data.begin();
-                int found = 0;
-                while(found < points.getNumIndexes()){
-                    int slot = points.getSlot(v->point);
-                    if (slot == -1){
-                        d++;
-                        v++;
-                    }else{
-                        std::copy_n(v->value.begin(), num_outputs, wvals.getStrip(slot));
-                        data.erase_after(d);
-                        v = d;
-                        v++;
-                        found++;
-                    }
-                }
+                points = std::move(t->points);
+                vals = std::move(t->values);
+                tensor_map.erase(t->tensor);
                 tensors.erase_after(p);
-                vals = std::move(wvals.getVector());
                 return true;
             }
         }
@@ -192,6 +241,35 @@ bool DynamicConstructorDataGlobal::ejectCompleteTensor(const MultiIndexSet &curr
     return false; // could not find a complete tensor with parents present in tensors
 }
 
+NodeIndexLookup::NodeIndexLookup(std::function<double(int)> get_node, int initial_nodes, int max_nodes)
+    : getNode(get_node), max_num_nodes(max_nodes){
+    cacheNodes(std::min(initial_nodes, max_nodes));
+}
+
+void NodeIndexLookup::cacheNodes(int num_nodes){
+    sorted_nodes.resize((size_t) num_nodes);
+    for(int i=0; i<num_nodes; i++) sorted_nodes[i] = std::make_pair(getNode(i), i);
+    std::sort(sorted_nodes.begin(), sorted_nodes.end());
+}
+
+int NodeIndexLookup::getIndex(double x){
+    while(true){
+        auto n = std::lower_bound(sorted_nodes.begin(), sorted_nodes.end(), std::make_pair(x - Maths::num_tol, -1));
+        if ((n != sorted_nodes.end()) && (std::abs(n->first - x) <= Maths::num_tol)) return n->second;
+        if ((int) sorted_nodes.size() >= max_num_nodes) return -1;
+        cacheNodes(std::min(2 * std::max((int) sorted_nodes.size(), 1), max_num_nodes));
+    }
+}
+
+std::vector<int> NodeIndexLookup::getIndexes(size_t num_dimensions, int num_x, const double x[]){
+    std::vector<int> p(Utils::size_mult(num_dimensions, num_x));
+    for(size_t i=0; i<p.size(); i++){
+        p[i] = getIndex(x[i]);
+        if (p[i] == -1) throw std::runtime_error("ERROR: loadConstructedPoints() x is not a vector returned by getCandidateConstructionPoints()");
+    }
+    return p;
+}
+
 }
 
 #endif
@@ -32,6 +32,11 @@
 #define __TASMANIAN_SPARSE_GRID_DYNAMIC_CONST_GLOBAL_HPP
 
 #include <forward_list>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <functional>
 
 #include "tsgIndexManipulator.hpp"
 
@@ -105,6 +110,25 @@ struct TensorData{
     std::vector<bool> loaded;
     //! \brief The weight indicates the relative importance of the tensor.
     double weight;
+    //! \brief The model values at the loaded points, organized in the order of the \b points.
+    std::vector<double> values;
+    //! \brief Number of points that are not loaded yet, the tensor is complete when the number reaches zero.
+    int num_missing;
+};
+
+/*!
+ * \internal
+ * \ingroup TasmanianRefinement
+ * \brief Hash function for a multi-index stored in a std::vector, used to find tensors without scanning lists.
+ * \endinternal
+ */
+struct MultiIndexHash{
+    //! \brief Combines the entries of the multi-index.
+    size_t operator()(std::vector<int> const &index) const{
+        size_t h = index.size();
+        for(auto i : index) h ^= ((size_t) i) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
 };
 
 /*!
@@ -175,6 +199,12 @@ std::forward_list<NodeData> readNodeDataList(size_t num_dimensions, size_t num_o
  * When enough data has been computed to complete a tensor,
  * the tensor can be ejected with the points and model data returned in a format
  * that is easy to incorporate within the data structures of the \b GridGlobal class.
+ *
+ * The tensors are indexed by a hash map, the tensor of a point is computed from the levels of the point indexes,
+ * hence adding a node does not scan the lists of tensors and nodes.
+ * The values of the nodes are stored in the tensors, only the nodes that do not belong to a candidate tensor are kept in the list.
+ * The methods addNewNode() and ejectCompleteTensor() can be called concurrently from multiple threads,
+ * and mergeCompleteTensors() ensures that only one thread at a time moves the complete tensors into the grid.
  */
 class DynamicConstructorDataGlobal{
 public:
@@ -206,16 +236,69 @@ public:
     //! \brief Get the node indexes of the points associated with the candidate tensors, the order is the same as the tensors sorted by ascending weight.
     void getNodesIndexes(std::vector<int> &inodes);
 
-    //! \brief Add a new data point with the index and the value, returns \b true if there is enough data to complete a tensor.
+    //! \brief Add a new data point with the index and the value, returns \b true if there is enough data to complete a tensor, thread safe.
     bool addNewNode(const std::vector<int> &point, const std::vector<double> &value); // returns whether a tensor is complete
 
-    //! \brief Return a completed tensor with parent-tensors included in tensors, returns \b true if such tensor has been found.
+    //! \brief Return a completed tensor with parent-tensors included in tensors, returns \b true if such tensor has been found, thread safe.
     bool ejectCompleteTensor(const MultiIndexSet &current_tensors, std::vector<int> &tensor, MultiIndexSet &points, std::vector<double> &vals);
 
+    /*!
+     * \brief Calls \b merge() to move the complete tensors into the grid, one thread at a time.
+     *
+     * If another thread is already merging, the call returns immediately and the other thread takes the new complete tensors,
+     * the merging thread repeats until no tensor has been completed during the last call to \b merge().
+     */
+    template<typename callable> void mergeCompleteTensors(callable merge){
+        do{
+            std::unique_lock<std::mutex> lock(merge_lock, std::try_to_lock);
+            if (!lock.owns_lock()) return;
+            pending = false;
+            merge();
+        }while(pending);
+    }
+
+protected:
+    //! \brief Extends the cache of the levels of the point indexes up to the \b max_level.
+    void cacheIndexLevels(int max_level, std::function<int(int)> getNumPoints);
+    //! \brief Returns the candidate tensor that contains the \b point, or \b nullptr if the tensor is not a candidate.
+    TensorData* findTensor(const std::vector<int> &point);
+    //! \brief Stores the \b value for the \b point in the tensor \b t, returns \b true if the tensor is complete.
+    bool loadNode(TensorData &t, const std::vector<int> &point, const std::vector<double> &value);
+
 private:
     size_t num_dimensions, num_outputs;
     std::forward_list<NodeData> data;
     std::forward_list<TensorData> tensors;
+    std::unordered_map<std::vector<int>, TensorData*, MultiIndexHash> tensor_map;
+    std::vector<int> index_levels;
+    std::mutex data_lock, merge_lock;
+    std::atomic<bool> pending;
+};
+
+/*!
+ * \internal
+ * \ingroup TasmanianRefinement
+ * \brief Converts the canonical coordinates of nodes to node indexes, used when loading batches of constructed points.
+ *
+ * Keeps a copy of the nodes sorted by coordinate, the index is found with a binary search and \b Maths::num_tol tolerance.
+ * The nodes are generated with \b getNode(), the table starts with \b initial_nodes and doubles in size
+ * until the coordinate is found or the table reaches \b max_nodes.
+ * \endinternal
+ */
+class NodeIndexLookup{
+public:
+    //! \brief Constructor, caches the first \b initial_nodes nodes.
+    NodeIndexLookup(std::function<double(int)> get_node, int initial_nodes, int max_nodes);
+    //! \brief Returns the index of the node with coordinate \b x, or -1 if \b x is not a node.
+    int getIndex(double x);
+    //! \brief Converts \b num_x canonical points to multi-indexes, throws \b std::runtime_error if a coordinate is not a node.
+    std::vector<int> getIndexes(size_t num_dimensions, int num_x, const double x[]);
+
+private:
+    void cacheNodes(int num_nodes);
+    std::function<double(int)> getNode;
+    int max_num_nodes;
+    std::vector<std::pair<double, int>> sorted_nodes;
 };
 
 /*!
@@ -231,15 +314,71 @@ private:
  * \endinternal
  */
 struct SimpleConstructData{
-    //! \brief A list of pair indicating point and model output values.
+    //! \brief A list of pair indicating point and model output values, used when loading one point at a time.
     std::forward_list<NodeData> data;
+    //! \brief The nodes waiting to be added to the grid by the batch loaders, indexed by the multi-index and holding the most recent values.
+    std::unordered_map<std::vector<int>, std::vector<double>, MultiIndexHash> pending;
     //! \brief Keeps track of the initial point set, so those can be computed first.
     MultiIndexSet initial_points;
-    //! \brief Save to a file in either ascii or binary format.
+    //! \brief Save to a file in either ascii or binary format, the \b pending nodes are saved together with the \b data.
     template<bool useAscii>
     void write(std::ostream &os) const{
         initial_points.write<useAscii>(os);
-        writeNodeDataList<useAscii>(data, os);
+        if (pending.empty()){
+            writeNodeDataList<useAscii>(data, os);
+        }else{
+            std::forward_list<NodeData> all = data; // the pending nodes are older than the data and go to the back of the list
+            auto tail = all.before_begin();
+            for(auto t = all.begin(); t != all.end(); t++) tail = t;
+            for(auto const &p : pending) tail = all.insert_after(tail, {p.first, p.second});
+            writeNodeDataList<useAscii>(all, os);
+        }
+    }
+    //! \brief Moves the nodes from the \b data to the \b pending index, called by the batch loaders, the most recent value of each point is kept.
+    void indexNodes(){
+        if (data.empty()) return;
+        for(auto d : makeReverseReferenceVector(data)) pending[d->point] = d->value; // from the oldest to the most recent
+        data.clear();
+    }
+    //! \brief Moves the \b pending nodes back to the \b data, called by the loaders that use one point at a time.
+    void listNodes(){
+        if (pending.empty()) return;
+        auto tail = data.before_begin();
+        for(auto t = data.begin(); t != data.end(); t++) tail = t;
+        for(auto &p : pending) tail = data.insert_after(tail, {p.first, std::move(p.second)});
+        pending.clear();
+    }
+    /*!
+     * \brief Add \b num_x nodes with multi-indexes \b pnts and values \b vals to the \b pending index, the nodes are removed from the \b initial_points.
+     *
+     * Only the new nodes are hashed, the nodes already waiting are not visited,
+     * the values of a repeated node are replaced so that the most recent values are used.
+     */
+    void addNodes(size_t num_dimensions, size_t num_outputs, int num_x, std::vector<int> const &pnts, const double vals[]){
+        indexNodes();
+        for(size_t i=0; i<(size_t) num_x; i++)
+            pending[std::vector<int>(pnts.begin() + i * num_dimensions, pnts.begin() + (i + 1) * num_dimensions)]
+                = std::vector<double>(vals + i * num_outputs, vals + (i + 1) * num_outputs);
+        if (!initial_points.empty()){
+            Data2D<int> batch((int) num_dimensions, num_x, std::vector<int>(pnts));
+            initial_points = initial_points.diffSets(MultiIndexSet(batch));
+        }
+    }
+    /*!
+     * \brief Moves the \b nodes into a lexicographically sorted set of \b points and the matching \b values.
+     *
+     * The grids use the result as needed points, i.e., the nodes of a batch are added with a single merge.
+     */
+    static void sortNodes(size_t num_dimensions, std::vector<NodeData> &nodes, MultiIndexSet &points, std::vector<double> &values){
+        std::sort(nodes.begin(), nodes.end(), [](NodeData const &a, NodeData const &b)->bool{ return std::lexicographical_compare(a.point.begin(), a.point.end(), b.point.begin(), b.point.end()); });
+        std::vector<int> pnts;
+        pnts.reserve(nodes.size() * num_dimensions);
+        values.clear();
+        for(auto const &n : nodes){
+            pnts.insert(pnts.end(), n.point.begin(), n.point.end());
+            values.insert(values.end(), n.value.begin(), n.value.end());
+        }
+        points = MultiIndexSet(num_dimensions, std::move(pnts));
     }
 };
 
@@ -40,8 +40,10 @@
 #include <vector>
 #include <cmath>
 #include <numeric>
+#include <algorithm>
 #include <stdexcept>
 #include <functional>
+#include <memory>
 
 #include "TasmanianConfig.hpp" // contains build options passed down from CMake
 #include "tsgUtils.hpp" // contains array wrapper and size_mult for int-to-size_t
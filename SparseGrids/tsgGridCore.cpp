@@ -35,8 +35,8 @@
 
 namespace TasGrid{
 
-BaseCanonicalGrid::BaseCanonicalGrid(){}
-BaseCanonicalGrid::~BaseCanonicalGrid(){}
+BaseCanonicalGrid::BaseCanonicalGrid() : float_coefficients(nullptr){}
+BaseCanonicalGrid::~BaseCanonicalGrid(){ clearFloatCoefficients(); }
 
 SplitDirections::SplitDirections(const MultiIndexSet &points){
     // split the points into "jobs", where each job represents a batch of
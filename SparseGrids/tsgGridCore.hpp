@@ -69,9 +69,11 @@ public:
     virtual void integrate(double q[], double *conformal_correction) const = 0;
 
     virtual void evaluateBatch(const double x[], int num_x, double y[]) const = 0;
+    virtual void evaluateBatch(const double x[], int num_x, float y[]) const = 0; // uses the single precision copy of the coefficients
 
     #ifdef Tasmanian_ENABLE_BLAS
     virtual void evaluateBlas(const double x[], int num_x, double y[]) const = 0;
+    virtual void evaluateBlas(const double x[], int num_x, float y[]) const = 0;
     #endif
 
     #ifdef Tasmanian_ENABLE_CUDA
@@ -90,17 +92,41 @@ public:
     virtual void readConstructionDataBinary(std::istream&){}
     virtual void readConstructionData(std::istream&){}
     virtual void loadConstructedPoint(const double[], const std::vector<double> &){}
+    virtual void loadConstructedPoints(const double[], int, const double[]){}
     virtual void finishConstruction(){}
 
     virtual void evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const = 0; // add acceleration here
+    virtual void evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const = 0;
     virtual void setHierarchicalCoefficients(const double c[], TypeAcceleration acc) = 0;
 
     virtual void clearAccelerationData() = 0;
 
 protected:
+    //! \brief Returns a single precision copy of the \b num_entries hierarchical coefficients in \b source, the copy is made on the first call.
+
+    //! Similar to the CUDA caches, the copy is created lazily and must be discarded with clearFloatCoefficients() whenever the coefficients change.
+    //! The copy is built under a mutex, hence concurrent evaluations from multiple threads are safe.
+    const float* getFloatCoefficients(const double source[], size_t num_entries) const{
+        std::vector<float> const *cached = float_coefficients.load();
+        if (cached == nullptr){
+            std::lock_guard<std::mutex> lock(float_lock);
+            cached = float_coefficients.load();
+            if (cached == nullptr){
+                cached = new std::vector<float>(source, source + num_entries);
+                float_coefficients.store(cached);
+            }
+        }
+        return cached->data();
+    }
+    //! \brief Discards the single precision copy of the hierarchical coefficients, cannot be called concurrently with getFloatCoefficients().
+    void clearFloatCoefficients(){ delete float_coefficients.exchange(nullptr); }
+
     int num_dimensions, num_outputs;
     MultiIndexSet points;
     MultiIndexSet needed;
+
+    mutable std::atomic<std::vector<float> const*> float_coefficients;
+    mutable std::mutex float_lock;
 };
 
 class SplitDirections{
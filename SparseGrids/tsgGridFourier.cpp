@@ -36,7 +36,7 @@
 
 namespace TasGrid{
 
-GridFourier::GridFourier() : max_levels(0){}
+GridFourier::GridFourier() : max_levels(0), interleaved(false){}
 GridFourier::~GridFourier(){}
 
 template<bool useAscii> void GridFourier::write(std::ostream &os) const{
@@ -58,7 +58,12 @@ template<bool useAscii> void GridFourier::write(std::ostream &os) const{
     if (num_outputs > 0){
         values.write<useAscii>(os);
         IO::writeFlag<useAscii, IO::pad_auto>((fourier_coefs.getNumStrips() != 0), os);
-        if (fourier_coefs.getNumStrips() != 0) IO::writeVector<useAscii, IO::pad_line>(fourier_coefs.getVector(), os);
+        if (fourier_coefs.getNumStrips() != 0){
+            if (interleaved) // files always use the default layout
+                IO::writeLevelData2D<useAscii, IO::pad_line>(reorderCoefficients(false), std::vector<int>(), os);
+            else
+                IO::writeLevelData2D<useAscii, IO::pad_line>(fourier_coefs, std::vector<int>(), os);
+        }
     }
 
     IO::writeFlag<useAscii, IO::pad_line>(false, os);
@@ -82,7 +87,7 @@ template<bool useAscii> void GridFourier::read(std::istream &is){
     if (num_outputs > 0){
         values.read<useAscii>(is);
         if (IO::readFlag<useAscii>(is))
-            fourier_coefs = IO::readData2D<useAscii, double>(is, num_outputs, 2 * points.getNumIndexes());
+            fourier_coefs = IO::readLevelData2D<useAscii>(is, num_outputs, 2 * points.getNumIndexes(), std::vector<int>());
     }
 
     if (IO::readFlag<useAscii>(is)) throw std::runtime_error("ERROR: refinement not implemented for Fourier grids.");
@@ -107,6 +112,7 @@ void GridFourier::reset(){
     values = StorageSet();
     active_w.clear();
     fourier_coefs.clear();
+    interleaved = false;
     num_dimensions = 0;
     num_outputs = 0;
 }
@@ -125,6 +131,7 @@ void GridFourier::copyGrid(const GridFourier *fourier){
     if ((num_outputs > 0) && (!fourier->points.empty())){ // if there are values inside the source object
         loadNeededPoints(fourier->values.getValues(0));
     }
+    setInterleavedCoefficients(fourier->interleaved); // the copy uses the same layout
 }
 
 void GridFourier::setTensors(MultiIndexSet &&tset, int cnum_outputs){
@@ -162,6 +169,7 @@ void GridFourier::loadNeededPoints(const double *vals){
     #ifdef Tasmanian_ENABLE_CUDA
     clearCudaCoefficients(); // changing values and Fourier coefficients, clear the cache
     #endif
+    clearFloatCoefficients();
     if (needed.empty()){
         values.setValues(vals);
     }else{
@@ -287,6 +295,7 @@ void GridFourier::calculateFourierCoefficients(){
              }
         }
     }
+    if (interleaved) fourier_coefs = reorderCoefficients(true);
 }
 
 void GridFourier::getInterpolationWeights(const double x[], double weights[]) const {
@@ -372,6 +381,86 @@ void GridFourier::getQuadratureWeights(double weights[]) const{
     }
 }
 
+template<typename callable>
+void GridFourier::walkBasisBlock(const MultiIndexSet &work, int num_x, const double x[], callable apply) const{
+    int num_points = work.getNumIndexes();
+    size_t bsize = (size_t) num_x;
+
+    // creal[j] and cimag[j] hold exp(-2 pi i k x_j) for all powers k, the values for all points are contiguous
+    std::vector<std::vector<double>> creal(num_dimensions), cimag(num_dimensions);
+    std::vector<double> sreal(bsize), simag(bsize);
+    for(int j=0; j<num_dimensions; j++){
+        creal[j].resize(Utils::size_mult(max_power[j] + 1, num_x));
+        cimag[j].resize(Utils::size_mult(max_power[j] + 1, num_x));
+        std::fill_n(creal[j].data(), bsize, 1.0);
+        std::fill_n(cimag[j].data(), bsize, 0.0);
+        for(int i=0; i<num_x; i++){
+            double theta = -2.0 * Maths::pi * x[i * num_dimensions + j];
+            sreal[i] = std::cos(theta);
+            simag[i] = std::sin(theta);
+        }
+        for(int k=1; k<max_power[j]; k += 2){
+            int previous = (k > 1) ? k - 2 : 0; // the previous positive power, the conjugates are stored at the even indexes
+            const double *pr = &(creal[j][Utils::size_mult(previous, num_x)]);
+            const double *pi = &(cimag[j][Utils::size_mult(previous, num_x)]);
+            double *nr = &(creal[j][Utils::size_mult(k, num_x)]);
+            double *ni = &(cimag[j][Utils::size_mult(k, num_x)]);
+            double *cr = &(creal[j][Utils::size_mult(k + 1, num_x)]); // conjugate
+            double *ci = &(cimag[j][Utils::size_mult(k + 1, num_x)]);
+            #pragma omp simd
+            for(int i=0; i<num_x; i++){
+                double r = pr[i] * sreal[i] - pi[i] * simag[i];
+                double m = pr[i] * simag[i] + pi[i] * sreal[i];
+                nr[i] = r;
+                ni[i] = m;
+                cr[i] = r;
+                ci[i] = -m;
+            }
+        }
+    }
+
+    // preal.getStrip(j) is the product over dimensions 0 ... j of the current multi-index
+    Data2D<double> preal(num_x, num_dimensions), pimag(num_x, num_dimensions);
+    const int *prev = nullptr;
+    for(int p=0; p<num_points; p++){
+        const int *idx = work.getIndex(p);
+        int first = 0;
+        if (prev != nullptr) while(idx[first] == prev[first]) first++;
+        for(int j=first; j<num_dimensions; j++){
+            const double *cr = &(creal[j][Utils::size_mult(idx[j], num_x)]);
+            const double *ci = &(cimag[j][Utils::size_mult(idx[j], num_x)]);
+            double *r = preal.getStrip(j);
+            double *m = pimag.getStrip(j);
+            if (j == 0){
+                std::copy_n(cr, bsize, r);
+                std::copy_n(ci, bsize, m);
+            }else{
+                const double *lr = preal.getStrip(j-1);
+                const double *lm = pimag.getStrip(j-1);
+                #pragma omp simd
+                for(int i=0; i<num_x; i++){
+                    r[i] = lr[i] * cr[i] - lm[i] * ci[i];
+                    m[i] = lr[i] * ci[i] + lm[i] * cr[i];
+                }
+            }
+        }
+        apply(p, preal.getStrip(num_dimensions-1), pimag.getStrip(num_dimensions-1));
+        prev = idx;
+    }
+}
+
+template<typename callable>
+void GridFourier::walkBasisBlocks(const MultiIndexSet &work, int num_x, const double x[], callable apply) const{
+    int num_blocks = (num_x + basis_block_size - 1) / basis_block_size;
+    #pragma omp parallel for
+    for(int b=0; b<num_blocks; b++){
+        int first = b * basis_block_size;
+        int num_block = std::min(num_x - first, (int) basis_block_size);
+        walkBasisBlock(work, num_block, &(x[Utils::size_mult(first, num_dimensions)]),
+                       [&](int i, const double real[], const double imag[])->void{ apply(first, num_block, i, real, imag); });
+    }
+}
+
 void GridFourier::evaluate(const double x[], double y[]) const{
     int num_points = points.getNumIndexes();
     std::fill_n(y, num_outputs, 0.0);
@@ -379,35 +468,88 @@ void GridFourier::evaluate(const double x[], double y[]) const{
     std::vector<double> wimag(num_points);
     computeBasis<double, false>(points, x, wreal.data(), wimag.data());
     for(int i=0; i<num_points; i++){
-        const double *fcreal = fourier_coefs.getStrip(i);
-        const double *fcimag = fourier_coefs.getStrip(i + num_points);
-        double wr = wreal[i];
-        double wi = wimag[i];
-        for(int k=0; k<num_outputs; k++) y[k] += wr * fcreal[k] - wi * fcimag[k];
+        const double *fcreal = fourier_coefs.getStrip((interleaved) ? 2*i : i);
+        const double *fcimag = fourier_coefs.getStrip((interleaved) ? 2*i+1 : i + num_points);
+        for(int k=0; k<num_outputs; k++) y[k] += wreal[i] * fcreal[k] - wimag[i] * fcimag[k];
     }
 }
 void GridFourier::evaluateBatch(const double x[], int num_x, double y[]) const{
-    Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
-    Utils::Wrapper2D<double> ywrap(num_outputs, y);
-    #pragma omp parallel for
-    for(int i=0; i<num_x; i++)
-        evaluate(xwrap.getStrip(i), ywrap.getStrip(i));
+    evaluateBatchTempl<double>(x, num_x, getContractionCoefficients(), y);
+}
+void GridFourier::evaluateBatch(const double x[], int num_x, float y[]) const{
+    // the basis is computed in double precision, the contraction uses the single precision copy of the coefficients
+    evaluateBatchTempl<float>(x, num_x, getFloatCoefficients(getContractionCoefficients(), fourier_coefs.getTotalEntries()), y);
+}
+template<typename T>
+void GridFourier::evaluateBatchTempl(const double x[], int num_x, const T coeff[], T y[]) const{
+    int num_points = points.getNumIndexes();
+    Utils::Wrapper2D<T> ywrap(num_outputs, y);
+    std::fill_n(y, Utils::size_mult(num_x, num_outputs), 0.0);
+    walkBasisBlocks(points, num_x, x, [&](int first, int num_block, int i, const double real[], const double imag[])->void{
+        // the interleaved layout has the real and imaginary parts of each point next to each other
+        const T *fcreal = &(coeff[Utils::size_mult((interleaved) ? 2 * i : i, num_outputs)]);
+        const T *fcimag = &(coeff[Utils::size_mult((interleaved) ? 2 * i + 1 : i + num_points, num_outputs)]);
+        for(int j=0; j<num_block; j++){
+            T wr = (T) real[j];
+            T wi = (T) imag[j];
+            T *this_y = ywrap.getStrip(first + j);
+            for(int k=0; k<num_outputs; k++) this_y[k] += wr * fcreal[k] - wi * fcimag[k];
+        }
+    });
+}
+template<typename T>
+void GridFourier::evaluateFusedBasis(const double x[], int num_x, Data2D<T> &w) const{
+    int num_points = points.getNumIndexes();
+    w.resize(2 * num_points, num_x);
+    walkBasisBlocks(points, num_x, x, [&](int first, int num_block, int i, const double real[], const double imag[])->void{
+        for(int j=0; j<num_block; j++){
+            T *this_w = w.getStrip(first + j);
+            if (interleaved){
+                this_w[2*i] = (T) real[j];
+                this_w[2*i+1] = (T) -imag[j];
+            }else{
+                this_w[i] = (T) real[j];
+                this_w[i + num_points] = (T) -imag[j];
+            }
+        }
+    });
+}
+const double* GridFourier::getContractionCoefficients() const{
+    return fourier_coefs.getStrip(0);
+}
+Data2D<double> GridFourier::reorderCoefficients(bool to_interleaved) const{
+    int num_points = fourier_coefs.getNumStrips() / 2;
+    Data2D<double> result(num_outputs, 2 * num_points);
+    for(int i=0; i<num_points; i++){
+        const double *fcreal = fourier_coefs.getStrip((to_interleaved) ? i : 2*i);
+        const double *fcimag = fourier_coefs.getStrip((to_interleaved) ? i + num_points : 2*i+1);
+        std::copy_n(fcreal, num_outputs, result.getStrip((to_interleaved) ? 2*i : i));
+        std::copy_n(fcimag, num_outputs, result.getStrip((to_interleaved) ? 2*i+1 : i + num_points));
+    }
+    return result;
+}
+void GridFourier::setInterleavedCoefficients(bool interleave){
+    if (interleave != interleaved && fourier_coefs.getNumStrips() != 0) fourier_coefs = reorderCoefficients(interleave);
+    interleaved = interleave;
+    clearFloatCoefficients(); // the single precision copy follows the layout
+    #ifdef Tasmanian_ENABLE_CUDA
+    if (cuda_cache) cuda_cache->fused.clear(); // so does the fused copy on the device
+    #endif
 }
 
 #ifdef Tasmanian_ENABLE_BLAS
 void GridFourier::evaluateBlas(const double x[], int num_x, double y[]) const{
-    int num_points = points.getNumIndexes();
-    Data2D<double> wreal;
-    Data2D<double> wimag;
-    if (num_x > 1){
-        evaluateHierarchicalFunctionsInternal(x, num_x, wreal, wimag);
-    }else{ // work-around small OpenMP penalty
-        wreal.resize(num_points, 1);
-        wimag.resize(num_points, 1);
-        computeBasis<double, false>(points, x, wreal.getStrip(0), wimag.getStrip(0));
-    }
-    TasBLAS::denseMultiply(num_outputs, num_x, num_points, 1.0, fourier_coefs.getStrip(0), wreal.getStrip(0), 0.0, y);
-    TasBLAS::denseMultiply(num_outputs, num_x, num_points, -1.0, fourier_coefs.getStrip(num_points), wimag.getStrip(0), 1.0, y);
+    evaluateBlasTempl<double>(x, num_x, getContractionCoefficients(), y);
+}
+void GridFourier::evaluateBlas(const double x[], int num_x, float y[]) const{
+    evaluateBlasTempl<float>(x, num_x, getFloatCoefficients(getContractionCoefficients(), fourier_coefs.getTotalEntries()), y);
+}
+template<typename T>
+void GridFourier::evaluateBlasTempl(const double x[], int num_x, const T coeff[], T y[]) const{
+    // the real and imaginary parts are handled with one product, the basis and the output are read and written once
+    Data2D<T> w;
+    evaluateFusedBasis(x, num_x, w);
+    TasBLAS::denseMultiply(num_outputs, num_x, 2 * points.getNumIndexes(), (T) 1.0, coeff, w.getStrip(0), (T) 0.0, y);
 }
 #endif
 
@@ -416,16 +558,11 @@ void GridFourier::loadNeededPointsCuda(CudaEngine *, const double *vals){
     loadNeededPoints(vals);
 }
 void GridFourier::evaluateCudaMixed(CudaEngine *engine, const double x[], int num_x, double y[]) const{
-    loadCudaCoefficients();
-    Data2D<double> wreal;
-    Data2D<double> wimag;
-    evaluateHierarchicalFunctionsInternal(x, num_x, wreal, wimag);
-
-    int num_points = points.getNumIndexes();
-    CudaVector<double> gpu_real(wreal.getVector()), gpu_imag(wimag.getVector()), gpu_y(num_outputs, num_x);
-    engine->denseMultiply(num_outputs, num_x, num_points,  1.0, cuda_cache->real, gpu_real, 0.0, gpu_y.data());
-    engine->denseMultiply(num_outputs, num_x, num_points, -1.0, cuda_cache->imag, gpu_imag, 1.0, gpu_y.data());
-    gpu_y.unload(y);
+    // the basis is computed on the CPU in the fused layout, one product over the real and imaginary parts
+    loadCudaFusedCoefficients();
+    Data2D<double> w;
+    evaluateFusedBasis(x, num_x, w);
+    engine->denseMultiply(num_outputs, num_x, 2 * points.getNumIndexes(), 1.0, cuda_cache->fused, w.getVector(), y);
 }
 void GridFourier::evaluateCuda(CudaEngine *engine, const double x[], int num_x, double y[]) const{
     CudaVector<double> gpu_x(num_dimensions, num_x, x), gpu_y(num_outputs, num_x);
@@ -464,31 +601,43 @@ void GridFourier::integrate(double q[], double *conformal_correction) const{
 }
 
 void GridFourier::evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const{
-    // y must be of size 2*num_x*num_points
+    evaluateHierarchicalFunctionsTempl<double>(x, num_x, y);
+}
+void GridFourier::evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const{
+    // the phases are computed in double precision and rounded
+    evaluateHierarchicalFunctionsTempl<float>(x, num_x, y);
+}
+template<typename T>
+void GridFourier::evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const{
+    // y must be of size 2*num_x*num_points, the real and imaginary parts are interwoven
     int num_points = getNumPoints();
-    Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
-    Utils::Wrapper2D<double> ywrap(2*num_points, y);
-    #pragma omp parallel for
-    for(int i=0; i<num_x; i++){
-        computeBasis<double, true>(((points.empty()) ? needed : points), xwrap.getStrip(i), ywrap.getStrip(i), 0);
-    }
+    Utils::Wrapper2D<T> ywrap(2*num_points, y);
+    walkBasisBlocks(((points.empty()) ? needed : points), num_x, x, [&](int first, int num_block, int i, const double real[], const double imag[])->void{
+        for(int j=0; j<num_block; j++){
+            T *this_y = ywrap.getStrip(first + j);
+            this_y[2*i] = (T) real[j];
+            this_y[2*i+1] = (T) imag[j];
+        }
+    });
 }
 void GridFourier::evaluateHierarchicalFunctionsInternal(const double x[], int num_x, Data2D<double> &wreal, Data2D<double> &wimag) const{
     // when performing internal evaluations, split the matrix into real and complex components
     // thus only two real gemm() operations can be used (as opposed to one complex gemm)
     int num_points = getNumPoints();
-    Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
     wreal.resize(num_points, num_x);
     wimag.resize(num_points, num_x);
-    #pragma omp parallel for
-    for(int i=0; i<num_x; i++){
-        computeBasis<double, false>(((points.empty()) ? needed : points), xwrap.getStrip(i), wreal.getStrip(i), wimag.getStrip(i));
-    }
+    walkBasisBlocks(((points.empty()) ? needed : points), num_x, x, [&](int first, int num_block, int i, const double real[], const double imag[])->void{
+        for(int j=0; j<num_block; j++){
+            wreal.getStrip(first + j)[i] = real[j];
+            wimag.getStrip(first + j)[i] = imag[j];
+        }
+    });
 }
 
 void GridFourier::setHierarchicalCoefficients(const double c[], TypeAcceleration){
-    // takes c to be length 2*num_outputs*num_points
-    // first num_points*num_outputs are the real part; second num_points*num_outputs are the imaginary part
+    // takes c to be length 2*num_outputs*num_points, in the same layout as getFourierCoefs()
+    // default layout: first num_points*num_outputs are the real part; second num_points*num_outputs are the imaginary part
+    // interleaved layout: the real part and the imaginary part of each point alternate
 
     clearAccelerationData();
     if (points.empty()){
@@ -517,6 +666,7 @@ void GridFourier::clearAccelerationData(){
     #ifdef Tasmanian_ENABLE_CUDA
     cuda_cache.reset();
     #endif
+    clearFloatCoefficients();
 }
 void GridFourier::clearRefinement(){ return; }     // to be expanded later
 void GridFourier::mergeRefinement(){ return; }     // to be expanded later
@@ -64,9 +64,11 @@ public:
 
     void evaluate(const double x[], double y[]) const;
     void evaluateBatch(const double x[], int num_x, double y[]) const;
+    void evaluateBatch(const double x[], int num_x, float y[]) const;
 
     #ifdef Tasmanian_ENABLE_BLAS
     void evaluateBlas(const double x[], int num_x, double y[]) const;
+    void evaluateBlas(const double x[], int num_x, float y[]) const;
     #endif
 
     #ifdef Tasmanian_ENABLE_CUDA
@@ -79,6 +81,7 @@ public:
     void integrate(double q[], double *conformal_correction) const;
 
     void evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const;
+    void evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const;
     void evaluateHierarchicalFunctionsInternal(const double x[], int num_x, Data2D<double> &wreal, Data2D<double> &wimag) const;
     void setHierarchicalCoefficients(const double c[], TypeAcceleration acc);
 
@@ -92,8 +95,18 @@ public:
     void mergeRefinement();
 
     const int* getPointIndexes() const;
+    //! \brief Returns the coefficients in the current layout, i.e., the interleaved layout if enabled with setInterleavedCoefficients().
     const double* getFourierCoefs() const;
 
+    /*!
+     * \brief If enabled, the coefficients are stored so that the real and imaginary parts of each basis function are next to each other.
+     *
+     * The layout applies to both getFourierCoefs() and setHierarchicalCoefficients() and is kept by copyGrid(),
+     * only the order of the entries changes, the values of the real and imaginary parts are the same in both layouts,
+     * the files always use the default layout and read() resets the option.
+     */
+    void setInterleavedCoefficients(bool interleave);
+
 protected:
     void reset();
     void calculateFourierCoefficients();
@@ -137,6 +150,53 @@ protected:
         }
     }
 
+    //! \brief Number of points handled together by walkBasisBlock().
+    static constexpr int basis_block_size = 32;
+
+    /*!
+     * \brief Computes the basis functions for a block of \b num_x points and calls \b apply(i, real, imag) for each index \b i in \b work.
+     *
+     * The \b real and \b imag arrays have size \b num_x and hold the values of basis function \b i at the points.
+     * The one dimensional exponents are computed with a complex recurrence (i.e., one complex multiplication per frequency)
+     * vectorized across the points, hence the trigonometric functions are called only once per point and dimension.
+     * The multi-indexes in \b work are sorted, the partial products over the leading dimensions are kept
+     * and only the entries that differ from the previous multi-index are multiplied again.
+     */
+    template<typename callable> void walkBasisBlock(const MultiIndexSet &work, int num_x, const double x[], callable apply) const;
+
+    /*!
+     * \brief Splits \b x into blocks and calls walkBasisBlock() for each block in parallel.
+     *
+     * The \b apply(first, num_block, i, real, imag) receives the index of the \b first point in the block,
+     * the number of points in the block, the index of the basis function and the values at the points of the block.
+     */
+    template<typename callable> void walkBasisBlocks(const MultiIndexSet &work, int num_x, const double x[], callable apply) const;
+    /*!
+     * \brief Returns the coefficients used in the contraction with the basis, i.e., \b fourier_coefs in the current layout.
+     *
+     * The default layout holds the real parts of all basis functions followed by the imaginary parts,
+     * the interleaved layout holds the real part of each basis function followed by the imaginary part,
+     * in both cases evaluateFusedBasis() gives the matching basis and a single real product computes Re(coefficients times basis).
+     */
+    const double* getContractionCoefficients() const;
+    //! \brief Returns a copy of \b fourier_coefs converted to the interleaved layout or back to the default one, \b fourier_coefs must be in the other layout.
+    Data2D<double> reorderCoefficients(bool to_interleaved) const;
+    /*!
+     * \brief Computes the basis matching getContractionCoefficients(), \b w has strips of size twice the number of points, one strip per point in \b x.
+     *
+     * The default layout has the real parts followed by the negative imaginary parts,
+     * the interleaved layout alternates the real and the negative imaginary parts.
+     */
+    template<typename T> void evaluateFusedBasis(const double x[], int num_x, Data2D<T> &w) const;
+    //! \brief Implements evaluateBatch() for double and float outputs, \b coeff is either getContractionCoefficients() or the single precision copy.
+    template<typename T> void evaluateBatchTempl(const double x[], int num_x, const T coeff[], T y[]) const;
+    #ifdef Tasmanian_ENABLE_BLAS
+    //! \brief Implements evaluateBlas() for double and float, uses a single BLAS product over the real and imaginary parts.
+    template<typename T> void evaluateBlasTempl(const double x[], int num_x, const T coeff[], T y[]) const;
+    #endif
+    //! \brief Implements evaluateHierarchicalFunctions() for double and float outputs.
+    template<typename T> void evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const;
+
     #ifdef Tasmanian_ENABLE_CUDA
     void loadCudaNodes() const{
         if (!cuda_cache) cuda_cache = std::unique_ptr<CudaFourierData<double>>(new CudaFourierData<double>);
@@ -165,13 +225,21 @@ protected:
         if (!cuda_cache->real.empty()) return;
         int num_points = points.getNumIndexes();
         size_t num_coeff = ((size_t) num_outputs) * ((size_t) num_points);
-        cuda_cache->real.load(num_coeff, fourier_coefs.getStrip(0));
-        cuda_cache->imag.load(num_coeff, fourier_coefs.getStrip(num_points));
+        Data2D<double> reordered;
+        if (interleaved) reordered = reorderCoefficients(false); // the kernels use the default layout
+        Data2D<double> const &coefs = (interleaved) ? reordered : fourier_coefs;
+        cuda_cache->real.load(num_coeff, coefs.getStrip(0));
+        cuda_cache->imag.load(num_coeff, coefs.getStrip(num_points));
+    }
+    void loadCudaFusedCoefficients() const{ // matches evaluateFusedBasis(), used when the basis is computed on the CPU
+        if (!cuda_cache) cuda_cache = std::unique_ptr<CudaFourierData<double>>(new CudaFourierData<double>);
+        if (cuda_cache->fused.empty()) cuda_cache->fused.load(fourier_coefs.getTotalEntries(), getContractionCoefficients());
     }
     void clearCudaCoefficients(){
         if (cuda_cache){
             cuda_cache->real.clear();
             cuda_cache->imag.clear();
+            cuda_cache->fused.clear();
         }
     }
     #endif
@@ -186,6 +254,8 @@ private:
 
     Data2D<double> fourier_coefs;
 
+    bool interleaved;
+
     StorageSet values;
 
     std::vector<int> max_power;
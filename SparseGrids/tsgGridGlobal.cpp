@@ -370,6 +370,7 @@ void GridGlobal::loadNeededPoints(const double *vals){
     #ifdef Tasmanian_ENABLE_CUDA
     cuda_values.clear();
     #endif
+    clearFloatCoefficients();
     if (points.empty() || needed.empty()){
         values.setValues(vals);
     }else{
@@ -379,6 +380,7 @@ void GridGlobal::loadNeededPoints(const double *vals){
 }
 void GridGlobal::mergeRefinement(){
     if (needed.empty()) return; // nothing to do
+    clearFloatCoefficients();
     int num_all_points = getNumLoaded() + getNumNeeded();
     values.setValues(std::vector<double>(Utils::size_mult(num_outputs, num_all_points), 0.0));
     acceptUpdatedTensors();
@@ -533,43 +535,74 @@ void GridGlobal::loadConstructedPoint(const double x[], const std::vector<double
         loadConstructedTensors();
     }
 }
+void GridGlobal::loadConstructedPoints(const double x[], int num_x, const double y[]){
+    NodeIndexLookup lookup([&](int i)->double{ return wrapper.getNode(i); }, wrapper.getNumNodes(), wrapper.getNumNodes());
+    std::vector<int> pnts = lookup.getIndexes((size_t) num_dimensions, num_x, x);
+    Utils::Wrapper2D<int const> pwrap(num_dimensions, pnts.data());
+    Utils::Wrapper2D<double const> ywrap(num_outputs, y);
+
+    bool any_complete = false;
+    for(int i=0; i<num_x; i++){
+        if (dynamic_values->addNewNode(std::vector<int>(pwrap.getStrip(i), pwrap.getStrip(i) + num_dimensions),
+                                       std::vector<double>(ywrap.getStrip(i), ywrap.getStrip(i) + num_outputs)))
+            any_complete = true;
+    }
+    if (any_complete) loadConstructedTensors(); // merge all complete tensors at once
+}
 void GridGlobal::loadConstructedTensors(){
-    #ifdef Tasmanian_ENABLE_CUDA
-    cuda_values.clear();
-    #endif
-    std::vector<int> tensor;
-    MultiIndexSet new_points;
-    std::vector<double> new_values;
-    bool added_any = false;
-    while(dynamic_values->ejectCompleteTensor(tensors, tensor, new_points, new_values)){
-        if (points.empty()){
-            values.setValues(std::move(new_values));
-            points = std::move(new_points);
-        }else{
-            values.addValues(points, new_points, new_values.data());
-            points.addMultiIndexSet(new_points);
+    // with concurrent calls to loadConstructedPoint(), only one thread at a time merges the complete tensors into the grid
+    dynamic_values->mergeCompleteTensors([&]()->void{
+        #ifdef Tasmanian_ENABLE_CUDA
+        cuda_values.clear();
+        #endif
+        clearFloatCoefficients();
+        std::vector<int> tensor;
+        MultiIndexSet tensor_points, new_points;
+        std::vector<double> tensor_values;
+        StorageSet new_values;
+        bool added_any = false;
+        while(dynamic_values->ejectCompleteTensor(tensors, tensor, tensor_points, tensor_values)){
+            // collect the points of all complete tensors, the grid values are merged once at the end
+            if (new_points.empty()){
+                new_values.resize(num_outputs, tensor_points.getNumIndexes());
+                new_values.setValues(std::move(tensor_values));
+                new_points = std::move(tensor_points);
+            }else if (!tensor_points.empty()){
+                new_values.addValues(new_points, tensor_points, tensor_values.data());
+                new_points.addMultiIndexSet(tensor_points);
+            }
+
+            if (tensors.empty()){
+                tensors = MultiIndexSet((size_t) num_dimensions, std::move(tensor));
+            }else{
+                tensors.addSortedIndexes(tensor);
+            }
+            added_any = true;
         }
 
-        if (tensors.empty()){
-            tensors = MultiIndexSet((size_t) num_dimensions, std::move(tensor));
-        }else{
-            tensors.addSortedIndexes(tensor);
+        if (!new_points.empty()){
+            if (points.empty()){
+                values.setValues(std::move(new_values.getVector()));
+                points = std::move(new_points);
+            }else{
+                values.addValues(points, new_points, new_values.getValues(0));
+                points.addMultiIndexSet(new_points);
+            }
         }
-        added_any = true;
-    }
 
-    if (added_any){
-        std::vector<int> tensors_w = MultiIndexManipulations::computeTensorWeights(tensors);
-        active_tensors = MultiIndexManipulations::createActiveTensors(tensors, tensors_w);
+        if (added_any){
+            std::vector<int> tensors_w = MultiIndexManipulations::computeTensorWeights(tensors);
+            active_tensors = MultiIndexManipulations::createActiveTensors(tensors, tensors_w);
 
-        active_w = std::vector<int>();
-        active_w.reserve(active_tensors.getNumIndexes());
-        for(auto w : tensors_w) if (w != 0) active_w.push_back(w);
+            active_w = std::vector<int>();
+            active_w.reserve(active_tensors.getNumIndexes());
+            for(auto w : tensors_w) if (w != 0) active_w.push_back(w);
 
-        max_levels = MultiIndexManipulations::getMaxIndexes(active_tensors);
+            max_levels = MultiIndexManipulations::getMaxIndexes(active_tensors);
 
-        recomputeTensorRefs(points);
-    }
+            recomputeTensorRefs(points);
+        }
+    });
 }
 void GridGlobal::finishConstruction(){
     dynamic_values = std::unique_ptr<DynamicConstructorDataGlobal>();
@@ -591,11 +624,115 @@ void GridGlobal::evaluate(const double x[], double y[]) const{
     }
 }
 void GridGlobal::evaluateBatch(const double x[], int num_x, double y[]) const{
+    evaluateBatchTempl<double>(x, num_x, values.getValues(0), y);
+}
+void GridGlobal::evaluateBatch(const double x[], int num_x, float y[]) const{
+    evaluateBatchTempl<float>(x, num_x, getFloatCoefficients(values.getValues(0), values.getTotalEntries()), y);
+}
+template<typename T>
+void GridGlobal::evaluateBatchTempl(const double x[], int num_x, const T coeff[], T y[]) const{
+    // split the points into blocks, each block is handled as a whole by a single thread
+    constexpr int max_block_size = 32;
+    int num_blocks = num_x / max_block_size + ((num_x % max_block_size == 0) ? 0 : 1);
     Utils::Wrapper2D<const double> xwrap(num_dimensions, x);
-    Utils::Wrapper2D<double> ywrap(num_outputs, y);
-    #pragma omp parallel for
-    for(int i=0; i<num_x; i++)
-        evaluate(xwrap.getStrip(i), ywrap.getStrip(i));
+    Utils::Wrapper2D<T> ywrap(num_outputs, y);
+
+    // the tensor-by-tensor algorithm accumulates the outputs once per tensor point, while the interpolation weights
+    // accumulate the outputs once per grid point but the tensor products are computed in full (with integer division to find the
+    // local indexes) and written to a scattered vector
+    // the nodes of nested rules are shared between many tensors and the weights can be cheaper for large number of outputs
+    double num_tensor_points = 0.0;
+    for(auto const &refs : tensor_refs) num_tensor_points += (double) refs.size();
+    double num_points = (double) points.getNumIndexes();
+    bool use_tensors = (num_tensor_points * (double) (num_outputs + 2) < num_tensor_points * (double) (2 * num_dimensions) + num_points * (double) (num_outputs + 1));
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int b=0; b<num_blocks; b++){
+        int block_start = b * max_block_size;
+        int block_size = std::min(max_block_size, num_x - block_start);
+        if (use_tensors){
+            evaluateBlock<T>(xwrap.getStrip(block_start), block_size, coeff, ywrap.getStrip(block_start));
+        }else{
+            std::vector<double> w(points.getNumIndexes());
+            for(int i=block_start; i<block_start + block_size; i++){
+                getInterpolationWeights(xwrap.getStrip(i), w.data());
+                T *this_y = ywrap.getStrip(i);
+                std::fill_n(this_y, num_outputs, 0.0);
+                for(int j=0; j<points.getNumIndexes(); j++){
+                    const T *v = &(coeff[Utils::size_mult(j, num_outputs)]);
+                    T wj = (T) w[j];
+                    for(int k=0; k<num_outputs; k++) this_y[k] += wj * v[k];
+                }
+            }
+        }
+    }
+}
+template<typename callable>
+void GridGlobal::walkTensorsBlock(const CacheLagrangeBlock<double> &lcache, callable apply) const{
+    int num_x = lcache.getNumX();
+    // partial[j] holds the products of the tensor weight and the Lagrange polynomials for directions 0 ... j
+    // the tensor points are visited in lexicographical order, when index p[j] changes only partial[j] ... partial[d-1] are recomputed
+    Data2D<double> partial(num_x, num_dimensions);
+    std::vector<int> num_oned_points(num_dimensions), p(num_dimensions);
+
+    for(int n=0; n<active_tensors.getNumIndexes(); n++){
+        const int* levels = active_tensors.getIndex(n);
+        for(int j=0; j<num_dimensions; j++) num_oned_points[j] = wrapper.getNumPoints(levels[j]);
+        double tensor_weight = (double) active_w[n];
+        const int *refs = tensor_refs[n].data();
+
+        std::fill(p.begin(), p.end(), 0);
+        int j = 0; // first direction that has to be recomputed
+        int i = 0; // index of the tensor point
+        while(j >= 0){
+            for(; j<num_dimensions; j++){
+                double *w = partial.getStrip(j);
+                const double *l = lcache.getLagrange(j, levels[j], p[j]);
+                if (j == 0){
+                    #pragma omp simd
+                    for(int k=0; k<num_x; k++) w[k] = tensor_weight * l[k];
+                }else{
+                    const double *wprev = partial.getStrip(j - 1);
+                    #pragma omp simd
+                    for(int k=0; k<num_x; k++) w[k] = wprev[k] * l[k];
+                }
+            }
+
+            apply(refs[i++], partial.getStrip(num_dimensions - 1));
+
+            j = num_dimensions - 1;
+            while((j >= 0) && (++p[j] == num_oned_points[j])) p[j--] = 0;
+        }
+    }
+}
+
+template<typename T>
+void GridGlobal::evaluateBlock(const double x[], int num_x, const T coeff[], T y[]) const{
+    std::fill_n(y, Utils::size_mult(num_x, num_outputs), 0.0);
+
+    CacheLagrangeBlock<double> lcache(num_dimensions, max_levels, wrapper, num_x, x);
+
+    walkTensorsBlock(lcache, [&](int point, const double w[])->void{
+        const T *v = &(coeff[Utils::size_mult(point, num_outputs)]);
+        for(int k=0; k<num_x; k++){
+            T *this_y = &(y[Utils::size_mult(k, num_outputs)]);
+            T wk = (T) w[k];
+            #pragma omp simd
+            for(int o=0; o<num_outputs; o++) this_y[o] += wk * v[o];
+        }
+    });
+}
+
+template<typename T>
+void GridGlobal::evaluateHierarchicalBlock(const double x[], int num_x, T y[]) const{
+    int num_points = (points.empty()) ? needed.getNumIndexes() : points.getNumIndexes();
+    std::fill_n(y, Utils::size_mult(num_x, num_points), 0.0);
+
+    CacheLagrangeBlock<double> lcache(num_dimensions, max_levels, wrapper, num_x, x);
+
+    walkTensorsBlock(lcache, [&](int point, const double w[])->void{
+        for(int k=0; k<num_x; k++) y[Utils::size_mult(k, num_points) + point] += (T) w[k];
+    });
 }
 
 #ifdef Tasmanian_ENABLE_BLAS
@@ -610,6 +747,14 @@ void GridGlobal::evaluateBlas(const double x[], int num_x, double y[]) const{
 
     TasBLAS::denseMultiply(num_outputs, num_x, num_points, 1.0, values.getValues(0), weights.getStrip(0), 0.0, y);
 }
+void GridGlobal::evaluateBlas(const double x[], int num_x, float y[]) const{
+    const float *coeff = getFloatCoefficients(values.getValues(0), values.getTotalEntries());
+    int num_points = points.getNumIndexes();
+    Data2D<float> weights(num_points, num_x);
+    evaluateHierarchicalFunctionsTempl<float>(x, num_x, weights.getStrip(0));
+
+    TasBLAS::denseMultiply(num_outputs, num_x, num_points, 1.0f, coeff, weights.getStrip(0), 0.0f, y);
+}
 #endif // Tasmanian_ENABLE_BLAS
 
 #ifdef Tasmanian_ENABLE_CUDA
@@ -617,7 +762,7 @@ void GridGlobal::loadNeededPointsCuda(CudaEngine *, const double *vals){
     loadNeededPoints(vals);
 }
 void GridGlobal::evaluateCudaMixed(CudaEngine *engine, const double x[], int num_x, double y[]) const{
-    if (cuda_values.size() == 0) cuda_values.load(values.getVector());
+    if (cuda_values.size() == 0) cuda_values.load(values.getTotalEntries(), values.getValues(0));
 
     int num_points = points.getNumIndexes();
     Data2D<double> weights(num_points, num_x);
@@ -646,12 +791,23 @@ void GridGlobal::integrate(double q[], double *conformal_correction) const{
 }
 
 void GridGlobal::evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const{
+    evaluateHierarchicalFunctionsTempl<double>(x, num_x, y);
+}
+void GridGlobal::evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const{
+    evaluateHierarchicalFunctionsTempl<float>(x, num_x, y);
+}
+template<typename T>
+void GridGlobal::evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const{
+    constexpr int max_block_size = 32;
     int num_points = (points.empty()) ? needed.getNumIndexes() : points.getNumIndexes();
+    int num_blocks = num_x / max_block_size + ((num_x % max_block_size == 0) ? 0 : 1);
     Utils::Wrapper2D<const double> xwrap(num_dimensions, x);
-    Utils::Wrapper2D<double> ywrap(num_points, y);
-    #pragma omp parallel for
-    for(int i=0; i<num_x; i++)
-        getInterpolationWeights(xwrap.getStrip(i), ywrap.getStrip(i));
+    Utils::Wrapper2D<T> ywrap(num_points, y);
+    #pragma omp parallel for schedule(dynamic)
+    for(int b=0; b<num_blocks; b++){
+        int block_start = b * max_block_size;
+        evaluateHierarchicalBlock<T>(xwrap.getStrip(block_start), std::min(max_block_size, num_x - block_start), ywrap.getStrip(block_start));
+    }
 }
 
 std::vector<double> GridGlobal::computeSurpluses(int output, bool normalize) const{
@@ -870,6 +1026,7 @@ void GridGlobal::clearAccelerationData(){
     #ifdef Tasmanian_ENABLE_CUDA
     cuda_values.clear();
     #endif
+    clearFloatCoefficients();
 }
 
 MultiIndexSet GridGlobal::getPolynomialSpaceSet(bool interpolation) const{
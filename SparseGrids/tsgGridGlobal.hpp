@@ -73,9 +73,11 @@ public:
     void integrate(double q[], double *conformal_correction) const;
 
     void evaluateBatch(const double x[], int num_x, double y[]) const;
+    void evaluateBatch(const double x[], int num_x, float y[]) const;
 
     #ifdef Tasmanian_ENABLE_BLAS
     void evaluateBlas(const double x[], int num_x, double y[]) const;
+    void evaluateBlas(const double x[], int num_x, float y[]) const;
     #endif
 
     #ifdef Tasmanian_ENABLE_CUDA
@@ -101,9 +103,11 @@ public:
     std::vector<double> getCandidateConstructionPoints(TypeDepth type, int output, const std::vector<int> &level_limits);
     std::vector<double> getCandidateConstructionPoints(std::function<double(const int *)> getTensorWeight, const std::vector<int> &level_limits);
     void loadConstructedPoint(const double x[], const std::vector<double> &y);
+    void loadConstructedPoints(const double x[], int num_x, const double y[]);
     void finishConstruction();
 
     void evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const;
+    void evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const;
     void setHierarchicalCoefficients(const double c[], TypeAcceleration acc);
 
     void clearAccelerationData();
@@ -123,6 +127,14 @@ protected:
     MultiIndexSet selectTensors(size_t dims, int depth, TypeDepth type, const std::vector<int> &anisotropic_weights,
                                 TypeOneDRule rule, std::vector<int> const &level_limits) const;
 
+    // visits all active tensor points and calls apply(point, w), where w are the weights of the point for each x in the cache block
+    template<typename callable> void walkTensorsBlock(const CacheLagrangeBlock<double> &lcache, callable apply) const;
+    // the templates work with either double or float outputs, coeff is either the values or the single precision copy
+    template<typename T> void evaluateBatchTempl(const double x[], int num_x, const T coeff[], T y[]) const;
+    template<typename T> void evaluateBlock(const double x[], int num_x, const T coeff[], T y[]) const; // tensor-by-tensor evaluation of a block of points, bypasses getInterpolationWeights()
+    template<typename T> void evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const;
+    template<typename T> void evaluateHierarchicalBlock(const double x[], int num_x, T y[]) const; // interpolation weights for a block of points
+
     void recomputeTensorRefs(const MultiIndexSet &work);
     void proposeUpdatedTensors();
     void acceptUpdatedTensors();
@@ -34,9 +34,13 @@
 #include "tsgGridLocalPolynomial.hpp"
 #include "tsgHiddenExternals.hpp"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace TasGrid{
 
-GridLocalPolynomial::GridLocalPolynomial() : order(1), top_level(0), sparse_affinity(0)  {}
+GridLocalPolynomial::GridLocalPolynomial() : order(1), top_level(0), sparse_affinity(0), level_affinity(0), use_support_index(false)  {}
 GridLocalPolynomial::~GridLocalPolynomial(){}
 
 void GridLocalPolynomial::reset(bool clear_rule){
@@ -48,6 +52,9 @@ void GridLocalPolynomial::reset(bool clear_rule){
     if (clear_rule){ rule = std::unique_ptr<BaseRuleLocalPolynomial>(); order = 1; }
     parents = Data2D<int>();
     sparse_affinity = 0;
+    level_affinity = 0;
+    use_support_index = false;
+    support_index.reset();
     surpluses.clear();
 }
 template<class T> std::unique_ptr<T> make_unique_ptr(){ return std::unique_ptr<T>(new T()); } // in C++14 this is called std::make_unique()
@@ -73,28 +80,30 @@ template<bool useAscii> void GridLocalPolynomial::write(std::ostream &os) const{
     IO::writeRule<useAscii>(rule->getType(), os);
     IO::writeFlag<useAscii, IO::pad_auto>(!points.empty(), os);
     if (!points.empty()) points.write<useAscii>(os);
+    // the compressed format groups the surpluses and values by level
+    std::vector<int> levels = (IO::isCompressedFormat(os)) ? HierarchyManipulations::computeLevels(points, rule.get()) : std::vector<int>();
     if (useAscii){ // backwards compatible: surpluses and needed, or needed and surpluses
         IO::writeFlag<useAscii, IO::pad_auto>((surpluses.getNumStrips() != 0), os);
-        if (surpluses.getNumStrips() != 0) IO::writeVector<useAscii, IO::pad_line>(surpluses.getVector(), os);
+        if (surpluses.getNumStrips() != 0) IO::writeData2D<useAscii, IO::pad_line>(surpluses, os);
         IO::writeFlag<useAscii, IO::pad_auto>(!needed.empty(), os);
         if (!needed.empty()) needed.write<useAscii>(os);
     }else{
         IO::writeFlag<useAscii, IO::pad_auto>(!needed.empty(), os);
         if (!needed.empty()) needed.write<useAscii>(os);
         IO::writeFlag<useAscii, IO::pad_auto>((surpluses.getNumStrips() != 0), os);
-        if (surpluses.getNumStrips() != 0) IO::writeVector<useAscii, IO::pad_line>(surpluses.getVector(), os);
+        if (surpluses.getNumStrips() != 0) IO::writeLevelData2D<useAscii, IO::pad_line>(surpluses, levels, os);
     }
     IO::writeFlag<useAscii, IO::pad_auto>((parents.getNumStrips() != 0), os);
-    if (parents.getNumStrips() != 0) IO::writeVector<useAscii, IO::pad_line>(parents.getVector(), os);
+    if (parents.getNumStrips() != 0) IO::writeData2D<useAscii, IO::pad_line>(parents, os);
 
     IO::writeNumbers<useAscii, IO::pad_rspace>(os, (int) roots.size());
     if (roots.size() > 0){ // the tree is empty, can happend when using dynamic construction
         IO::writeVector<useAscii, IO::pad_line>(roots, os);
-        IO::writeVector<useAscii, IO::pad_line>(pntr, os);
-        IO::writeVector<useAscii, IO::pad_line>(indx, os);
+        IO::writeChunkableArray<useAscii, IO::pad_line>(pntr.data(), pntr.size(), os);
+        IO::writeChunkableArray<useAscii, IO::pad_line>(indx.data(), indx.size(), os);
     }
 
-    if (num_outputs > 0) values.write<useAscii>(os);
+    if (num_outputs > 0) values.write<useAscii>(os, levels);
 }
 
 template<bool useAscii> void GridLocalPolynomial::read(std::istream &is){
@@ -107,6 +116,7 @@ template<bool useAscii> void GridLocalPolynomial::read(std::istream &is){
     makeRule(crule);
 
     if (IO::readFlag<useAscii>(is)) points.read<useAscii>(is);
+    std::vector<int> levels = (IO::isCompressedFormat(is)) ? HierarchyManipulations::computeLevels(points, rule.get()) : std::vector<int>();
     if (useAscii){ // backwards compatible: surpluses and needed, or needed and surpluses
         if (IO::readFlag<useAscii>(is))
             surpluses = IO::readData2D<useAscii, double>(is, num_outputs, points.getNumIndexes());
@@ -114,7 +124,7 @@ template<bool useAscii> void GridLocalPolynomial::read(std::istream &is){
     }else{
         if (IO::readFlag<useAscii>(is)) needed.read<useAscii>(is);
         if (IO::readFlag<useAscii>(is))
-            surpluses = IO::readData2D<useAscii, double>(is, num_outputs, points.getNumIndexes());
+            surpluses = IO::readLevelData2D<useAscii>(is, num_outputs, points.getNumIndexes(), levels);
     }
     if (IO::readFlag<useAscii>(is))
         parents = IO::readData2D<useAscii, int>(is, rule->getMaxNumParents() * num_dimensions, points.getNumIndexes());
@@ -123,18 +133,12 @@ template<bool useAscii> void GridLocalPolynomial::read(std::istream &is){
     roots.resize((size_t) IO::readNumber<useAscii, int>(is));
     if (roots.size() > 0){
         IO::readVector<useAscii>(is, roots);
-        pntr.resize(num_points + 1);
-        IO::readVector<useAscii>(is, pntr);
-        if (pntr[num_points] > 0){
-            indx.resize((size_t) pntr[num_points]);
-            IO::readVector<useAscii>(is, indx);
-        }else{
-            indx.resize(1);
-            indx[0] = IO::readNumber<useAscii, int>(is); // there is a special case when the grid has only one point without any children
-        }
+        IO::readChunkableVector<useAscii>(is, num_points + 1, pntr);
+        // there is a special case when the grid has only one point without any children, then indx has one entry
+        IO::readChunkableVector<useAscii>(is, (pntr[num_points] > 0) ? (size_t) pntr[num_points] : 1, indx);
     }
 
-    if (num_outputs > 0) values.read<useAscii>(is);
+    if (num_outputs > 0) values.read<useAscii>(is, levels);
 }
 
 template void GridLocalPolynomial::write<true>(std::ostream &) const;
@@ -186,14 +190,13 @@ void GridLocalPolynomial::copyGrid(const GridLocalPolynomial *pwpoly){
     values = pwpoly->values;
 
     if ((!points.empty()) && (num_outputs > 0)){ // points are loaded
-        surpluses.resize(num_outputs, points.getNumIndexes());
-        surpluses.getVector() = pwpoly->surpluses.getVector(); // copy assignment
+        surpluses = pwpoly->surpluses; // copy assignment, views of mapped files are shared
     }
 }
 
 GridLocalPolynomial::GridLocalPolynomial(int cnum_dimensions, int cnum_outputs, int corder, TypeOneDRule crule,
                                          std::vector<int> &&pnts, std::vector<double> &&vals, std::vector<double> &&surps) :
-                                         order(corder), sparse_affinity(0){
+                                         order(corder), sparse_affinity(0), level_affinity(0), use_support_index(false){
 
     num_dimensions = cnum_dimensions;
     num_outputs = cnum_outputs;
@@ -236,6 +239,15 @@ void GridLocalPolynomial::getPoints(double *x) const{
     if (points.empty()){ getNeededPoints(x); }else{ getLoadedPoints(x); }
 }
 
+GridLocalPolynomial::TreeWalkWorkspace& GridLocalPolynomial::getTreeWalkWorkspace() const{
+    static thread_local TreeWalkWorkspace workspace;
+    if (workspace.monkey_count.size() < (size_t) (top_level + 1)){
+        workspace.monkey_count.resize((size_t) (top_level + 1));
+        workspace.monkey_tail.resize((size_t) (top_level + 1));
+    }
+    return workspace;
+}
+
 void GridLocalPolynomial::evaluate(const double x[], double y[]) const{
     std::fill_n(y, num_outputs, 0.0);
     std::vector<int> sindx; // dummy variables, never references in mode 0 below
@@ -244,101 +256,260 @@ void GridLocalPolynomial::evaluate(const double x[], double y[]) const{
 }
 void GridLocalPolynomial::evaluateBatch(const double x[], int num_x, double y[]) const{
     if (num_x == 1){ evaluate(x, y); return; }
+    if (num_outputs > tiled_min_outputs){ // many outputs, use the tiled sparse kernel
+        evaluateSparseBasis<double>(x, num_x, surpluses.getStrip(0), y, false);
+        return;
+    }
     Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
     Utils::Wrapper2D<double> ywrap(num_outputs, y);
+    if ((num_x >= tree_block_size) && !support_index){ // push blocks of points down the tree together
+        int num_blocks = (num_x + tree_block_size - 1) / tree_block_size;
+        #pragma omp parallel for schedule(dynamic)
+        for(int b=0; b<num_blocks; b++)
+            evaluateTreeBlock<double>(xwrap.getStrip(b * tree_block_size), std::min(num_x - b * tree_block_size, (int) tree_block_size),
+                                      surpluses.getStrip(0), ywrap.getStrip(b * tree_block_size));
+        return;
+    }
     #pragma omp parallel for
     for(int i=0; i<num_x; i++)
         evaluate(xwrap.getStrip(i), ywrap.getStrip(i));
 }
-
-#ifdef Tasmanian_ENABLE_BLAS
-void GridLocalPolynomial::evaluateBlas(const double x[], int num_x, double y[]) const{
-    if ((sparse_affinity == 1) || ((sparse_affinity == 0) && (num_outputs <= 1024))){
-        evaluateBatch(x, num_x, y);
+void GridLocalPolynomial::evaluateBatch(const double x[], int num_x, float y[]) const{
+    // the tree is walked in double precision, only the accumulation with the surpluses uses the single precision copy
+    const float *coeff = getFloatCoefficients(surpluses.getStrip(0), surpluses.getTotalEntries());
+    if ((num_x > 1) && (num_outputs > tiled_min_outputs)){
+        evaluateSparseBasis<float>(x, num_x, coeff, y, false);
         return;
     }
-
-    std::vector<int> sindx, spntr;
-    std::vector<double> svals;
-    buildSpareBasisMatrix(x, num_x, 32, spntr, sindx, svals); // build sparse matrix corresponding to x
-
-    int num_points = points.getNumIndexes();
-    double nnz = (double) spntr[num_x];
-    double total_size = ((double) num_x) * ((double) num_points);
-
-    if ((sparse_affinity == -1) || ((sparse_affinity == 0) && (nnz / total_size > 0.1))){
-        // potentially wastes a lot of memory
-        Data2D<double> A(num_points, num_x, 0.0);
-        for(int i=0; i<num_x; i++){
-            double *row = A.getStrip(i);
-            for(int j=spntr[i]; j<spntr[i+1]; j++) row[sindx[j]] = svals[j];
-        }
-        TasBLAS::denseMultiply(num_outputs, num_x, num_points, 1.0, surpluses.getStrip(0), A.getStrip(0), 0.0, y);
-    }else{
-        Utils::Wrapper2D<double> ywrap(num_outputs, y);
-        #pragma omp parallel for
+    Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
+    Utils::Wrapper2D<float> ywrap(num_outputs, y);
+    if ((num_x >= tree_block_size) && !support_index){
+        int num_blocks = (num_x + tree_block_size - 1) / tree_block_size;
+        #pragma omp parallel for schedule(dynamic)
+        for(int b=0; b<num_blocks; b++)
+            evaluateTreeBlock<float>(xwrap.getStrip(b * tree_block_size), std::min(num_x - b * tree_block_size, (int) tree_block_size),
+                                     coeff, ywrap.getStrip(b * tree_block_size));
+        return;
+    }
+    #pragma omp parallel
+    {
+        std::vector<int> sindx;
+        std::vector<double> svals;
+        #pragma omp for
         for(int i=0; i<num_x; i++){
-            double *this_y = ywrap.getStrip(i);
-            std::fill(this_y, this_y + num_outputs, 0.0);
-            for(int j=spntr[i]; j<spntr[i+1]; j++){
-                double v = svals[j];
-                const double *s = surpluses.getStrip(sindx[j]);
+            sindx.clear();
+            svals.clear();
+            walkTree<1>(points, xwrap.getStrip(i), sindx, svals, nullptr);
+            float *this_y = ywrap.getStrip(i);
+            std::fill_n(this_y, num_outputs, 0.0f);
+            for(size_t j=0; j<sindx.size(); j++){
+                float v = (float) svals[j];
+                const float *s = &(coeff[Utils::size_mult(sindx[j], num_outputs)]);
                 for(int k=0; k<num_outputs; k++) this_y[k] += v * s[k];
             }
         }
     }
 }
-#endif
 
-#ifdef Tasmanian_ENABLE_CUDA
-void GridLocalPolynomial::loadNeededPointsCuda(CudaEngine *engine, const double *vals){
-    updateValues(vals);
+template<typename T>
+void GridLocalPolynomial::evaluateTreeBlock(const double x[], int num_x, const T coeff[], T y[]) const{
+    Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
+    Utils::Wrapper2D<T> ywrap(num_outputs, y);
+    std::fill_n(y, Utils::size_mult(num_x, num_outputs), 0.0);
+
+    // active.getStrip(d) lists the points supported by the node at depth d of the traversal stack
+    Data2D<int> active(num_x, top_level + 2);
+    std::vector<int> num_active(top_level + 2);
+    std::vector<int> monkey_count(top_level + 1); // same traversal as in walkTree()
+    std::vector<int> monkey_tail(top_level + 1);
+
+    std::iota(active.getStrip(0), active.getStrip(0) + num_x, 0);
+    num_active[0] = num_x;
+
+    // tests node p against the points supported by the parent, returns the number of points in the support of p
+    auto visit = [&](int p, int depth)->int{
+        const int *parent_active = active.getStrip(depth);
+        int *node_active = active.getStrip(depth + 1);
+        const int *point = points.getIndex(p);
+        const T *s = &(coeff[Utils::size_mult(p, num_outputs)]);
+        int count = 0;
+        for(int j=0; j<num_active[depth]; j++){
+            int i = parent_active[j];
+            bool isSupported;
+            double basis_value = evalBasisSupported(point, xwrap.getStrip(i), isSupported);
+            if (isSupported){
+                node_active[count++] = i;
+                T v = (T) basis_value;
+                T *this_y = ywrap.getStrip(i);
+                for(int k=0; k<num_outputs; k++) this_y[k] += v * s[k];
+            }
+        }
+        num_active[depth + 1] = count;
+        return count;
+    };
 
-    std::vector<int> levels = HierarchyManipulations::computeLevels(points, rule.get());
+    for(const auto &r : roots){
+        if (visit(r, 0) == 0) continue;
 
-    std::vector<Data2D<int>> lpnts = HierarchyManipulations::splitByLevels((size_t) num_dimensions, points.getVector(), levels);
-    std::vector<Data2D<double>> lvals = HierarchyManipulations::splitByLevels((size_t) num_outputs, values.getVector(), levels);
+        int current = 0;
+        monkey_tail[0] = r;
+        monkey_count[0] = pntr[r];
 
-    Data2D<double> allx(num_dimensions, points.getNumIndexes());
-    getPoints(allx.getVector().data());
+        while(monkey_count[0] < pntr[monkey_tail[0]+1]){
+            if (monkey_count[current] < pntr[monkey_tail[current]+1]){
+                int p = indx[monkey_count[current]];
+                if (visit(p, current + 1) > 0){
+                    monkey_tail[++current] = p;
+                    monkey_count[current] = pntr[p];
+                }else{
+                    monkey_count[current]++;
+                }
+            }else{
+                monkey_count[--current]++;
+            }
+        }
+    }
+}
 
-    std::vector<Data2D<double>> lx = HierarchyManipulations::splitByLevels((size_t) num_dimensions, allx.getVector(), levels);
+template<typename T>
+void GridLocalPolynomial::evaluateSparseBasis(const double x[], int num_x, const T coeff[], T y[], bool allow_dense) const{
+    // the sparse basis matrix is formed for chunks of x so that the memory stays bounded,
+    // the chunk is small enough so that the dense version of the matrix fits in the memory budget
+    constexpr size_t dense_budget = 33554432; // entries of the dense matrix, i.e., 256MB in double precision
+    int num_points = points.getNumIndexes();
+    int chunk_size = (int) std::max(size_t(1), std::min(size_t(4096), dense_budget / (size_t) num_points));
+    // fall back to sparse if the dense chunk would be too small to use BLAS level 3 effectively
+    if ((sparse_affinity == 0) && (chunk_size < 32)) allow_dense = false;
 
-    MultiIndexSet cumulative_poitns((size_t) num_dimensions, std::move(lpnts[0].getVector()));
+    std::vector<int> sindx, spntr;
+    std::vector<double> svals;
+    #ifdef Tasmanian_ENABLE_BLAS
+    Data2D<T> A;
+    #endif
 
-    StorageSet cumulative_surpluses;
-    cumulative_surpluses.resize(num_outputs, cumulative_poitns.getNumIndexes());
-    cumulative_surpluses.setValues(std::move(lvals[0].getVector()));
+    for(int chunk_start=0; chunk_start<num_x; chunk_start += chunk_size){
+        int this_num_x = std::min(chunk_size, num_x - chunk_start);
+        const double *this_x = &(x[Utils::size_mult(chunk_start, num_dimensions)]);
+        T *this_y = &(y[Utils::size_mult(chunk_start, num_outputs)]);
+
+        buildSpareBasisMatrix(this_x, this_num_x, 32, spntr, sindx, svals);
+
+        bool use_dense = allow_dense && ((sparse_affinity == -1) || useDenseMultiply(this_num_x, spntr.back()));
+        #ifdef Tasmanian_ENABLE_BLAS
+        if (use_dense){
+            A.resize(num_points, this_num_x);
+            A.fill(0.0);
+            for(int i=0; i<this_num_x; i++){
+                T *row = A.getStrip(i);
+                for(int j=spntr[i]; j<spntr[i+1]; j++) row[sindx[j]] = (T) svals[j];
+            }
+            TasBLAS::denseMultiply(num_outputs, this_num_x, num_points, (T) 1.0, coeff, A.getStrip(0), (T) 0.0, this_y);
+            continue;
+        }
+        #else
+        (void) use_dense; // dense is allowed only when BLAS is available
+        #endif
+        multiplySparseBasis<T>(this_num_x, spntr, sindx, svals, coeff, this_y);
+    }
+}
 
-    for(size_t l = 1; l < lpnts.size(); l++){ // loop over the levels
-        // note that level_points.getNumIndexes() == lx[l].getNumStrips() == lvals[l].getNumStrips()
-        MultiIndexSet level_points(num_dimensions, std::move(lpnts[l].getVector()));
+bool GridLocalPolynomial::useDenseMultiply(int num_x, int num_nz) const{
+    // the BLAS dense multiply performs num_x * num_points * num_outputs operations, but it runs about dense_speedup
+    // times faster per operation than the sparse kernel which performs num_nz * num_outputs operations
+    // (measured with a single thread, the factor is higher with multi-threaded BLAS)
+    // the dense matrix must also be formed, which costs num_x * num_points operations
+    constexpr double dense_speedup = 3.0;
+    double dense_size = ((double) num_x) * ((double) points.getNumIndexes());
+    double dense_cost = dense_size * ((double) num_outputs / dense_speedup + 1.0);
+    double sparse_cost = ((double) num_nz) * ((double) num_outputs);
+    return (dense_cost < sparse_cost);
+}
 
-        GridLocalPolynomial upper_grid(num_dimensions, num_outputs, order, getRule(),
-                                       std::vector<int>(cumulative_poitns.getVector()), // copy cumulative_poitns
-                                       std::vector<double>(Utils::size_mult(num_outputs, cumulative_poitns.getNumIndexes())),  // dummy values, will not be read or used
-                                       std::vector<double>(cumulative_surpluses.getVector())); // copy the cumulative_surpluses
-        upper_grid.sparse_affinity = sparse_affinity;
+template<typename T>
+void GridLocalPolynomial::multiplySparseBasis(int num_x, std::vector<int> const &spntr, std::vector<int> &sindx, std::vector<double> &svals, const T coeff[], T y[]) const{
+    // computes y = coeff * A^T, where A is the CSR sparse basis matrix with one row for each x
+    // the rows are processed in blocks, the outputs are split into tiles so that the tile of y for the block stays in L2 cache
+    // and the points (i.e., columns of A) are split into tiles so that the matching rows of coeff stay in L2 cache
+    // and are reused by all x in the block, e.g., the coarse levels are supported everywhere
+    constexpr int block_size = 32;
+    int num_points = points.getNumIndexes();
+    int output_tile = (int) (65536 / (block_size * sizeof(T)));
+    int point_tile = (int) (262144 / (output_tile * sizeof(T)));
+    bool tile_points = (num_points > point_tile) && (num_outputs > output_tile);
+    if (!tile_points) point_tile = num_points;
+    int num_blocks = num_x / block_size + ((num_x % block_size == 0) ? 0 : 1);
 
-        Data2D<double> upper_evaluate(num_outputs, level_points.getNumIndexes());
-        int batch_size = 20000; // needs tuning
-        if (useDense()){ // dense uses lots of memory, try to keep it contained to about 4GB
-            batch_size = 536870912 / upper_grid.getNumPoints() - 2 * (num_outputs + num_dimensions);
-            if (batch_size < 100) batch_size = 100; // use at least 100 points
+    #pragma omp parallel for schedule(dynamic)
+    for(int b=0; b<num_blocks; b++){
+        int row_start = b * block_size;
+        int row_end = std::min(num_x, row_start + block_size);
+
+        if (tile_points){ // tiling requires the indexes in each row to be sorted
+            std::vector<int> map, idx;
+            std::vector<double> vls;
+            for(int r=row_start; r<row_end; r++){
+                int nz = spntr[r+1] - spntr[r];
+                map.resize(nz);
+                std::iota(map.begin(), map.end(), 0);
+                int *rindx = &(sindx[spntr[r]]);
+                double *rvals = &(svals[spntr[r]]);
+                std::sort(map.begin(), map.end(), [&](int i, int j)->bool{ return (rindx[i] < rindx[j]); });
+                idx.assign(rindx, rindx + nz);
+                vls.assign(rvals, rvals + nz);
+                for(int i=0; i<nz; i++){
+                    rindx[i] = idx[map[i]];
+                    rvals[i] = vls[map[i]];
+                }
+            }
         }
 
-        for(int i=0; i<level_points.getNumIndexes(); i += batch_size)
-            upper_grid.evaluateCuda(engine, lx[l].getStrip(i), std::min(batch_size, level_points.getNumIndexes() - i), upper_evaluate.getStrip(i));
-
-        double *level_surps = lvals[l].getStrip(0); // maybe use BLAS here
-        const double *uv = upper_evaluate.getStrip(0);
-        for(size_t i=0, s = upper_evaluate.getVector().size(); i < s; i++) level_surps[i] -= uv[i];
+        std::fill(&(y[Utils::size_mult(row_start, num_outputs)]), &(y[Utils::size_mult(row_end, num_outputs)]), 0.0);
+        std::vector<int> cursor(block_size);
+
+        for(int tile_start=0; tile_start<num_outputs; tile_start+=output_tile){
+            int tile_size = std::min(output_tile, num_outputs - tile_start);
+            for(int r=row_start; r<row_end; r++) cursor[r - row_start] = spntr[r];
+
+            for(int point_end=point_tile; point_end<num_points+point_tile; point_end+=point_tile){
+                for(int r=row_start; r<row_end; r++){
+                    T *this_y = &(y[Utils::size_mult(r, num_outputs) + tile_start]);
+                    int &c = cursor[r - row_start];
+                    while((c < spntr[r+1]) && (sindx[c] < point_end)){
+                        T v = (T) svals[c];
+                        const T *s = &(coeff[Utils::size_mult(sindx[c], num_outputs) + tile_start]);
+                        #pragma omp simd
+                        for(int k=0; k<tile_size; k++) this_y[k] += v * s[k];
+                        c++;
+                    }
+                }
+            }
+        }
+    }
+}
 
-        cumulative_surpluses.addValues(cumulative_poitns, level_points, level_surps);
-        cumulative_poitns.addMultiIndexSet(level_points);
+#ifdef Tasmanian_ENABLE_BLAS
+void GridLocalPolynomial::evaluateBlas(const double x[], int num_x, double y[]) const{
+    evaluateBlasTempl<double>(x, num_x, surpluses.getStrip(0), y);
+}
+void GridLocalPolynomial::evaluateBlas(const double x[], int num_x, float y[]) const{
+    evaluateBlasTempl<float>(x, num_x, getFloatCoefficients(surpluses.getStrip(0), surpluses.getTotalEntries()), y);
+}
+template<typename T>
+void GridLocalPolynomial::evaluateBlasTempl(const double x[], int num_x, const T coeff[], T y[]) const{
+    if ((sparse_affinity == 0) && (num_outputs <= 64)){
+        evaluateBatch(x, num_x, y); // few outputs, the cost is dominated by the tree walk and forming the matrix is not worth it
+    }else{
+        evaluateSparseBasis<T>(x, num_x, coeff, y, (sparse_affinity != 1));
     }
+}
+#endif
 
-    surpluses = Data2D<double>(num_outputs, points.getNumIndexes(), std::move(cumulative_surpluses.getVector()));
+#ifdef Tasmanian_ENABLE_CUDA
+void GridLocalPolynomial::loadNeededPointsCuda(CudaEngine *engine, const double *vals){
+    updateValues(vals);
+    recomputeSurplusesByLevel([&](GridLocalPolynomial const &upper_grid, const double x[], int num_x, double y[])->void{
+        upper_grid.evaluateCuda(engine, x, num_x, y);
+    });
 }
 void GridLocalPolynomial::evaluateCudaMixed(CudaEngine *engine, const double x[], int num_x, double y[]) const{
     loadCudaSurpluses();
@@ -388,6 +559,7 @@ void GridLocalPolynomial::updateValues(double const *vals){
     #ifdef Tasmanian_ENABLE_CUDA
     clearCudaSurpluses();
     #endif
+    clearFloatCoefficients();
     if (needed.empty()){
         values.setValues(vals);
     }else{
@@ -407,14 +579,80 @@ void GridLocalPolynomial::updateValues(double const *vals){
     }
 }
 void GridLocalPolynomial::loadNeededPoints(const double *vals){
-    updateValues(vals);
-    recomputeSurpluses();
+    if (!points.empty() && !needed.empty() && (surpluses.getNumStrips() == points.getNumIndexes()) && !useLevelSurpluses()){
+        loadNeededPointsIncremental(vals); // refined grid with valid surpluses, update only the affected points
+    }else{
+        updateValues(vals);
+        recomputeSurpluses();
+    }
+}
+void GridLocalPolynomial::loadNeededPointsIncremental(const double *vals){
+    #ifdef Tasmanian_ENABLE_CUDA
+    clearCudaSurpluses();
+    clearCudaBasisHierarchy();
+    #endif
+    clearFloatCoefficients();
+
+    // merge the surpluses in the same way as the values, the new points start with the surplus equal to the value
+    StorageSet merged_surpluses;
+    merged_surpluses.resize(num_outputs, points.getNumIndexes());
+    merged_surpluses.setValues(std::move(surpluses.getVector()));
+    merged_surpluses.addValues(points, needed, vals);
+    values.addValues(points, needed, vals);
+
+    int num_old = points.getNumIndexes();
+    int num_new = needed.getNumIndexes();
+    points.addSortedIndexes(needed.getVector());
+    int num_points = points.getNumIndexes();
+
+    // map the old indexes into the merged set and flag the new points
+    std::vector<int> old_to_new((size_t) num_old);
+    std::vector<bool> is_new((size_t) num_points, false);
+    for(int i=0, iold=0, inew=0; i<num_points; i++){
+        if ((inew < num_new) && std::equal(needed.getIndex(inew), needed.getIndex(inew) + num_dimensions, points.getIndex(i))){
+            is_new[i] = true;
+            inew++;
+        }else{
+            old_to_new[iold++] = i;
+        }
+    }
+    needed = MultiIndexSet();
+
+    surpluses = Data2D<double>(num_outputs, num_points, std::move(merged_surpluses.getVector()));
+
+    patchTree(old_to_new, is_new);
+
+    // the new points and every point that has a new point among its ancestors must be updated
+    // the dependence follows the parents used by updateSurpluses(), parents always have lower level
+    Data2D<int> dagUp = HierarchyManipulations::computeDAGup(points, rule.get());
+    std::vector<int> level = HierarchyManipulations::computeLevels(points, rule.get());
+    int max_parents = (int) dagUp.getStride();
+
+    std::vector<std::vector<int>> indexes_for_levels((size_t) top_level + 1);
+    for(int i=0; i<num_points; i++) indexes_for_levels[level[i]].push_back(i);
+
+    std::vector<bool> dirty = is_new;
+    for(auto const &indexes : indexes_for_levels){
+        for(auto i : indexes){
+            if (!dirty[i]){
+                int const *up = dagUp.getStrip(i);
+                if (std::any_of(up, up + max_parents, [&](int k)->bool{ return (k > -1) && dirty[k]; })){
+                    dirty[i] = true;
+                    std::copy_n(values.getValues(i), num_outputs, surpluses.getStrip(i)); // reset the surpluses to the values (will be updated)
+                }
+            }
+        }
+    }
+    for(int i=0; i<num_points; i++) if (!dirty[i]) level[i] = 0; // only the dirty points are updated
+
+    updateSurpluses(points, top_level, level, dagUp);
 }
 void GridLocalPolynomial::mergeRefinement(){
     if (needed.empty()) return; // nothing to do
     #ifdef Tasmanian_ENABLE_CUDA
     clearCudaSurpluses();
     #endif
+    clearFloatCoefficients();
     int num_all_points = getNumLoaded() + getNumNeeded();
     size_t num_vals = ((size_t) num_all_points) * ((size_t) num_outputs);
     values.setValues(std::vector<double>(num_vals, 0.0));
@@ -522,6 +760,7 @@ void GridLocalPolynomial::loadConstructedPoint(const double x[], const std::vect
         while(std::abs(rule->getNode(p[j]) - x[j]) > Maths::num_tol) p[j]++;
     }
 
+    dynamic_values->listNodes(); // the nodes of the batch loader
     dynamic_values->data.push_front({p, y});
     dynamic_values->initial_points.removeIndex(p);
 
@@ -544,7 +783,77 @@ void GridLocalPolynomial::loadConstructedPoint(const double x[], const std::vect
         }
     }
 }
+void GridLocalPolynomial::loadConstructedPoints(const double x[], int num_x, const double y[]){
+    // every node of the local polynomial rules is in [-1, 1], reject the other points before searching the nodes
+    if (std::any_of(x, x + Utils::size_mult(num_dimensions, num_x), [](double v)->bool{ return !(std::abs(v) <= 1.0 + Maths::num_tol); }))
+        throw std::runtime_error("ERROR: loadConstructedPoints() x is not a vector returned by getCandidateConstructionPoints()");
+
+    // the candidates are the initial points and the kids of the loaded points, i.e., the nodes are at most one level above the grid
+    int max_level = 0;
+    for(auto i : points.getVector()) max_level = std::max(max_level, rule->getLevel(i));
+    for(auto i : dynamic_values->initial_points.getVector()) max_level = std::max(max_level, rule->getLevel(i));
+    NodeIndexLookup lookup([&](int i)->double{ return rule->getNode(i); }, rule->getNumPoints(max_level), rule->getNumPoints(max_level + 1));
+    std::vector<int> pnts = lookup.getIndexes((size_t) num_dimensions, num_x, x);
+    dynamic_values->addNodes((size_t) num_dimensions, (size_t) num_outputs, num_x, pnts, y);
+    auto &pending = dynamic_values->pending;
+
+    // a node can be added if it is connected to the grid, i.e., has an immediate relative in the grid or among the added nodes
+    // the waiting nodes were not connected after the last batch, only the new nodes and the relatives of the added nodes are visited
+    std::vector<NodeData> new_nodes;
+    auto take = [&](std::vector<int> const &p)->void{
+        auto w = pending.find(p);
+        if (w != pending.end()){
+            new_nodes.push_back({w->first, std::move(w->second)});
+            pending.erase(w);
+        }
+    };
+    for(int i=0; i<num_x; i++){
+        std::vector<int> p(pnts.begin() + Utils::size_mult(i, num_dimensions), pnts.begin() + Utils::size_mult(i + 1, num_dimensions));
+        if (!points.missing(p)){
+            pending.erase(p); // repeated point, already in the grid
+            continue;
+        }
+        bool is_connected = false;
+        HierarchyManipulations::touchAllImmediateRelatives(p, points, rule.get(), [&](int)->void{ is_connected = true; });
+        int lvl = rule->getLevel(p[0]);
+        for(int j=1; j<num_dimensions; j++) lvl += rule->getLevel(p[j]);
+        if (is_connected || (lvl == 0)) take(p);
+    }
+    int max_kids = rule->getMaxNumKids();
+    for(size_t q=0; q<new_nodes.size(); q++){ // new_nodes grows, the added nodes are the queue
+        std::vector<int> p = new_nodes[q].point;
+        for(auto &v : p){
+            int save = v;
+            for(int r : {rule->getParent(save), rule->getStepParent(save)}){
+                if (r > -1){ v = r; take(p); }
+            }
+            for(int k=0; k<max_kids; k++){
+                v = rule->getKid(save, k);
+                if (v > -1) take(p);
+            }
+            v = save;
+        }
+    }
+    if (new_nodes.empty()) return;
+
+    MultiIndexSet new_points;
+    std::vector<double> new_values;
+    SimpleConstructData::sortNodes((size_t) num_dimensions, new_nodes, new_points, new_values);
+
+    if (points.empty()){
+        clearFloatCoefficients();
+        points = std::move(new_points);
+        values.resize(num_outputs, points.getNumIndexes());
+        values.setValues(std::move(new_values));
+        buildTree();
+        recomputeSurpluses();
+    }else{ // load as needed points, only the surpluses affected by the new points are computed
+        needed = std::move(new_points);
+        loadNeededPoints(new_values.data());
+    }
+}
 void GridLocalPolynomial::expandGrid(const std::vector<int> &point, const std::vector<double> &value){
+    clearFloatCoefficients();
     if (points.empty()){ // only one point
         points = MultiIndexSet((size_t) num_dimensions, std::vector<int>(point));
         values.resize(num_outputs, 1);
@@ -695,21 +1004,95 @@ void GridLocalPolynomial::getInterpolationWeights(const double x[], double *weig
 }
 
 void GridLocalPolynomial::evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const{
+    evaluateHierarchicalFunctionsTempl<double>(x, num_x, y);
+}
+void GridLocalPolynomial::evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const{
+    evaluateHierarchicalFunctionsTempl<float>(x, num_x, y);
+}
+template<typename T>
+void GridLocalPolynomial::evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const{
     const MultiIndexSet &work = (points.empty()) ? needed : points;
     int num_points = work.getNumIndexes();
     Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
-    Utils::Wrapper2D<double> ywrap(num_points, y);
+    Utils::Wrapper2D<T> ywrap(num_points, y);
     #pragma omp parallel for
     for(int i=0; i<num_x; i++){
         double const *this_x = xwrap.getStrip(i);
-        double *this_y = ywrap.getStrip(i);
+        T *this_y = ywrap.getStrip(i);
         bool dummy;
         for(int j=0; j<num_points; j++)
-            this_y[j] = evalBasisSupported(work.getIndex(j), this_x, dummy);
+            this_y[j] = (T) evalBasisSupported(work.getIndex(j), this_x, dummy);
+    }
+}
+
+template<typename callable> void GridLocalPolynomial::recomputeSurplusesByLevel(callable evaluate_upper){
+    clearFloatCoefficients();
+    std::vector<int> levels = HierarchyManipulations::computeLevels(points, rule.get());
+
+    std::vector<Data2D<int>> lpnts = HierarchyManipulations::splitByLevels((size_t) num_dimensions, points.getVector(), levels);
+    std::vector<Data2D<double>> lvals = HierarchyManipulations::splitByLevels((size_t) num_outputs, values.getVector(), levels);
+
+    Data2D<double> allx(num_dimensions, points.getNumIndexes());
+    getPoints(allx.getVector().data());
+
+    std::vector<Data2D<double>> lx = HierarchyManipulations::splitByLevels((size_t) num_dimensions, allx.getVector(), levels);
+
+    MultiIndexSet cumulative_poitns((size_t) num_dimensions, std::move(lpnts[0].getVector()));
+
+    StorageSet cumulative_surpluses;
+    cumulative_surpluses.resize(num_outputs, cumulative_poitns.getNumIndexes());
+    cumulative_surpluses.setValues(std::move(lvals[0].getVector()));
+
+    for(size_t l = 1; l < lpnts.size(); l++){ // loop over the levels
+        // note that level_points.getNumIndexes() == lx[l].getNumStrips() == lvals[l].getNumStrips()
+        MultiIndexSet level_points(num_dimensions, std::move(lpnts[l].getVector()));
+
+        GridLocalPolynomial upper_grid(num_dimensions, num_outputs, order, getRule(),
+                                       std::vector<int>(cumulative_poitns.getVector()), // copy cumulative_poitns
+                                       std::vector<double>(Utils::size_mult(num_outputs, cumulative_poitns.getNumIndexes())),  // dummy values, will not be read or used
+                                       std::vector<double>(cumulative_surpluses.getVector())); // copy the cumulative_surpluses
+        upper_grid.sparse_affinity = sparse_affinity;
+
+        Data2D<double> upper_evaluate(num_outputs, level_points.getNumIndexes());
+        int batch_size = 20000; // needs tuning
+        if (useDense()){ // dense uses lots of memory, try to keep it contained to about 4GB
+            batch_size = 536870912 / upper_grid.getNumPoints() - 2 * (num_outputs + num_dimensions);
+            if (batch_size < 100) batch_size = 100; // use at least 100 points
+        }
+
+        for(int i=0; i<level_points.getNumIndexes(); i += batch_size)
+            evaluate_upper(upper_grid, lx[l].getStrip(i), std::min(batch_size, level_points.getNumIndexes() - i), upper_evaluate.getStrip(i));
+
+        double *level_surps = lvals[l].getStrip(0); // maybe use BLAS here
+        const double *uv = upper_evaluate.getStrip(0);
+        for(size_t i=0, s = upper_evaluate.getVector().size(); i < s; i++) level_surps[i] -= uv[i];
+
+        cumulative_surpluses.addValues(cumulative_poitns, level_points, level_surps);
+        cumulative_poitns.addMultiIndexSet(level_points);
     }
+
+    surpluses = Data2D<double>(num_outputs, points.getNumIndexes(), std::move(cumulative_surpluses.getVector()));
+}
+
+bool GridLocalPolynomial::useLevelSurpluses() const{
+    if (level_affinity != 0) return (level_affinity == 1);
+    #ifdef _OPENMP
+    // the level scheme tests every support that contains the node (including the supports with the node on the boundary),
+    // which is 3 to 10 times the work of the DAG walk, the batched evaluations pay off only when spread over many threads
+    return (omp_get_max_threads() >= level_surpluses_min_threads) && (points.getNumIndexes() >= level_surpluses_min_points);
+    #else
+    return false;
+    #endif
 }
 
 void GridLocalPolynomial::recomputeSurpluses(){
+    if (useLevelSurpluses()){
+        recomputeSurplusesByLevel([&](GridLocalPolynomial const &upper_grid, const double x[], int num_x, double y[])->void{
+            upper_grid.evaluateBatch(x, num_x, y);
+        });
+        return;
+    }
+    clearFloatCoefficients();
     int num_points = points.getNumIndexes();
 
     surpluses.resize(num_outputs, num_points);
@@ -730,43 +1113,53 @@ void GridLocalPolynomial::updateSurpluses(MultiIndexSet const &work, int max_lev
     for(int i=0; i<num_points; i++)
         if (level[i] > 0) indexses_for_levels[level[i]].push_back(i);
 
-    for(int l=1; l<=max_level; l++){
-        int level_size = (int) indexses_for_levels[l].size();
-        #pragma omp parallel for schedule(dynamic)
-        for(int s=0; s<level_size; s++){
-            int i = indexses_for_levels[l][s];
-
-            int const *p = work.getIndex(i);
-            std::vector<double> x(num_dimensions);
-            std::transform(p, p + num_dimensions, x.begin(), [&](int k)->double{ return rule->getNode(k); });
-            double *surpi = surpluses.getStrip(i);
+    #pragma omp parallel
+    {
+        // the used flags are allocated once per thread, only the entries visited by the last point are cleared,
+        // allocating and zeroing a vector the size of the grid for every point serializes the threads on large grids
+        std::vector<bool> used(num_points, false);
+        std::vector<int> visited;
+        std::vector<double> x(num_dimensions);
+        std::vector<int> monkey_count(max_level + 1);
+        std::vector<int> monkey_tail(max_level + 1);
+
+        for(int l=1; l<=max_level; l++){
+            int level_size = (int) indexses_for_levels[l].size();
+            #pragma omp for schedule(dynamic)
+            for(int s=0; s<level_size; s++){
+                int i = indexses_for_levels[l][s];
+
+                int const *p = work.getIndex(i);
+                std::transform(p, p + num_dimensions, x.begin(), [&](int k)->double{ return rule->getNode(k); });
+                double *surpi = surpluses.getStrip(i);
+
+                for(auto v : visited) used[v] = false;
+                visited.clear();
 
-            std::vector<int> monkey_count(max_level + 1);
-            std::vector<int> monkey_tail(max_level + 1);
-            std::vector<bool> used(num_points, false);
+                int current = 0;
 
-            int current = 0;
+                monkey_count[0] = 0;
+                monkey_tail[0] = i;
 
-            monkey_count[0] = 0;
-            monkey_tail[0] = i;
+                while(monkey_count[0] < max_parents){
+                    if (monkey_count[current] < max_parents){
+                        int branch = dagUp.getStrip(monkey_tail[current])[monkey_count[current]];
+                        if ((branch == -1) || (used[branch])){
+                            monkey_count[current]++;
+                        }else{
+                            const double *branch_surp = surpluses.getStrip(branch);
+                            double basis_value = evalBasisRaw(work.getIndex(branch), x.data());
+                            for(int k=0; k<num_outputs; k++)
+                                surpi[k] -= basis_value * branch_surp[k];
+                            used[branch] = true;
+                            visited.push_back(branch);
 
-            while(monkey_count[0] < max_parents){
-                if (monkey_count[current] < max_parents){
-                    int branch = dagUp.getStrip(monkey_tail[current])[monkey_count[current]];
-                    if ((branch == -1) || (used[branch])){
-                        monkey_count[current]++;
+                            monkey_count[++current] = 0;
+                            monkey_tail[current] = branch;
+                        }
                     }else{
-                        const double *branch_surp = surpluses.getStrip(branch);
-                        double basis_value = evalBasisRaw(work.getIndex(branch), x.data());
-                        for(int k=0; k<num_outputs; k++)
-                            surpi[k] -= basis_value * branch_surp[k];
-                        used[branch] = true;
-
-                        monkey_count[++current] = 0;
-                        monkey_tail[current] = branch;
+                        monkey_count[--current]++;
                     }
-                }else{
-                    monkey_count[--current]++;
                 }
             }
         }
@@ -837,12 +1230,17 @@ int GridLocalPolynomial::getSpareBasisMatrixNZ(const double x[], int num_x) cons
     Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
     std::vector<int> num_nz(num_x);
 
-    #pragma omp parallel for
-    for(int i=0; i<num_x; i++){
+    #pragma omp parallel
+    {
         std::vector<int> sindx;
         std::vector<double> svals;
-        walkTree<1>(work, xwrap.getStrip(i), sindx, svals, nullptr);
-        num_nz[i] = (int) sindx.size();
+        #pragma omp for
+        for(int i=0; i<num_x; i++){
+            sindx.clear();
+            svals.clear();
+            walkTree<1>(work, xwrap.getStrip(i), sindx, svals, nullptr);
+            num_nz[i] = (int) sindx.size();
+        }
     }
 
     return std::accumulate(num_nz.begin(), num_nz.end(), 0);
@@ -946,6 +1344,65 @@ void GridLocalPolynomial::buildTree(){
 
     indx = std::vector<int>((size_t) ((pntr[num_points] > 0) ? pntr[num_points] : 1));
     std::copy_if(tree.getVector().begin(), tree.getVector().end(), indx.begin(), [](int t)->bool{ return (t > -1); });
+
+    if (use_support_index) setSupportIndex(true); // the points have changed, rebuild the index
+}
+
+void GridLocalPolynomial::patchTree(std::vector<int> const &old_to_new, std::vector<bool> const &is_new){
+    int num_points = points.getNumIndexes();
+    int max_1d_kids = rule->getMaxNumKids();
+
+    // attach each new point as a kid of one of its parents, the point becomes a new root if no parent is present
+    std::vector<std::vector<int>> added((size_t) num_points);
+    std::vector<int> new_roots;
+    std::vector<int> p((size_t) num_dimensions);
+    for(int i=0; i<num_points; i++){
+        if (!is_new[i]) continue;
+        std::copy_n(points.getIndex(i), num_dimensions, p.begin());
+        int l = rule->getLevel(p[0]);
+        for(int j=1; j<num_dimensions; j++) l += rule->getLevel(p[j]);
+        top_level = std::max(top_level, l);
+
+        int tree_parent = -1;
+        for(int j=0; (j<num_dimensions) && (tree_parent == -1); j++){
+            int kid = p[j];
+            for(int candidate : {rule->getParent(kid), rule->getStepParent(kid)}){
+                if (candidate < 0) continue;
+                bool is_kid = false; // the tree uses only the edges in computeDAGDown()
+                for(int k=0; k<max_1d_kids; k++) if (rule->getKid(candidate, k) == kid) is_kid = true;
+                if (!is_kid) continue;
+                p[j] = candidate;
+                tree_parent = points.getSlot(p);
+                p[j] = kid;
+                if (tree_parent != -1) break;
+            }
+        }
+        if (tree_parent == -1){
+            new_roots.push_back(i);
+        }else{
+            added[tree_parent].push_back(i);
+        }
+    }
+
+    int num_old = (int) old_to_new.size();
+    std::vector<int> new_pntr((size_t) (num_points + 1), 0);
+    for(int i=0; i<num_old; i++) new_pntr[old_to_new[i] + 1] = pntr[i+1] - pntr[i];
+    for(int i=0; i<num_points; i++) new_pntr[i+1] += new_pntr[i] + (int) added[i].size();
+
+    std::vector<int> new_indx((size_t) ((new_pntr[num_points] > 0) ? new_pntr[num_points] : 1));
+    for(int i=0; i<num_old; i++){
+        int c = old_to_new[i];
+        std::transform(indx.begin() + pntr[i], indx.begin() + pntr[i+1], new_indx.begin() + new_pntr[c], [&](int k)->int{ return old_to_new[k]; });
+    }
+    for(int i=0; i<num_points; i++)
+        std::copy(added[i].begin(), added[i].end(), new_indx.begin() + new_pntr[i+1] - added[i].size());
+
+    for(auto &r : roots) r = old_to_new[r];
+    roots.insert(roots.end(), new_roots.begin(), new_roots.end());
+    pntr = std::move(new_pntr);
+    indx = std::move(new_indx);
+
+    if (use_support_index) setSupportIndex(true); // the points have changed, rebuild the index
 }
 
 void GridLocalPolynomial::getBasisIntegrals(double *integrals) const{
@@ -1266,7 +1723,7 @@ void GridLocalPolynomial::addChildLimited(const int point[], int direction, cons
 
 void GridLocalPolynomial::clearRefinement(){ needed = MultiIndexSet(); }
 const double* GridLocalPolynomial::getSurpluses() const{
-    return surpluses.getVector().data();
+    return surpluses.getStrip(0);
 }
 const int* GridLocalPolynomial::getPointIndexes() const{
     return ((points.empty()) ? needed.getIndex(0) : points.getIndex(0));
@@ -1347,6 +1804,7 @@ void GridLocalPolynomial::setHierarchicalCoefficients(const double c[], TypeAcce
     #ifdef Tasmanian_ENABLE_CUDA
     clearCudaSurpluses();
     #endif
+    clearFloatCoefficients();
     if (points.empty()){
         points = std::move(needed);
         needed = MultiIndexSet();
@@ -1368,6 +1826,67 @@ void GridLocalPolynomial::clearAccelerationData(){
     #ifdef Tasmanian_ENABLE_CUDA
     cuda_cache.reset();
     #endif
+    clearFloatCoefficients();
+}
+
+void GridLocalPolynomial::setSupportIndex(bool use_index){
+    use_support_index = use_index;
+    if (use_support_index && !points.empty()){
+        buildSupportIndex();
+    }else{
+        support_index.reset();
+    }
+}
+void GridLocalPolynomial::buildSupportIndex(){
+    support_index = std::unique_ptr<SupportIndex>(new SupportIndex());
+    auto &keys = support_index->keys;
+    auto &offsets = support_index->offsets;
+    auto &max_levels = support_index->max_levels;
+    keys.resize((size_t) num_dimensions);
+    offsets.resize((size_t) num_dimensions);
+    max_levels = std::vector<int>((size_t) num_dimensions, 0);
+
+    int num_points = points.getNumIndexes();
+    for(int i=0; i<num_points; i++){
+        const int *p = points.getIndex(i);
+        int k = 0; // first entry that differs from the previous multi-index, i.e., the prefixes up to k are already in the trie
+        if (i > 0){
+            const int *prev = points.getIndex(i-1);
+            while(p[k] == prev[k]) k++;
+        }
+        for(int j=k; j<num_dimensions; j++){
+            if (j + 1 < num_dimensions) offsets[j].push_back((int) keys[j+1].size());
+            keys[j].push_back(p[j]);
+        }
+        for(int j=0; j<num_dimensions; j++) max_levels[j] = std::max(max_levels[j], rule->getLevel(p[j]));
+    }
+    for(int j=0; j+1<num_dimensions; j++) offsets[j].push_back((int) keys[j+1].size());
+}
+void GridLocalPolynomial::findSupported1D(int dimension, double x, std::vector<std::pair<int, double>> &supported, std::vector<int> &stack) const{
+    supported.clear();
+    stack.clear();
+    int max_level = support_index->max_levels[dimension];
+    int max_kids = rule->getMaxNumKids();
+    for(int i=0; i<rule->getNumPoints(0); i++) stack.push_back(i);
+    while(!stack.empty()){ // the support of a kid is included in the support of a parent, same as in walkTree()
+        int p = stack.back();
+        stack.pop_back();
+        bool isSupported;
+        double basis_value = rule->evalSupport(p, x, isSupported);
+        if (isSupported){
+            supported.push_back(std::make_pair(p, basis_value));
+            if (rule->getLevel(p) < max_level){
+                for(int k=0; k<max_kids; k++){
+                    int kid = rule->getKid(p, k);
+                    if (kid != -1) stack.push_back(kid);
+                }
+            }
+        }
+    }
+    // a node can be reached trough more than one parent
+    std::sort(supported.begin(), supported.end(), [](std::pair<int, double> const &a, std::pair<int, double> const &b)->bool{ return (a.first < b.first); });
+    supported.erase(std::unique(supported.begin(), supported.end(), [](std::pair<int, double> const &a, std::pair<int, double> const &b)->bool{ return (a.first == b.first); }),
+                    supported.end());
 }
 
 void GridLocalPolynomial::setFavorSparse(bool favor){
@@ -1378,6 +1897,13 @@ void GridLocalPolynomial::setFavorSparse(bool favor){
     if (favor && (sparse_affinity < 1)) sparse_affinity++;
     if (!favor && (sparse_affinity > -1)) sparse_affinity--;
 }
+void GridLocalPolynomial::setFavorLevelSurpluses(bool favor){
+    // level_affinity == -1: always walk the DAG
+    // level_affinity ==  1: always compute the surpluses by levels
+    // level_affinity ==  0: let Tasmanian decide
+    if (favor && (level_affinity < 1)) level_affinity++;
+    if (!favor && (level_affinity > -1)) level_affinity--;
+}
 
 }
 
@@ -79,9 +79,11 @@ public:
     void integrate(double q[], double *conformal_correction) const;
 
     void evaluateBatch(const double x[], int num_x, double y[]) const;
+    void evaluateBatch(const double x[], int num_x, float y[]) const;
 
     #ifdef Tasmanian_ENABLE_BLAS
     void evaluateBlas(const double x[], int num_x, double y[]) const;
+    void evaluateBlas(const double x[], int num_x, float y[]) const;
     #endif
 
     #ifdef Tasmanian_ENABLE_CUDA
@@ -103,13 +105,19 @@ public:
     void readConstructionData(std::istream &is);
     std::vector<double> getCandidateConstructionPoints(double tolerance, TypeRefinement criteria, int output, std::vector<int> const &level_limits, double const *scale_correction);
     void loadConstructedPoint(const double x[], const std::vector<double> &y);
+    void loadConstructedPoints(const double x[], int num_x, const double y[]);
     void finishConstruction();
 
     void evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const;
+    void evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const;
     void setHierarchicalCoefficients(const double c[], TypeAcceleration acc);
 
     void clearAccelerationData();
     void setFavorSparse(bool favor);
+    //! \brief Select the algorithm used by recomputeSurpluses(), see useLevelSurpluses(), works the same way as setFavorSparse().
+    void setFavorLevelSurpluses(bool favor);
+    //! \brief Build (or discard) the SupportIndex, the index is kept up-to-date while enabled.
+    void setSupportIndex(bool use_index);
 
     const double* getSurpluses() const;
     const int* getPointIndexes() const;
@@ -127,11 +135,22 @@ public:
 protected:
     void reset(bool clear_rule = true);
 
+    //! \brief Implements evaluateHierarchicalFunctions() for both double and float outputs, the basis is always computed in double precision.
+    template<typename T> void evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const;
+
     //! \brief Create a new grid with given parameters and moving the data out of the vectors and sets.
     GridLocalPolynomial(int cnum_dimensions, int cnum_outputs, int corder, TypeOneDRule crule, std::vector<int> &&pnts, std::vector<double> &&vals, std::vector<double> &&surps);
 
     //! \brief Used as part of the loadNeededPoints() algorithm, updates the values and cuda cache, but does not touch the surpluses.
     void updateValues(double const *vals);
+    /*!
+     * \brief Used by loadNeededPoints() when refining a grid with valid surpluses.
+     *
+     * Merges the needed points, patches the tree, and computes the surpluses only for the new points
+     * and for the old points that have a new point among the ancestors, all other surpluses are kept.
+     * Not used when useLevelSurpluses() selects the level scheme, then all surpluses are recomputed with recomputeSurpluses().
+     */
+    void loadNeededPointsIncremental(const double *vals);
 
     //! \internal
     //! \brief makes the unique pointer associated with this rule, assuming that **order** is already set
@@ -141,7 +160,48 @@ protected:
     //! \brief Tuning decision whether to use sparse or dense.
     bool useDense() const{ return (sparse_affinity == -1) || ((sparse_affinity == 0) && (num_dimensions > 6)); }
 
+    //! \brief Below this number of outputs evaluateBatch() walks the tree, above it the sparse basis matrix is formed and the tiled kernel is used.
+    static constexpr int tiled_min_outputs = 4096;
+
+    //! \brief Number of points pushed down the tree together by evaluateBatch(), smaller batches walk the tree one point at a time.
+    static constexpr int tree_block_size = 256;
+
+    /*!
+     * \brief Evaluate the surrogate at a block of \b num_x points with a single depth-first traversal of the tree.
+     *
+     * The traversal uses the same monkey stack as walkTree(), each node on the stack keeps the list of points in the block that are inside its support,
+     * the children are tested only against that list and the entire subtree is skipped once the list is empty.
+     * Each point sees the nodes in the same order as in walkTree(), hence the result matches the point-by-point evaluation.
+     * The \b coeff are the surpluses or the single precision copy, \b y is overwritten.
+     */
+    template<typename T> void evaluateTreeBlock(const double x[], int num_x, const T coeff[], T y[]) const;
+
+    /*!
+     * \brief Evaluate the surrogate by forming the sparse basis matrix for chunks of \b x and multiplying by \b coeff.
+     *
+     * The chunks are small enough so that the dense matrix fits in a fixed memory budget.
+     * If \b allow_dense is true and BLAS is enabled, useDenseMultiply() selects between the dense and sparse algorithms for each chunk,
+     * based on the number of non-zeros, the number of outputs and the size of the grid.
+     * The \b coeff are the surpluses or the single precision copy.
+     */
+    template<typename T> void evaluateSparseBasis(const double x[], int num_x, const T coeff[], T y[], bool allow_dense) const;
+    //! \brief Cost model, returns true if forming the dense \b num_x by num_points matrix and calling BLAS is cheaper than the sparse multiply with \b num_nz non-zeros.
+    bool useDenseMultiply(int num_x, int num_nz) const;
+    //! \brief Native CSR times dense kernel, computes \b y as \b coeff times the sparse matrix, tiled over outputs and points, may sort the rows of the matrix.
+    template<typename T> void multiplySparseBasis(int num_x, std::vector<int> const &spntr, std::vector<int> &sindx, std::vector<double> &svals, const T coeff[], T y[]) const;
+    #ifdef Tasmanian_ENABLE_BLAS
+    //! \brief Implements evaluateBlas() for double and float outputs.
+    template<typename T> void evaluateBlasTempl(const double x[], int num_x, const T coeff[], T y[]) const;
+    #endif
+
     void buildTree();
+    /*!
+     * \brief Update the tree after new points were merged into \b points, used in place of buildTree() by loadNeededPointsIncremental().
+     *
+     * The kids of the old points keep their place in the tree, \b old_to_new maps the old indexes into the merged set.
+     * Each point with \b is_new flag is attached as a kid of one of its parents, or becomes a new root if no parent is present.
+     */
+    void patchTree(std::vector<int> const &old_to_new, std::vector<bool> const &is_new);
 
     //! \brief Returns a list of indexes of the nodes in \b points that are descendants of the \b point.
     std::vector<int> getSubGraph(std::vector<int> const &point) const;
@@ -150,6 +210,26 @@ protected:
     void expandGrid(std::vector<int> const &point, std::vector<double> const &value);
 
     void recomputeSurpluses();
+    /*!
+     * \brief Computes the surpluses one level at a time, the algorithm used by loadNeededPointsCuda().
+     *
+     * The points are split by levels and the grid made of the lower levels is evaluated at the nodes of the next level,
+     * the surpluses of the level are the values minus the evaluations.
+     * The \b evaluate_upper is called with the lower grid and batches of nodes, e.g., evaluateBatch() or evaluateCuda().
+     */
+    template<typename callable> void recomputeSurplusesByLevel(callable evaluate_upper);
+    /*!
+     * \brief Tuning decision whether recomputeSurpluses() should use recomputeSurplusesByLevel() or the walk over the DAG.
+     *
+     * The user choice from setFavorLevelSurpluses() takes precedence,
+     * otherwise the level scheme is used only with OpenMP, at least \b level_surpluses_min_threads threads,
+     * and at least \b level_surpluses_min_points points.
+     */
+    bool useLevelSurpluses() const;
+    //! \brief The automatic selection uses the level scheme only with at least this many OpenMP threads.
+    static constexpr int level_surpluses_min_threads = 32;
+    //! \brief The automatic selection uses the level scheme only for grids with at least this many points.
+    static constexpr int level_surpluses_min_points = 1000000;
 
     /*!
      * \brief Update the surpluses for a portion of the graph.
@@ -168,6 +248,81 @@ protected:
     void buildSparseMatrixBlockForm(const double x[], int num_x, int num_chunk, std::vector<int> &numnz,
                                     std::vector<std::vector<int>> &tindx, std::vector<std::vector<double>> &tvals) const;
 
+    /*!
+     * \brief Scratch space used by walkTree(), each thread holds one instance that is reused across calls and grids.
+     *
+     * The traversal stacks are indexed by the level of the node, hence they need \b top_level + 1 entries,
+     * the sort buffer is used only in \b mode \b 2 and grows to the largest number of supported basis functions seen so far.
+     */
+    struct TreeWalkWorkspace{
+        std::vector<int> monkey_count; // traverse the tree, counts the branches of the current node
+        std::vector<int> monkey_tail; // traverse the tree, keeps track of the previous node (history)
+        std::vector<std::pair<int, double>> sort_buffer; // index-value pairs sorted together in mode 2
+        std::vector<std::vector<std::pair<int, double>>> supported; // one dimensional basis functions supported in each direction, used with the SupportIndex
+        std::vector<int> stack; // traverse the one dimensional hierarchy
+    };
+    //! \brief Returns the workspace of the calling thread with stacks large enough for the current \b top_level.
+    TreeWalkWorkspace& getTreeWalkWorkspace() const;
+
+    /*!
+     * \brief Trie over the multi-indexes of the loaded \b points, enumerates the basis functions supported at \b x without walking the tree.
+     *
+     * A basis function is supported at \b x if and only if all of its one dimensional factors are supported,
+     * the one dimensional hierarchies are short (a few nodes per level) and the supported nodes are found for each direction,
+     * then the trie is used to select the multi-indexes (i.e., tensors of one dimensional nodes) that are present in the grid.
+     * Level \b k of the trie holds the distinct prefixes of length k+1, \b keys[k] is the last entry of each prefix
+     * and the extensions of prefix \b i are the nodes \b offsets[k][i] to \b offsets[k][i+1] on level k+1.
+     * The multi-index set is sorted, hence the nodes on the last level have the same order as the points.
+     */
+    struct SupportIndex{
+        std::vector<std::vector<int>> keys;
+        std::vector<std::vector<int>> offsets;
+        std::vector<int> max_levels; // largest one dimensional level in each direction
+    };
+    //! \brief Builds the SupportIndex for the current \b points, called from buildTree() when the index is enabled.
+    void buildSupportIndex();
+    //! \brief Writes the sorted list of the one dimensional nodes supported at \b x for the given \b dimension.
+    void findSupported1D(int dimension, double x, std::vector<std::pair<int, double>> &supported, std::vector<int> &stack) const;
+
+    //! \brief Recursively visits level \b k of the SupportIndex in the range \b first to \b last, calls \b apply(point, basis_value).
+    template<typename callable>
+    void visitSupportIndex(int k, int first, int last, double value, std::vector<std::vector<std::pair<int, double>>> const &supported, callable &apply) const{
+        const int *keys = support_index->keys[k].data();
+        for(auto const &s : supported[k]){
+            const int *node = std::lower_bound(keys + first, keys + last, s.first);
+            first = (int) (node - keys); // supported is sorted, the following searches start here
+            if (first == last) return;
+            if (*node == s.first){
+                if (k == num_dimensions - 1){
+                    apply(first, value * s.second);
+                }else{
+                    visitSupportIndex(k + 1, support_index->offsets[k][first], support_index->offsets[k][first + 1], value * s.second, supported, apply);
+                }
+                first++;
+            }
+        }
+    }
+
+    //! \brief Implements walkTree() using the SupportIndex, the result in \b mode 1 and 2 is sorted by the point index.
+    template<int mode>
+    void walkSupportIndex(const double x[], std::vector<int> &sindx, std::vector<double> &svals, double *y) const{
+        TreeWalkWorkspace &workspace = getTreeWalkWorkspace();
+        workspace.supported.resize((size_t) num_dimensions);
+        for(int j=0; j<num_dimensions; j++)
+            findSupported1D(j, x[j], workspace.supported[j], workspace.stack);
+
+        auto apply = [&](int p, double basis_value)->void{
+            if (mode == 0){
+                double const *s = surpluses.getStrip(p);
+                for(int k=0; k<num_outputs; k++) y[k] += basis_value * s[k];
+            }else{
+                sindx.push_back(p);
+                svals.push_back(basis_value);
+            }
+        };
+        visitSupportIndex(0, 0, (int) support_index->keys[0].size(), 1.0, workspace.supported, apply);
+    }
+
     /*!
      * \brief Walk through all the nodes of the tree and touches only the nodes supported at \b x.
      *
@@ -177,11 +332,17 @@ protected:
      * - \b mode \b 2, same as \b mode \b 1 but it also sorts the entries within the vector (requirement of Nvidia cusparseDgemvi)
      *
      * In all cases, \b work is the \b points or \b needed set that has been used to construct the tree.
+     * If the SupportIndex is enabled and \b work is the \b points set, the work is redirected to walkSupportIndex().
      */
     template<int mode>
     void walkTree(const MultiIndexSet &work, const double x[], std::vector<int> &sindx, std::vector<double> &svals, double *y) const{
-        std::vector<int> monkey_count(top_level+1); // traverse the tree, counts the branches of the current node
-        std::vector<int> monkey_tail(top_level+1); // traverse the tree, keeps track of the previous node (history)
+        if (support_index && (&work == &points)){
+            walkSupportIndex<mode>(x, sindx, svals, y);
+            return;
+        }
+        TreeWalkWorkspace &workspace = getTreeWalkWorkspace();
+        int *monkey_count = workspace.monkey_count.data();
+        int *monkey_tail = workspace.monkey_tail.data();
 
         for(const auto &r : roots){
             bool isSupported;
@@ -229,15 +390,15 @@ protected:
         // "... it is assumed that the indices are provided in increasing order and that each index appears only once."
         // This may not be a requirement for cusparseDgemvi(), but it may be that I have not tested it sufficiently
         // Also, see AccelerationDataGPUFull::cusparseMatveci() for inaccuracies in Nvidia documentation
-        if (mode == 2){
-            std::vector<int> map(sindx);
-            std::iota(map.begin(), map.end(), 0);
-            std::sort(map.begin(), map.end(), [&](int a, int b)->bool{ return (sindx[a] < sindx[b]); });
-
-            std::vector<int> idx = sindx;
-            std::vector<double> vls = svals;
-            std::transform(map.begin(), map.end(), sindx.begin(), [&](int i)->int{ return idx[i]; });
-            std::transform(map.begin(), map.end(), svals.begin(), [&](int i)->double{ return vls[i]; });
+        if (mode == 2 && !std::is_sorted(sindx.begin(), sindx.end())){ // sort the index-value pairs together, the buffer is reused by the thread
+            auto &buffer = workspace.sort_buffer;
+            buffer.resize(sindx.size());
+            for(size_t i=0; i<sindx.size(); i++) buffer[i] = std::make_pair(sindx[i], svals[i]);
+            std::sort(buffer.begin(), buffer.end(), [](std::pair<int, double> const &a, std::pair<int, double> const &b)->bool{ return (a.first < b.first); });
+            for(size_t i=0; i<sindx.size(); i++){
+                sindx[i] = buffer[i].first;
+                svals[i] = buffer[i].second;
+            }
         }
     }
 
@@ -337,7 +498,7 @@ protected:
     void loadCudaSurpluses() const{
         if (!cuda_cache) cuda_cache = std::unique_ptr<CudaLocalPolynomialData<double>>(new CudaLocalPolynomialData<double>);
         if (cuda_cache->surpluses.size() != 0) return;
-        cuda_cache->surpluses.load(surpluses.getVector());
+        cuda_cache->surpluses.load(surpluses.getTotalEntries(), surpluses.getStrip(0));
     }
     void clearCudaSurpluses(){ if (cuda_cache) cuda_cache->surpluses.clear(); }
     #endif
@@ -358,6 +519,10 @@ private:
     std::unique_ptr<BaseRuleLocalPolynomial> rule;
 
     int sparse_affinity;
+    int level_affinity;
+
+    bool use_support_index;
+    std::unique_ptr<SupportIndex> support_index;
 
     std::unique_ptr<SimpleConstructData> dynamic_values;
 
@@ -49,10 +49,13 @@ template<bool useAscii> void GridSequence::write(std::ostream &os) const{
     IO::writeFlag<useAscii, IO::pad_auto>(!needed.empty(), os);
     if (!needed.empty()) needed.write<useAscii>(os);
 
+    // the compressed format groups the surpluses and values by level
+    std::vector<int> levels = (IO::isCompressedFormat(os)) ? MultiIndexManipulations::computeLevels(points) : std::vector<int>();
+
     IO::writeFlag<useAscii, IO::pad_auto>(!surpluses.empty(), os);
-    if (!surpluses.empty()) IO::writeVector<useAscii, IO::pad_line>(surpluses.getVector(), os);
+    if (!surpluses.empty()) IO::writeLevelData2D<useAscii, IO::pad_line>(surpluses, levels, os);
 
-    if (num_outputs > 0) values.write<useAscii>(os);
+    if (num_outputs > 0) values.write<useAscii>(os, levels);
 }
 
 template<bool useAscii> void GridSequence::read(std::istream &is){
@@ -64,10 +67,12 @@ template<bool useAscii> void GridSequence::read(std::istream &is){
     if (IO::readFlag<useAscii>(is)) points.read<useAscii>(is);
     if (IO::readFlag<useAscii>(is)) needed.read<useAscii>(is);
 
+    std::vector<int> levels = (IO::isCompressedFormat(is)) ? MultiIndexManipulations::computeLevels(points) : std::vector<int>();
+
     if (IO::readFlag<useAscii>(is))
-        surpluses = IO::readData2D<useAscii, double>(is, num_outputs, points.getNumIndexes());
+        surpluses = IO::readLevelData2D<useAscii>(is, num_outputs, points.getNumIndexes(), levels);
 
-    if (num_outputs > 0) values.read<useAscii>(is);
+    if (num_outputs > 0) values.read<useAscii>(is, levels);
 
     prepareSequence(0);
 }
@@ -85,6 +90,7 @@ void GridSequence::reset(){
     nodes.clear();
     coeff.clear();
     surpluses = Data2D<double>();
+    shared_prefix = std::vector<int>();
 }
 void GridSequence::clearRefinement(){ needed = MultiIndexSet(); }
 
@@ -212,6 +218,31 @@ void GridSequence::loadNeededPoints(const double *vals){
             values.setValues(vals);
             points = std::move(needed);
             needed = MultiIndexSet();
+            cacheSharedPrefixes();
+        }else if (surpluses.getNumStrips() == points.getNumIndexes()){ // merge needed and points, keep the existing surpluses
+            // the sets are lower and the basis is triangular, the new points are not below any existing point,
+            // hence the surpluses of the existing points do not change and only the new ones must be computed
+            clearFloatCoefficients();
+            StorageSet merged_surpluses;
+            merged_surpluses.resize(num_outputs, points.getNumIndexes());
+            merged_surpluses.setValues(std::move(surpluses.getVector()));
+            merged_surpluses.addValues(points, needed, vals);
+            values.addValues(points, needed, vals);
+            points.addSortedIndexes(needed.getVector());
+
+            int num_points = points.getNumIndexes();
+            surpluses = Data2D<double>(num_outputs, num_points, std::move(merged_surpluses.getVector()));
+
+            std::vector<int> level((size_t) num_points, 0); // non-zero only for the new points
+            for(int i=0; i<needed.getNumIndexes(); i++){
+                int const *p = needed.getIndex(i);
+                level[points.getSlot(p)] = std::accumulate(p, p + num_dimensions, 0);
+            }
+            needed = MultiIndexSet();
+            prepareSequence(0);
+
+            updateSurpluses(level);
+            return;
         }else{ // merge needed and points
             values.addValues(points, needed, vals);
             points.addSortedIndexes(needed.getVector());
@@ -226,12 +257,14 @@ void GridSequence::mergeRefinement(){
     #ifdef Tasmanian_ENABLE_CUDA
     clearCudaSurpluses(); // clear the surpluses (all values have cleared)
     #endif
+    clearFloatCoefficients();
     int num_all_points = getNumLoaded() + getNumNeeded();
     size_t num_vals = ((size_t) num_all_points) * ((size_t) num_outputs);
     values.setValues(std::vector<double>(num_vals, 0.0));
     if (points.empty()){ // relabel needed as points (loaded)
         points = std::move(needed);
         needed = MultiIndexSet();
+        cacheSharedPrefixes();
     }else{
         #ifdef Tasmanian_ENABLE_CUDA
         clearCudaNodes(); // the points will change, clear cache
@@ -359,6 +392,7 @@ std::vector<double> GridSequence::getCandidateConstructionPoints(std::function<d
     return x;
 }
 void GridSequence::loadConstructedPoint(const double x[], const std::vector<double> &y){
+    dynamic_values->listNodes(); // the nodes of the batch loader
     std::vector<int> p(num_dimensions);
     for(int j=0; j<num_dimensions; j++){
         size_t i = 0;
@@ -400,7 +434,71 @@ void GridSequence::loadConstructedPoint(const double x[], const std::vector<doub
         dynamic_values->initial_points.removeIndex(p);
     }
 }
+void GridSequence::loadConstructedPoints(const double x[], int num_x, const double y[]){
+    NodeIndexLookup lookup([&](int i)->double{ return nodes[i]; }, (int) nodes.size(), (int) nodes.size());
+    std::vector<int> pnts = lookup.getIndexes((size_t) num_dimensions, num_x, x);
+    dynamic_values->addNodes((size_t) num_dimensions, (size_t) num_outputs, num_x, pnts, y);
+    auto &pending = dynamic_values->pending;
+
+    // a point can be added if each parent is either in the grid or added in the same batch
+    // the waiting nodes were not lower complete after the last batch, only the new nodes and the kids of the added nodes are checked
+    std::unordered_set<std::vector<int>, MultiIndexHash> added;
+    std::vector<NodeData> new_nodes;
+    auto is_lower = [&](std::vector<int> &dad)->bool{
+        for(size_t j=0; j<dad.size(); j++){
+            if (dad[j] > 0){
+                dad[j]--;
+                bool has_dad = (!points.missing(dad) || (added.find(dad) != added.end()));
+                dad[j]++;
+                if (!has_dad) return false;
+            }
+        }
+        return true;
+    };
+    std::vector<std::vector<int>> candidates;
+    for(int i=0; i<num_x; i++){
+        std::vector<int> p(pnts.begin() + Utils::size_mult(i, num_dimensions), pnts.begin() + Utils::size_mult(i + 1, num_dimensions));
+        if (!points.missing(p)){
+            pending.erase(p); // repeated point, already in the grid
+        }else{
+            candidates.push_back(std::move(p));
+        }
+    }
+    while(!candidates.empty()){
+        std::vector<int> p = std::move(candidates.back());
+        candidates.pop_back();
+        auto w = pending.find(p);
+        if ((w != pending.end()) && is_lower(p)){
+            added.insert(p);
+            new_nodes.push_back({p, std::move(w->second)});
+            pending.erase(w);
+            for(auto &v : p){ // the kids may have been waiting for this parent
+                v++;
+                if (pending.find(p) != pending.end()) candidates.push_back(p);
+                v--;
+            }
+        }
+    }
+    if (new_nodes.empty()) return;
+
+    MultiIndexSet new_points;
+    std::vector<double> new_values;
+    SimpleConstructData::sortNodes((size_t) num_dimensions, new_nodes, new_points, new_values);
+
+    if (points.empty()){
+        clearFloatCoefficients();
+        points = std::move(new_points);
+        values.resize(num_outputs, points.getNumIndexes());
+        values.setValues(std::move(new_values));
+        prepareSequence(0);
+        recomputeSurpluses();
+    }else{ // the new points are lower complete, load as needed points, only the new surpluses are computed
+        needed = std::move(new_points);
+        loadNeededPoints(new_values.data());
+    }
+}
 void GridSequence::expandGrid(const std::vector<int> &point, const std::vector<double> &value, const std::vector<double> &surplus){
+    clearFloatCoefficients();
     if (points.empty()){ // only one point
         points = MultiIndexSet((size_t) num_dimensions, std::vector<int>(point));
         values.resize(num_outputs, 1);
@@ -426,14 +524,15 @@ void GridSequence::evaluate(const double x[], double y[]) const{
     std::fill(y, y + num_outputs, 0.0);
 
     int num_points = points.getNumIndexes();
+    std::vector<double> partial((size_t) num_dimensions); // see the comments in evaluateBlock()
 
     for(int i=0; i<num_points; i++){
         const int* p = points.getIndex(i);
         const double *s = surpluses.getStrip(i);
-        double basis_value = cache[0][p[0]];
-        for(int j=1; j<num_dimensions; j++){
-            basis_value *= cache[j][p[j]];
-        }
+        int j = shared_prefix[i];
+        if (j == 0) partial[j++] = cache[0][p[0]];
+        for(; j<num_dimensions; j++) partial[j] = partial[j-1] * cache[j][p[j]];
+        double basis_value = partial[num_dimensions - 1];
 
         for(int k=0; k<num_outputs; k++){
             y[k] += basis_value * s[k];
@@ -441,11 +540,70 @@ void GridSequence::evaluate(const double x[], double y[]) const{
     }
 }
 void GridSequence::evaluateBatch(const double x[], int num_x, double y[]) const{
+    evaluateBatchTempl<double>(x, num_x, surpluses.getStrip(0), y);
+}
+void GridSequence::evaluateBatch(const double x[], int num_x, float y[]) const{
+    evaluateBatchTempl<float>(x, num_x, getFloatCoefficients(surpluses.getStrip(0), surpluses.getTotalEntries()), y);
+}
+template<typename T>
+void GridSequence::evaluateBatchTempl(const double x[], int num_x, const T surp[], T y[]) const{
+    // each block of points is handled by a single thread, the surpluses are loaded once per block
+    constexpr int max_block_size = 16;
+    int num_blocks = num_x / max_block_size + ((num_x % max_block_size == 0) ? 0 : 1);
     Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
-    Utils::Wrapper2D<double> ywrap(num_outputs, y);
-    #pragma omp parallel for
-    for(int i=0; i<num_x; i++)
-        evaluate(xwrap.getStrip(i), ywrap.getStrip(i));
+    Utils::Wrapper2D<T> ywrap(num_outputs, y);
+    #pragma omp parallel for schedule(dynamic)
+    for(int b=0; b<num_blocks; b++){
+        int block_start = b * max_block_size;
+        evaluateBlock<T>(xwrap.getStrip(block_start), std::min(max_block_size, num_x - block_start), surp, ywrap.getStrip(block_start));
+    }
+}
+template<typename T>
+void GridSequence::evaluateBlock(const double x[], int num_x, const T surp[], T y[]) const{
+    // the basis functions are computed for a chunk of points (and all x), then the chunk is multiplied by the surpluses
+    // the outputs are split into tiles so that the tile of y for all x stays in L1 cache
+    constexpr int chunk_size = 256;
+    int num_points = points.getNumIndexes();
+    int tile_size = std::max(8, 4096 / num_x);
+
+    std::fill_n(y, Utils::size_mult(num_x, num_outputs), 0.0);
+    std::vector<std::vector<std::vector<double>>> cache((size_t) num_x);
+    for(int k=0; k<num_x; k++) cache[k] = cacheBasisValues<double>(&(x[Utils::size_mult(k, num_dimensions)]));
+
+    // points are sorted lexicographically and consecutive points share leading indexes (i.e., the points form a prefix tree)
+    // partial[j] holds the product of the basis values for directions 0 ... j, only directions past the shared prefix are recomputed
+    Data2D<double> partial(num_x, num_dimensions);
+    Data2D<T> basis(num_x, chunk_size);
+
+    for(int chunk_start=0; chunk_start<num_points; chunk_start+=chunk_size){
+        int chunk_end = std::min(num_points, chunk_start + chunk_size);
+        for(int i=chunk_start; i<chunk_end; i++){
+            const int* p = points.getIndex(i);
+            for(int j=shared_prefix[i]; j<num_dimensions; j++){
+                double *w = partial.getStrip(j);
+                if (j == 0){
+                    for(int k=0; k<num_x; k++) w[k] = cache[k][0][p[0]];
+                }else{
+                    const double *wprev = partial.getStrip(j-1);
+                    for(int k=0; k<num_x; k++) w[k] = wprev[k] * cache[k][j][p[j]];
+                }
+            }
+            std::transform(partial.getStrip(num_dimensions - 1), partial.getStrip(num_dimensions - 1) + num_x, basis.getStrip(i - chunk_start), [](double w)->T{ return (T) w; });
+        }
+
+        for(int tile_start=0; tile_start<num_outputs; tile_start+=tile_size){
+            int tile_end = std::min(num_outputs, tile_start + tile_size);
+            for(int i=chunk_start; i<chunk_end; i++){
+                const T *s = &(surp[Utils::size_mult(i, num_outputs)]);
+                const T *b = basis.getStrip(i - chunk_start);
+                for(int k=0; k<num_x; k++){
+                    T *this_y = &(y[Utils::size_mult(k, num_outputs)]);
+                    T bk = b[k];
+                    for(int o=tile_start; o<tile_end; o++) this_y[o] += bk * s[o];
+                }
+            }
+        }
+    }
 }
 
 #ifdef Tasmanian_ENABLE_BLAS
@@ -459,6 +617,13 @@ void GridSequence::evaluateBlas(const double x[], int num_x, double y[]) const{
     }
     TasBLAS::denseMultiply(num_outputs, num_x, num_points, 1.0, surpluses.getStrip(0), weights.getStrip(0), 0.0, y);
 }
+void GridSequence::evaluateBlas(const double x[], int num_x, float y[]) const{
+    const float *fcoeff = getFloatCoefficients(surpluses.getStrip(0), surpluses.getTotalEntries());
+    int num_points = points.getNumIndexes();
+    Data2D<float> weights(num_points, num_x);
+    evaluateHierarchicalFunctionsTempl<float>(x, num_x, weights.getStrip(0));
+    TasBLAS::denseMultiply(num_outputs, num_x, num_points, 1.0f, fcoeff, weights.getStrip(0), 0.0f, y);
+}
 #endif // Tasmanian_ENABLE_BLAS
 
 #ifdef Tasmanian_ENABLE_CUDA
@@ -521,14 +686,22 @@ void GridSequence::integrate(double q[], double *conformal_correction) const{
 }
 
 void GridSequence::evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const{
+    evaluateHierarchicalFunctionsTempl<double>(x, num_x, y);
+}
+void GridSequence::evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const{
+    evaluateHierarchicalFunctionsTempl<float>(x, num_x, y);
+}
+template<typename T>
+void GridSequence::evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const{
     int num_points = (points.empty()) ? needed.getNumIndexes() : points.getNumIndexes();
     Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
-    Utils::Wrapper2D<double> ywrap(num_points, y);
+    Utils::Wrapper2D<T> ywrap(num_points, y);
     #pragma omp parallel for
     for(int i=0; i<num_x; i++)
-        evalHierarchicalFunctions(xwrap.getStrip(i), ywrap.getStrip(i));
+        evalHierarchicalFunctions<T>(xwrap.getStrip(i), ywrap.getStrip(i));
 }
-void GridSequence::evalHierarchicalFunctions(const double x[], double fvalues[]) const{
+template<typename T>
+void GridSequence::evalHierarchicalFunctions(const double x[], T fvalues[]) const{
     const MultiIndexSet& work = (points.empty()) ? needed : points;
     int num_points = work.getNumIndexes();
 
@@ -536,10 +709,11 @@ void GridSequence::evalHierarchicalFunctions(const double x[], double fvalues[])
 
     for(int i=0; i<num_points; i++){
         const int* p = work.getIndex(i);
-        fvalues[i] = cache[0][p[0]];
+        double v = cache[0][p[0]];
         for(int j=1; j<num_dimensions; j++){
-            fvalues[i] *= cache[j][p[j]];
+            v *= cache[j][p[j]];
         }
+        fvalues[i] = (T) v;
     }
 }
 #ifdef Tasmanian_ENABLE_CUDA
@@ -552,6 +726,7 @@ void GridSequence::setHierarchicalCoefficients(const double c[], TypeAcceleratio
     #ifdef Tasmanian_ENABLE_CUDA
     clearCudaSurpluses(); // points have not changed, just clear surpluses
     #endif
+    clearFloatCoefficients();
     int num_ponits = getNumPoints();
     size_t num_vals = ((size_t) num_ponits) * ((size_t) num_outputs);
     if (!points.empty()){
@@ -559,6 +734,7 @@ void GridSequence::setHierarchicalCoefficients(const double c[], TypeAcceleratio
     }else{
         points = std::move(needed);
         needed = MultiIndexSet();
+        cacheSharedPrefixes();
     }
     std::vector<double> &vals = values.getVector();
     vals.resize(num_vals);
@@ -743,7 +919,7 @@ std::vector<int> GridSequence::getPolynomialSpace(bool interpolation) const{
     }
 }
 const double* GridSequence::getSurpluses() const{
-    return surpluses.getVector().data();
+    return surpluses.getStrip(0);
 }
 const int* GridSequence::getPointIndexes() const{
     return ((points.empty()) ? needed.getIndex(0) : points.getIndex(0));
@@ -791,6 +967,22 @@ void GridSequence::prepareSequence(int num_external){
         coeff[i] = 1.0;
         for(int j=0; j<i; j++) coeff[i] *= (nodes[i] - nodes[j]);
     }
+
+    cacheSharedPrefixes();
+}
+
+void GridSequence::cacheSharedPrefixes(){
+    int num_points = points.getNumIndexes();
+    shared_prefix.resize((size_t) num_points);
+    if (num_points == 0) return;
+    shared_prefix[0] = 0;
+    for(int i=1; i<num_points; i++){
+        const int *p = points.getIndex(i);
+        const int *prev = points.getIndex(i-1);
+        int j = 0;
+        while((j < num_dimensions - 1) && (p[j] == prev[j])) j++;
+        shared_prefix[i] = j;
+    }
 }
 
 std::vector<double> GridSequence::cacheBasisIntegrals() const{
@@ -829,11 +1021,16 @@ double GridSequence::evalBasis(const int f[], const int p[]) const{
 }
 
 void GridSequence::recomputeSurpluses(){
+    clearFloatCoefficients();
     int num_points = points.getNumIndexes();
     surpluses.resize(num_outputs, num_points);
     surpluses.getVector() = values.getVector();
 
-    std::vector<int> level = MultiIndexManipulations::computeLevels(points);
+    updateSurpluses(MultiIndexManipulations::computeLevels(points));
+}
+
+void GridSequence::updateSurpluses(std::vector<int> const &level){
+    int num_points = points.getNumIndexes();
     int top_level = *std::max_element(level.begin(), level.end());
 
     Data2D<int> parents = MultiIndexManipulations::computeDAGup(points);
@@ -842,42 +1039,51 @@ void GridSequence::recomputeSurpluses(){
     for(int i=0; i<num_points; i++)
         if (level[i] > 0) indexses_for_levels[level[i]].push_back(i);
 
-    for(int l=1; l<=top_level; l++){
-        int level_size = (int) indexses_for_levels[l].size();
-        #pragma omp parallel for schedule(dynamic)
-        for(int s=0; s<level_size; s++){
-            int i = indexses_for_levels[l][s];
+    #pragma omp parallel
+    {
+        // the used flags are allocated once per thread and only the entries visited by the last point are cleared
+        std::vector<bool> used(num_points, false);
+        std::vector<int> visited;
+        std::vector<int> monkey_count(top_level + 1);
+        std::vector<int> monkey_tail(top_level + 1);
 
-            const int* p = points.getIndex(i);
-            double *surpi = surpluses.getStrip(i);
+        for(int l=1; l<=top_level; l++){
+            int level_size = (int) indexses_for_levels[l].size();
+            #pragma omp for schedule(dynamic)
+            for(int s=0; s<level_size; s++){
+                int i = indexses_for_levels[l][s];
 
-            std::vector<int> monkey_count(top_level + 1);
-            std::vector<int> monkey_tail(top_level + 1);
-            std::vector<bool> used(num_points, false);
+                const int* p = points.getIndex(i);
+                double *surpi = surpluses.getStrip(i);
 
-            int current = 0;
+                for(auto v : visited) used[v] = false;
+                visited.clear();
 
-            monkey_count[0] = 0;
-            monkey_tail[0] = i;
+                int current = 0;
 
-            while(monkey_count[0] < num_dimensions){
-                if (monkey_count[current] < num_dimensions){
-                    int branch = parents.getStrip(monkey_tail[current])[monkey_count[current]];
-                    if ((branch == -1) || (used[branch])){
-                        monkey_count[current]++;
-                    }else{
-                        const double *branch_surp = surpluses.getStrip(branch);;
-                        double basis_value = evalBasis(points.getIndex(branch), p);
-                        for(int k=0; k<num_outputs; k++){
-                                surpi[k] -= basis_value * branch_surp[k];
-                        }
-                        used[branch] = true;
+                monkey_count[0] = 0;
+                monkey_tail[0] = i;
 
-                        monkey_count[++current] = 0;
-                        monkey_tail[current] = branch;
+                while(monkey_count[0] < num_dimensions){
+                    if (monkey_count[current] < num_dimensions){
+                        int branch = parents.getStrip(monkey_tail[current])[monkey_count[current]];
+                        if ((branch == -1) || (used[branch])){
+                            monkey_count[current]++;
+                        }else{
+                            const double *branch_surp = surpluses.getStrip(branch);;
+                            double basis_value = evalBasis(points.getIndex(branch), p);
+                            for(int k=0; k<num_outputs; k++){
+                                    surpi[k] -= basis_value * branch_surp[k];
+                            }
+                            used[branch] = true;
+                            visited.push_back(branch);
+
+                            monkey_count[++current] = 0;
+                            monkey_tail[current] = branch;
+                        }
+                    }else{
+                        monkey_count[--current]++;
                     }
-                }else{
-                    monkey_count[--current]++;
                 }
             }
         }
@@ -932,6 +1138,7 @@ void GridSequence::clearAccelerationData(){
     #ifdef Tasmanian_ENABLE_CUDA
     if (cuda_cache) cuda_cache.reset();
     #endif
+    clearFloatCoefficients();
 }
 
 
@@ -67,9 +67,11 @@ public:
     void integrate(double q[], double *conformal_correction) const;
 
     void evaluateBatch(const double x[], int num_x, double y[]) const;
+    void evaluateBatch(const double x[], int num_x, float y[]) const;
 
     #ifdef Tasmanian_ENABLE_BLAS
     void evaluateBlas(const double x[], int num_x, double y[]) const;
+    void evaluateBlas(const double x[], int num_x, float y[]) const;
     #endif
 
     #ifdef Tasmanian_ENABLE_CUDA
@@ -80,6 +82,7 @@ public:
     #endif
 
     void evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const;
+    void evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const;
     #ifdef Tasmanian_ENABLE_CUDA
     void evaluateHierarchicalFunctionsGPU(const double x[], int num_x, double y[]) const;
     #endif
@@ -99,6 +102,7 @@ public:
     std::vector<double> getCandidateConstructionPoints(TypeDepth type, int output, const std::vector<int> &level_limits);
     std::vector<double> getCandidateConstructionPoints(std::function<double(const int *)> getTensorWeight, const std::vector<int> &level_limits);
     void loadConstructedPoint(const double x[], const std::vector<double> &y);
+    void loadConstructedPoints(const double x[], int num_x, const double y[]);
     void finishConstruction();
 
     void setHierarchicalCoefficients(const double c[], TypeAcceleration acc);
@@ -113,10 +117,17 @@ public:
 protected:
     void reset();
 
-    void evalHierarchicalFunctions(const double x[], double fvalues[]) const;
+    template<typename T> void evalHierarchicalFunctions(const double x[], T fvalues[]) const;
+    template<typename T> void evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const;
+    //! \brief Evaluate the interpolant with either double or float outputs, \b surp is either the surpluses or the single precision copy.
+    template<typename T> void evaluateBatchTempl(const double x[], int num_x, const T surp[], T y[]) const;
+    //! \brief Evaluate the interpolant at a block of \b num_x points, uses the \b shared_prefix and output tiles.
+    template<typename T> void evaluateBlock(const double x[], int num_x, const T surp[], T y[]) const;
 
     //! \brief Cache the nodes and polynomial coefficients, cache is determined by the largest index in \b points and \b needed, or \b num_external (pass zero if not using dy-construction).
     void prepareSequence(int num_external);
+    //! \brief Compute the \b shared_prefix for the current \b points, called whenever the \b points change.
+    void cacheSharedPrefixes();
     std::vector<double> cacheBasisIntegrals() const;
 
     template<typename T>
@@ -140,6 +151,8 @@ protected:
 
     void expandGrid(const std::vector<int> &point, const std::vector<double> &values, const std::vector<double> &surplus);
     void recomputeSurpluses();
+    //! \brief Computes the surpluses of the points with non-zero \b level, the other surpluses must be set and the new ones must be initialized with the values.
+    void updateSurpluses(std::vector<int> const &level);
     void applyTransformationTransposed(double weights[]) const;
 
     double evalBasis(const int f[], const int p[]) const; // evaluate function corresponding to f at p
@@ -175,7 +188,7 @@ protected:
     }
     void loadCudaSurpluses() const{
         if (!cuda_cache) cuda_cache = std::unique_ptr<CudaSequenceData<double>>(new CudaSequenceData<double>);
-        if (cuda_cache->surpluses.empty()) cuda_cache->surpluses.load(surpluses.getVector());
+        if (cuda_cache->surpluses.empty()) cuda_cache->surpluses.load(surpluses.getTotalEntries(), surpluses.getStrip(0));
     }
     void clearCudaSurpluses(){ if (cuda_cache) cuda_cache->surpluses.clear(); }
     #endif
@@ -191,6 +204,9 @@ private:
 
     std::vector<int> max_levels;
 
+    // number of leading indexes that points[i] shares with points[i-1], used to skip redundant products in evaluate
+    std::vector<int> shared_prefix;
+
     std::unique_ptr<SimpleConstructData> dynamic_values;
 
     #ifdef Tasmanian_ENABLE_CUDA
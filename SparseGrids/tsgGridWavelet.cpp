@@ -36,7 +36,7 @@
 
 namespace TasGrid{
 
-GridWavelet::GridWavelet() : rule1D(1, 10), order(1){}
+GridWavelet::GridWavelet() : rule1D(1, wavelet_cascade_depth), order(1){}
 GridWavelet::~GridWavelet(){}
 
 void GridWavelet::reset(){
@@ -45,6 +45,8 @@ void GridWavelet::reset(){
     values = StorageSet();
     inter_matrix = TasSparse::SparseMatrix();
     coefficients.clear();
+    clearFloatCoefficients();
+    clearSolverWorkspaces();
 }
 
 template<bool useAscii> void GridWavelet::write(std::ostream &os) const{
@@ -52,19 +54,20 @@ template<bool useAscii> void GridWavelet::write(std::ostream &os) const{
     IO::writeNumbers<useAscii, IO::pad_line>(os, num_dimensions, num_outputs, order);
     IO::writeFlag<useAscii, IO::pad_auto>(!points.empty(), os);
     if (!points.empty()) points.write<useAscii>(os);
+    std::vector<int> levels = (IO::isCompressedFormat(os)) ? computeLevels() : std::vector<int>();
     if (useAscii){ // backwards compatible: surpluses and needed, or needed and surpluses
         IO::writeFlag<useAscii, IO::pad_auto>((coefficients.getNumStrips() != 0), os);
-        if (coefficients.getNumStrips() != 0) IO::writeVector<useAscii, IO::pad_line>(coefficients.getVector(), os);
+        if (coefficients.getNumStrips() != 0) IO::writeData2D<useAscii, IO::pad_line>(coefficients, os);
         IO::writeFlag<useAscii, IO::pad_auto>(!needed.empty(), os);
         if (!needed.empty()) needed.write<useAscii>(os);
     }else{
         IO::writeFlag<useAscii, IO::pad_auto>(!needed.empty(), os);
         if (!needed.empty()) needed.write<useAscii>(os);
         IO::writeFlag<useAscii, IO::pad_auto>((coefficients.getNumStrips() != 0), os);
-        if (coefficients.getNumStrips() != 0) IO::writeVector<useAscii, IO::pad_line>(coefficients.getVector(), os);
+        if (coefficients.getNumStrips() != 0) IO::writeLevelData2D<useAscii, IO::pad_line>(coefficients, levels, os);
     }
 
-    if (num_outputs > 0) values.write<useAscii>(os);
+    if (num_outputs > 0) values.write<useAscii>(os, levels);
 }
 template<bool useAscii> void GridWavelet::read(std::istream &is){
     reset();
@@ -74,6 +77,7 @@ template<bool useAscii> void GridWavelet::read(std::istream &is){
     rule1D.updateOrder(order);
 
     if (IO::readFlag<useAscii>(is)) points.read<useAscii>(is);
+    std::vector<int> levels = (IO::isCompressedFormat(is)) ? computeLevels() : std::vector<int>();
     if (useAscii){ // backwards compatible: surpluses and needed, or needed and surpluses
         if (IO::readFlag<useAscii>(is))
             coefficients = IO::readData2D<useAscii, double>(is, num_outputs, points.getNumIndexes());
@@ -81,10 +85,10 @@ template<bool useAscii> void GridWavelet::read(std::istream &is){
     }else{
         if (IO::readFlag<useAscii>(is)) needed.read<useAscii>(is);
         if (IO::readFlag<useAscii>(is))
-            coefficients = IO::readData2D<useAscii, double>(is, num_outputs, points.getNumIndexes());
+            coefficients = IO::readLevelData2D<useAscii>(is, num_outputs, points.getNumIndexes(), levels);
     }
 
-    if (num_outputs > 0) values.read<useAscii>(is);
+    if (num_outputs > 0) values.read<useAscii>(is, levels);
     buildInterpolationMatrix();
 }
 
@@ -187,7 +191,7 @@ void GridWavelet::getQuadratureWeights(double *weights) const{
 	for(int i=0; i<num_points; i++){
 		weights[i] = evalIntegral(work.getIndex(i));
 	}
-	solveTransposed(weights);
+	solveTransposedPooled(weights);
 }
 void GridWavelet::getInterpolationWeights(const double x[], double *weights) const{
     const MultiIndexSet &work = (points.empty()) ? needed : points;
@@ -196,31 +200,43 @@ void GridWavelet::getInterpolationWeights(const double x[], double *weights) con
 	for(int i=0; i<num_points; i++){
         weights[i] = evalBasis(work.getIndex(i), x);
 	}
-	solveTransposed(weights);
+	solveTransposedPooled(weights);
 }
 void GridWavelet::loadNeededPoints(const double *vals){
     #ifdef Tasmanian_ENABLE_CUDA
     clearCudaCoefficients();
     #endif
+    bool warm_start = false; // if the points were loaded before, the current coefficients are used as initial guess for the solver
     if (points.empty()){
         values.setValues(vals);
         points = std::move(needed);
         needed = MultiIndexSet();
     }else if (needed.empty()){
         values.setValues(vals);
+        warm_start = true;
     }else{
+        // the coefficients of the new points are set to zero, the existing points keep their coefficients
+        warm_start = (coefficients.getNumStrips() == points.getNumIndexes());
+        StorageSet guess;
+        if (warm_start){
+            guess.resize(num_outputs, points.getNumIndexes());
+            guess.setValues(std::move(coefficients.getVector()));
+            guess.addValues(points, needed, std::vector<double>(Utils::size_mult(num_outputs, needed.getNumIndexes()), 0.0).data());
+        }
         values.addValues(points, needed, vals);
         points.addMultiIndexSet(needed);
         needed = MultiIndexSet();
         buildInterpolationMatrix();
+        if (warm_start) coefficients = Data2D<double>(num_outputs, points.getNumIndexes(), std::move(guess.getVector()));
     }
-    recomputeCoefficients();
+    recomputeCoefficients(warm_start);
 }
 void GridWavelet::mergeRefinement(){
     if (needed.empty()) return; // nothing to do
     #ifdef Tasmanian_ENABLE_CUDA
     clearCudaCoefficients();
     #endif
+    clearFloatCoefficients();
     int num_all_points = getNumLoaded() + getNumNeeded();
     size_t size_vals = ((size_t) num_all_points) * ((size_t) num_outputs);
     values.setValues(std::vector<double>(size_vals, 0.0));
@@ -246,12 +262,80 @@ void GridWavelet::evaluate(const double x[], double y[]) const{
             y[k] += basis_value * s[k];
     }
 }
-void GridWavelet::evaluateBatch(const double x[], int num_x, double y[]) const{
-    Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
-    Utils::Wrapper2D<double> ywrap(num_outputs, y);
+template<typename callable>
+void GridWavelet::walkBasisBlocks(const MultiIndexSet &work, const double x[], int num_x, callable apply) const{
+    int num_points = work.getNumIndexes();
+    int block_size = wavelet_block_size;
+
+    // used[j] lists the one dimensional wavelets present in direction j, slot[j][w] is the position of w in used[j]
+    std::vector<std::vector<int>> used((size_t) num_dimensions), slot((size_t) num_dimensions);
+    for(int j=0; j<num_dimensions; j++){
+        int max_index = 0;
+        for(int i=0; i<num_points; i++) max_index = std::max(max_index, work.getIndex(i)[j]);
+        slot[j].resize((size_t) (max_index + 1), -1);
+        for(int i=0; i<num_points; i++) slot[j][work.getIndex(i)[j]] = 0;
+        for(int w=0; w<=max_index; w++){
+            if (slot[j][w] == 0){
+                slot[j][w] = (int) used[j].size();
+                used[j].push_back(w);
+            }
+        }
+    }
+
+    int num_blocks = num_x / block_size + ((num_x % block_size == 0) ? 0 : 1);
     #pragma omp parallel for
-    for(int i=0; i<num_x; i++)
-        evaluate(xwrap.getStrip(i), ywrap.getStrip(i));
+    for(int b=0; b<num_blocks; b++){
+        int first = b * block_size;
+        int num_block = std::min(block_size, num_x - first);
+        size_t nb = (size_t) num_block;
+
+        std::vector<double> xdim(nb), v(nb);
+        std::vector<std::vector<double>> cache((size_t) num_dimensions);
+        for(int j=0; j<num_dimensions; j++){
+            for(size_t k=0; k<nb; k++) xdim[k] = x[(first + k) * num_dimensions + j];
+            cache[j].resize(used[j].size() * nb);
+            for(size_t s=0; s<used[j].size(); s++)
+                rule1D.eval(used[j][s], num_block, xdim.data(), &(cache[j][s * nb]));
+        }
+
+        for(int i=0; i<num_points; i++){
+            const int *p = work.getIndex(i);
+            std::copy_n(&(cache[0][slot[0][p[0]] * nb]), nb, v.data());
+            for(int j=1; j<num_dimensions; j++){
+                const double *c = &(cache[j][slot[j][p[j]] * nb]);
+                #pragma omp simd
+                for(size_t k=0; k<nb; k++) v[k] *= c[k];
+            }
+            apply(first, num_block, i, v.data());
+        }
+    }
+}
+
+void GridWavelet::evaluateBatch(const double x[], int num_x, double y[]) const{
+    std::fill_n(y, Utils::size_mult(num_outputs, num_x), 0.0);
+    walkBasisBlocks(points, x, num_x, [&](int first, int num_block, int i, const double v[])->void{
+        const double *s = coefficients.getStrip(i);
+        for(int k=0; k<num_block; k++){
+            if (v[k] != 0.0){
+                double *this_y = &(y[Utils::size_mult(first + k, num_outputs)]);
+                for(int o=0; o<num_outputs; o++) this_y[o] += v[k] * s[o];
+            }
+        }
+    });
+}
+void GridWavelet::evaluateBatch(const double x[], int num_x, float y[]) const{
+    const float *coeff = getFloatCoefficients(coefficients.getStrip(0), coefficients.getTotalEntries());
+    std::fill_n(y, Utils::size_mult(num_outputs, num_x), 0.0f);
+    walkBasisBlocks(points, x, num_x, [&](int first, int num_block, int i, const double v[])->void{
+        const float *s = &(coeff[Utils::size_mult(i, num_outputs)]);
+        for(int k=0; k<num_block; k++){
+            float basis_value = (float) v[k];
+            if (basis_value != 0.0f){
+                float *this_y = &(y[Utils::size_mult(first + k, num_outputs)]);
+                for(int o=0; o<num_outputs; o++) this_y[o] += basis_value * s[o];
+            }
+        }
+    });
 }
 
 #ifdef Tasmanian_ENABLE_BLAS
@@ -261,6 +345,13 @@ void GridWavelet::evaluateBlas(const double x[], int num_x, double y[]) const{
     evaluateHierarchicalFunctions(x, num_x, weights.getStrip(0));
     TasBLAS::denseMultiply(num_outputs, num_x, num_points, 1.0, coefficients.getStrip(0), weights.getStrip(0), 0.0, y);
 }
+void GridWavelet::evaluateBlas(const double x[], int num_x, float y[]) const{
+    const float *coeff = getFloatCoefficients(coefficients.getStrip(0), coefficients.getTotalEntries());
+    int num_points = points.getNumIndexes();
+    Data2D<float> weights(num_points, num_x);
+    evaluateHierarchicalFunctionsTempl<float>(x, num_x, weights.getStrip(0));
+    TasBLAS::denseMultiply(num_outputs, num_x, num_points, 1.0f, coeff, weights.getStrip(0), 0.0f, y);
+}
 #endif
 
 #ifdef Tasmanian_ENABLE_CUDA
@@ -330,13 +421,70 @@ double GridWavelet::evalIntegral(const int p[]) const{
 }
 
 void GridWavelet::buildInterpolationMatrix(){
-    // updated code, using better parallelism
-    // Wavelets don't have a nice rule of support to use monkeys and graphs (or I cannot find the support rule)
+    // the wavelets that are non-zero at a node are found from the supports of the one dimensional wavelets,
+    // then the multi-dimensional candidates are enumerated with a trie over the sorted multi-indexes
+    // the values and the order of the entries are the same as when testing all pairs of nodes and basis functions
     MultiIndexSet &work = (points.empty()) ? needed : points;
     inter_matrix = TasSparse::SparseMatrix();
 
     int num_points = work.getNumIndexes();
 
+    // supported[j][b] lists the one dimensional wavelets (used in direction j) that are non-zero at node b, sorted by wavelet index
+    std::vector<std::vector<std::vector<std::pair<int, double>>>> supported((size_t) num_dimensions);
+    for(int j=0; j<num_dimensions; j++){
+        int max_index = 0;
+        for(int i=0; i<num_points; i++) max_index = std::max(max_index, work.getIndex(i)[j]);
+        std::vector<bool> is_used((size_t) (max_index + 1), false);
+        for(int i=0; i<num_points; i++) is_used[work.getIndex(i)[j]] = true;
+        std::vector<int> used;
+        for(int k=0; k<=max_index; k++) if (is_used[k]) used.push_back(k);
+
+        std::vector<int> by_node = used;
+        std::sort(by_node.begin(), by_node.end(), [&](int a, int b)->bool{ return (rule1D.getNode(a) < rule1D.getNode(b)); });
+        std::vector<double> nodes(by_node.size());
+        std::transform(by_node.begin(), by_node.end(), nodes.begin(), [&](int b)->double{ return rule1D.getNode(b); });
+
+        supported[j].resize((size_t) (max_index + 1));
+        for(auto w : used){ // w is increasing, the lists are sorted
+            double left, right;
+            rule1D.getSupport(w, left, right);
+            size_t first = (size_t) std::distance(nodes.begin(), std::lower_bound(nodes.begin(), nodes.end(), left));
+            size_t last  = (size_t) std::distance(nodes.begin(), std::upper_bound(nodes.begin(), nodes.end(), right));
+            for(size_t k=first; k<last; k++){
+                double v = rule1D.eval(w, nodes[k]);
+                if (v != 0.0) supported[j][by_node[k]].push_back(std::make_pair(w, v));
+            }
+        }
+    }
+
+    // level k of the trie holds the distinct prefixes of length k+1 of the multi-indexes,
+    // keys[k] is the last entry of each prefix, the extensions of prefix i are offsets[k][i] to offsets[k][i+1] on level k+1
+    // the sets built during refinement (see buildUpdateMap()) are not always in lexicographical order,
+    // the trie uses the lexicographical permutation lex and the leaves are mapped back to the rows of work
+    std::vector<int> lex((size_t) num_points);
+    std::iota(lex.begin(), lex.end(), 0);
+    auto lex_less = [&](int a, int b)->bool{
+        const int *ia = work.getIndex(a), *ib = work.getIndex(b);
+        return std::lexicographical_compare(ia, ia + num_dimensions, ib, ib + num_dimensions);
+    };
+    bool is_lexicographical = std::is_sorted(lex.begin(), lex.end(), lex_less);
+    if (!is_lexicographical) std::sort(lex.begin(), lex.end(), lex_less);
+
+    std::vector<std::vector<int>> keys((size_t) num_dimensions), offsets((size_t) num_dimensions);
+    for(int i=0; i<num_points; i++){
+        const int *p = work.getIndex(lex[i]);
+        int k = 0;
+        if (i > 0){
+            const int *prev = work.getIndex(lex[i-1]);
+            while(p[k] == prev[k]) k++;
+        }
+        for(int j=k; j<num_dimensions; j++){
+            if (j + 1 < num_dimensions) offsets[j].push_back((int) keys[j+1].size());
+            keys[j].push_back(p[j]);
+        }
+    }
+    for(int j=0; j+1<num_dimensions; j++) offsets[j].push_back((int) keys[j+1].size());
+
     int num_chunk = 32;
     int num_blocks = num_points / num_chunk + ((num_points % num_chunk == 0) ? 0 : 1);
 
@@ -346,79 +494,105 @@ void GridWavelet::buildInterpolationMatrix(){
 
     #pragma omp parallel for
     for(int b=0; b<num_blocks; b++){
+        std::vector<int> cursor((size_t) num_dimensions), first((size_t) num_dimensions), last((size_t) num_dimensions);
+        std::vector<double> partial((size_t) num_dimensions);
+        std::vector<std::pair<int, double>> row;
         int block_end = (b < num_blocks - 1) ? (b+1) * num_chunk : num_points;
         for(int i=b * num_chunk; i < block_end; i++){
             const int *p = work.getIndex(i);
-            std::vector<double> xi(num_dimensions);
-            for(int j = 0; j<num_dimensions; j++) // get the node
-                xi[j] = rule1D.getNode(p[j]);
-
-            // loop over the basis functions to see if supported
-            int numpntr = 0;
-            for(int wi=0; wi<num_points; wi++){
-                const int *w = work.getIndex(wi);
-
-                double v = 1.0;
-                for(int j=0; j<num_dimensions; j++){
-                    v *= rule1D.eval(w[j], xi[j]);
-                    if (v == 0.0) break; // evaluating the wavelets is expensive, stop if any one of them is zero
+
+            // depth-first search of the trie, level k considers the wavelets supported at p[k]
+            row.clear();
+            int k = 0;
+            cursor[0] = 0;
+            first[0] = 0;
+            last[0] = (int) keys[0].size();
+            partial[0] = 1.0;
+            while(k >= 0){
+                auto const &candidates = supported[k][p[k]];
+                if ((size_t) cursor[k] == candidates.size()){
+                    k--;
+                    continue;
+                }
+                auto const &c = candidates[cursor[k]++];
+                const int *lkeys = keys[k].data();
+                int pos = (int) std::distance(lkeys, std::lower_bound(lkeys + first[k], lkeys + last[k], c.first));
+                first[k] = pos; // the candidates are sorted, the next search starts here
+                if (pos == last[k]){
+                    cursor[k] = (int) candidates.size();
+                    continue;
                 }
+                if (lkeys[pos] != c.first) continue;
+                first[k]++;
 
-                if(v != 0.0){ // testing != is safe since it can only happen in multiplication by 0.0
-                    indx[b].push_back(wi);
-                    vals[b].push_back(v);
-                    numpntr++;
+                double v = partial[k] * c.second;
+                if (k == num_dimensions - 1){
+                    if (v != 0.0) // can be zero only with underflow
+                        row.push_back(std::make_pair(lex[pos], v));
+                }else{
+                    cursor[k+1] = 0;
+                    first[k+1] = offsets[k][pos];
+                    last[k+1] = offsets[k][pos+1];
+                    partial[k+1] = v;
+                    k++;
                 }
             }
-            pntr[i] = numpntr;
+            if (!is_lexicographical) std::sort(row.begin(), row.end(), [](std::pair<int, double> const &a, std::pair<int, double> const &c)->bool{ return (a.first < c.first); });
+            for(auto const &e : row){
+                indx[b].push_back(e.first);
+                vals[b].push_back(e.second);
+            }
+            pntr[i] = (int) row.size();
         }
     }
 
     inter_matrix.load(pntr, indx, vals);
 }
 
-void GridWavelet::recomputeCoefficients(){
+void GridWavelet::recomputeCoefficients(bool use_initial_guess){
     // Recalculates the coefficients to interpolate the values in points.
     //  Make sure buildInterpolationMatrix has been called since the list was updated.
+    clearFloatCoefficients();
 
     int num_points = points.getNumIndexes();
-    coefficients.resize(num_outputs, num_points);
+    use_initial_guess = use_initial_guess && (coefficients.getNumStrips() == num_points) && (coefficients.getStride() == (size_t) num_outputs);
+    if (!use_initial_guess) coefficients.resize(num_outputs, num_points);
 
     if (inter_matrix.getNumRows() != num_points) buildInterpolationMatrix();
 
-    std::vector<double> b(num_points), x(num_points);
-
-	for(int output = 0; output < num_outputs; output++){
-        // Copy relevant portion
-        std::fill(x.begin(), x.end(), 0.0);
-        std::fill(b.begin(), b.end(), 0.0);
-
-        // Populate RHS
-        for(int i = 0; i < num_points; i++){
-            b[i] = values.getValues(i)[output];
-        }
-
-        // Solve system
-        inter_matrix.solve(b.data(), x.data());
-
-        // Populate surplus
-        for(int i = 0; i < num_points; i++){
-            coefficients.getStrip(i)[output] = x[i];
-        }
-    }
+    // the values and the coefficients have the outputs of each point stored contiguously, all outputs are solved together
+    inter_matrix.solve(num_outputs, values.getValues(0), coefficients.getStrip(0), use_initial_guess);
 }
 
-void GridWavelet::solveTransposed(double w[]) const{
+void GridWavelet::solveTransposed(double w[], TasSparse::SparseMatrix::SolverWorkspace &workspace) const{
     // Solves the system A^T * w = y. Used to calculate interpolation and integration
     // weights. RHS values should be passed in through w. At exit, w will contain the
     // required weights.
     int num_points = inter_matrix.getNumRows();
 
-    std::vector<double> y(num_points);
+    std::vector<double> &y = workspace.rhs;
+    y.resize(num_points);
 
     std::copy(w, w + num_points, y.data());
 
-    inter_matrix.solve(y.data(), w, true);
+    inter_matrix.solve(y.data(), w, true, false, workspace);
+}
+
+void GridWavelet::solveTransposedPooled(double w[]) const{
+    std::unique_ptr<TasSparse::SparseMatrix::SolverWorkspace> workspace;
+    {
+        std::lock_guard<std::mutex> lock(solver_workspaces_lock);
+        if (!solver_workspaces.empty()){
+            workspace = std::move(solver_workspaces.back());
+            solver_workspaces.pop_back();
+        }
+    }
+    if (!workspace) workspace = std::unique_ptr<TasSparse::SparseMatrix::SolverWorkspace>(new TasSparse::SparseMatrix::SolverWorkspace);
+
+    solveTransposed(w, *workspace);
+
+    std::lock_guard<std::mutex> lock(solver_workspaces_lock);
+    solver_workspaces.push_back(std::move(workspace));
 }
 
 std::vector<double> GridWavelet::getNormalization() const{
@@ -432,6 +606,16 @@ std::vector<double> GridWavelet::getNormalization() const{
     }
     return norm;
 }
+std::vector<int> GridWavelet::computeLevels() const{
+    std::vector<int> levels((size_t) points.getNumIndexes());
+    for(int i=0; i<points.getNumIndexes(); i++){
+        const int *p = points.getIndex(i);
+        int l = rule1D.getLevel(p[0]);
+        for(int j=1; j<num_dimensions; j++) l += rule1D.getLevel(p[j]);
+        levels[(size_t) i] = l;
+    }
+    return levels;
+}
 Data2D<int> GridWavelet::buildUpdateMap(double tolerance, TypeRefinement criteria, int output) const{
     int num_points = points.getNumIndexes();
     Data2D<int> pmap(num_dimensions, num_points);
@@ -571,30 +755,26 @@ const double* GridWavelet::getSurpluses() const{
 }
 
 void GridWavelet::evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const{
+    evaluateHierarchicalFunctionsTempl<double>(x, num_x, y);
+}
+void GridWavelet::evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const{
+    evaluateHierarchicalFunctionsTempl<float>(x, num_x, y);
+}
+template<typename T>
+void GridWavelet::evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const{
     const MultiIndexSet &work = (points.empty()) ? needed : points;
     int num_points = work.getNumIndexes();
-    Utils::Wrapper2D<double const> xwrap(num_dimensions, x);
-    Utils::Wrapper2D<double> ywrap(num_points, y);
-    #pragma omp parallel for
-    for(int i=0; i<num_x; i++){
-        double const *this_x = xwrap.getStrip(i);
-        double *this_y = ywrap.getStrip(i);
-        for(int j=0; j<num_points; j++){
-            const int* p = work.getIndex(j);
-            double v = 1.0;
-            for(int k=0; k<num_dimensions; k++){
-                v *= rule1D.eval(p[k], this_x[k]);
-                if (v == 0.0){ break; }; // MIRO: evaluating the wavelets is expensive, stop if any one of them is zero
-            }
-            this_y[j] = v;
-        }
-    }
+    Utils::Wrapper2D<T> ywrap(num_points, y);
+    walkBasisBlocks(work, x, num_x, [&](int first, int num_block, int i, const double v[])->void{
+        for(int k=0; k<num_block; k++) ywrap.getStrip(first + k)[i] = (T) v[k];
+    });
 }
 
 void GridWavelet::setHierarchicalCoefficients(const double c[], TypeAcceleration){
     #ifdef Tasmanian_ENABLE_CUDA
     clearCudaCoefficients();
     #endif
+    clearFloatCoefficients();
     int num_points = getNumPoints();
     size_t size_coeff = ((size_t) num_points) * ((size_t) num_outputs);
     if (!points.empty()){
@@ -660,6 +840,7 @@ void GridWavelet::clearAccelerationData(){
     #ifdef Tasmanian_ENABLE_CUDA
     if (cuda_cache) cuda_cache.reset();
     #endif
+    clearFloatCoefficients();
 }
 
 }
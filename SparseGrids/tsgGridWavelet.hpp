@@ -65,9 +65,11 @@ public:
     void integrate(double q[], double *conformal_correction) const;
 
     void evaluateBatch(const double x[], int num_x, double y[]) const;
+    void evaluateBatch(const double x[], int num_x, float y[]) const;
 
     #ifdef Tasmanian_ENABLE_BLAS
     void evaluateBlas(const double x[], int num_x, double y[]) const;
+    void evaluateBlas(const double x[], int num_x, float y[]) const;
     #endif
 
     #ifdef Tasmanian_ENABLE_CUDA
@@ -82,6 +84,7 @@ public:
     void mergeRefinement();
 
     void evaluateHierarchicalFunctions(const double x[], int num_x, double y[]) const;
+    void evaluateHierarchicalFunctions(const double x[], int num_x, float y[]) const;
 
     void setHierarchicalCoefficients(const double c[], TypeAcceleration acc);
 
@@ -93,13 +96,31 @@ public:
 protected:
     void reset();
 
+    template<typename T> void evaluateHierarchicalFunctionsTempl(const double x[], int num_x, T y[]) const;
+
+    // splits x into blocks of wavelet_block_size and calls apply(first, num_block, i, v) for each basis function i of work,
+    // where v holds the values of the basis function at the num_block points that start at first,
+    // the one dimensional wavelets are evaluated (with the vectorized rule1D.eval()) once per block and are shared by all basis functions
+    template<typename callable> void walkBasisBlocks(const MultiIndexSet &work, const double x[], int num_x, callable apply) const;
+    static constexpr int wavelet_block_size = 32;
+    // depth of the cascade used to tabulate the one dimensional wavelets, i.e., the tables have 2^depth + 1 samples on [-1, 1],
+    // the linear wavelets are exact, the error of the cubic wavelets decays as 4^-depth and depth 10 gives at most 3.E-5 on every wavelet,
+    // the bound is the distance to the limit of the cascade, the tolerance is fixed and cannot be set by the user
+    static constexpr int wavelet_cascade_depth = 10;
+
     double evalBasis(const int p[], const double x[]) const;
     void buildInterpolationMatrix();
-    void recomputeCoefficients();
-    void solveTransposed(double w[]) const;
+    void recomputeCoefficients(bool use_initial_guess = false); // if use_initial_guess is true, the solver starts from the current coefficients
+    void solveTransposed(double w[], TasSparse::SparseMatrix::SolverWorkspace &workspace) const; // the workspace is owned by the caller and can be reused for multiple solves
+
+    // takes a workspace from the pool (or creates a new one if the pool is empty) and returns it to the pool when the solve is done,
+    // each thread calling getInterpolationWeights() holds a separate workspace, the buffers are allocated on first use and reused by later calls
+    void solveTransposedPooled(double w[]) const;
+    void clearSolverWorkspaces(){ solver_workspaces.clear(); }
     double evalIntegral(const int p[]) const;
 
     std::vector<double> getNormalization() const;
+    std::vector<int> computeLevels() const; // sum of the one dimensional levels of each point, used to group the coefficients in the compressed format
 
     Data2D<int> buildUpdateMap(double tolerance, TypeRefinement criteria, int output) const;
 
@@ -110,7 +131,7 @@ protected:
     #ifdef Tasmanian_ENABLE_CUDA
     void loadCudaCoefficients() const{
         if (!cuda_cache) cuda_cache = std::unique_ptr<CudaWaveletData<double>>(new CudaWaveletData<double>);
-        if (cuda_cache->coefficients.empty()) cuda_cache->coefficients.load(coefficients.getVector());
+        if (cuda_cache->coefficients.empty()) cuda_cache->coefficients.load(coefficients.getTotalEntries(), coefficients.getStrip(0));
     }
     void clearCudaCoefficients(){ if (cuda_cache) cuda_cache->coefficients.clear(); }
     #endif
@@ -126,6 +147,9 @@ private:
 
     TasSparse::SparseMatrix inter_matrix;
 
+    mutable std::vector<std::unique_ptr<TasSparse::SparseMatrix::SolverWorkspace>> solver_workspaces; // idle workspaces of solveTransposedPooled()
+    mutable std::mutex solver_workspaces_lock;
+
     #ifdef Tasmanian_ENABLE_CUDA
     mutable std::unique_ptr<CudaWaveletData<double>> cuda_cache;
     #endif
@@ -141,24 +141,34 @@ inline void touchAllImmediateRelatives(std::vector<int> &point, MultiIndexSet co
 /*!
  * \internal
  * \ingroup TasmanianHierarchyManipulations
- * \brief Split the \b data into strips with given \b stride and return into \b Data2D structures grouped by \b levels, preserves the order.
+ * \brief Split the \b data into \b num_strips strips with given \b stride and return into \b Data2D structures grouped by \b levels, preserves the order.
  *
  * \endinternal
  */
 template<typename T>
-std::vector<Data2D<T>> splitByLevels(size_t stride, std::vector<T> const &data, std::vector<int> const &levels){
+std::vector<Data2D<T>> splitByLevels(size_t stride, T const data[], size_t num_strips, std::vector<int> const &levels){
     size_t top_level = (size_t) *std::max_element(levels.begin(), levels.end());
 
     std::vector<Data2D<T>> split(top_level + 1, Data2D<T>(stride, 0));
 
-    for( struct {int i; typename std::vector<T>::const_iterator idata;} v = {0, data.begin()};
-         v.idata != data.end();
-         v.i++, std::advance(v.idata, stride))
-        split[levels[v.i]].appendStrip(v.idata);
+    for(size_t i=0; i<num_strips; i++)
+        split[levels[i]].appendStrip(data + i * stride);
 
     return split;
 }
 
+/*!
+ * \internal
+ * \ingroup TasmanianHierarchyManipulations
+ * \brief Overload that splits the entries of a vector.
+ *
+ * \endinternal
+ */
+template<typename T>
+std::vector<Data2D<T>> splitByLevels(size_t stride, std::vector<T> const &data, std::vector<int> const &levels){
+    return splitByLevels(stride, data.data(), data.size() / stride, levels);
+}
+
 }
 
 }
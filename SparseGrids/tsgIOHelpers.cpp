@@ -0,0 +1,865 @@
+/*
+ * Copyright (c) 2017, Miroslav Stoyanov
+ *
+ * This file is part of
+ * Toolkit for Adaptive Stochastic Modeling And Non-Intrusive ApproximatioN: TASMANIAN
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ *    and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse
+ *    or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * UT-BATTELLE, LLC AND THE UNITED STATES GOVERNMENT MAKE NO REPRESENTATIONS AND DISCLAIM ALL WARRANTIES, BOTH EXPRESSED AND IMPLIED.
+ * THERE ARE NO EXPRESS OR IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, OR THAT THE USE OF THE SOFTWARE WILL NOT INFRINGE ANY PATENT,
+ * COPYRIGHT, TRADEMARK, OR OTHER PROPRIETARY RIGHTS, OR THAT THE SOFTWARE WILL ACCOMPLISH THE INTENDED RESULTS OR THAT THE SOFTWARE OR ITS USE WILL NOT RESULT IN INJURY OR DAMAGE.
+ * THE USER ASSUMES RESPONSIBILITY FOR ALL LIABILITIES, PENALTIES, FINES, CLAIMS, CAUSES OF ACTION, AND COSTS AND EXPENSES, CAUSED BY, RESULTING FROM OR ARISING OUT OF,
+ * IN WHOLE OR IN PART THE USE, STORAGE OR DISPOSAL OF THE SOFTWARE.
+ */
+
+#ifndef __TASMANIAN_IOHELPERS_CPP
+#define __TASMANIAN_IOHELPERS_CPP
+
+#include "tsgIOHelpers.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <clocale>
+#include <limits>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define Tasmanian_IO_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace TasGrid{
+
+namespace IO{
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Floating point number with 64-bit significand and binary exponent, i.e., f 2^e, used by the Grisu2 algorithm.
+ * \endinternal
+ */
+struct DiyFp{
+    unsigned long long f;
+    int e;
+    DiyFp(unsigned long long significand, int exponent) : f(significand), e(exponent){}
+    //! \brief Split the double into significand and exponent, the double must be finite and positive.
+    DiyFp(double x){
+        unsigned long long bits;
+        std::memcpy(&bits, &x, sizeof(double));
+        int biased = (int) ((bits >> 52) & 0x7FFULL);
+        f = bits & 0xFFFFFFFFFFFFFULL;
+        if (biased != 0){
+            f += 0x10000000000000ULL;
+            e = biased - 1075;
+        }else{
+            e = -1074;
+        }
+    }
+    //! \brief Returns the product rounded to 64-bits.
+    DiyFp operator *(DiyFp const &other) const{
+        unsigned long long a = f >> 32, b = f & 0xFFFFFFFFULL, c = other.f >> 32, d = other.f & 0xFFFFFFFFULL;
+        unsigned long long ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+        unsigned long long mid = (bd >> 32) + (ad & 0xFFFFFFFFULL) + (bc & 0xFFFFFFFFULL) + (1ULL << 31);
+        return DiyFp(ac + (ad >> 32) + (bc >> 32) + (mid >> 32), e + other.e + 64);
+    }
+    //! \brief Shift the significand so that the leading bit is set.
+    DiyFp normalize() const{
+        DiyFp r = *this;
+        while((r.f & (1ULL << 63)) == 0){ r.f <<= 1; r.e--; }
+        return r;
+    }
+};
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Returns the normalized approximations of the powers 10^k for k = -348, -340, ..., 340.
+ *
+ * The values are computed once with exact big-integer arithmetic and rounded to 64-bits.
+ * \endinternal
+ */
+std::vector<DiyFp> const& getCachedPowers(){
+    static std::vector<DiyFp> const powers = []()->std::vector<DiyFp>{
+        // big integers are stored in 32-bit words, least significant first
+        using BigInt = std::vector<unsigned int>;
+        auto mult10 = [](BigInt &x, int times)->void{
+            for(int t=0; t<times; t++){
+                unsigned long long carry = 0;
+                for(auto &w : x){
+                    carry += 10ULL * w;
+                    w = (unsigned int) carry;
+                    carry >>= 32;
+                }
+                if (carry > 0) x.push_back((unsigned int) carry);
+            }
+        };
+        auto num_bits = [](BigInt const &x)->int{
+            int n = 32 * (int) (x.size() - 1);
+            for(unsigned int w = x.back(); w > 0; w >>= 1) n++;
+            return n;
+        };
+        auto bit = [](BigInt const &x, int i)->unsigned long long{
+            return (i < 0 || i >= 32 * (int) x.size()) ? 0 : ((x[i / 32] >> (i % 32)) & 1U);
+        };
+        auto not_less = [](BigInt const &x, BigInt const &y)->bool{ // x >= y, y has no leading zero words
+            for(size_t i = std::max(x.size(), y.size()); i-- > 0;){
+                unsigned int a = (i < x.size()) ? x[i] : 0, b = (i < y.size()) ? y[i] : 0;
+                if (a != b) return (a > b);
+            }
+            return true;
+        };
+        auto subtract = [](BigInt &x, BigInt const &y)->void{
+            long long borrow = 0;
+            for(size_t i=0; i<x.size(); i++){
+                long long r = (long long) x[i] - borrow - (long long) ((i < y.size()) ? y[i] : 0);
+                borrow = (r < 0) ? 1 : 0;
+                x[i] = (unsigned int) (r + (borrow << 32));
+            }
+        };
+
+        std::vector<DiyFp> result;
+        for(int k = -348; k <= 340; k += 8){
+            BigInt p = {1};
+            mult10(p, std::abs(k));
+            int n = num_bits(p);
+            if (k >= 0){ // take the leading 64 bits of 10^k and round
+                unsigned long long f = 0;
+                for(int i = n - 1; i >= n - 64; i--) f = (f << 1) | bit(p, i);
+                int e = n - 64;
+                if (bit(p, n - 65) == 1){
+                    if (++f == 0){ f = 1ULL << 63; e++; }
+                }
+                result.push_back(DiyFp(f, e));
+            }else{ // long division 2^(n + 63) / 10^|k|, the quotient is in (2^63, 2^64)
+                BigInt r = {0};
+                unsigned long long f = 0;
+                for(int i = n + 63; i >= 0; i--){
+                    unsigned int carry = (i == n + 63) ? 1 : 0;
+                    for(auto &w : r){ // r = 2 r + carry
+                        unsigned int next = w >> 31;
+                        w = (w << 1) | carry;
+                        carry = next;
+                    }
+                    if (carry > 0) r.push_back(carry);
+                    f <<= 1;
+                    if (not_less(r, p)){
+                        subtract(r, p);
+                        f |= 1;
+                    }
+                }
+                int e = -(n + 63);
+                BigInt twice = r;
+                unsigned int carry = 0;
+                for(auto &w : twice){
+                    unsigned int next = w >> 31;
+                    w = (w << 1) | carry;
+                    carry = next;
+                }
+                if (carry > 0) twice.push_back(carry);
+                if (not_less(twice, p)){
+                    if (++f == 0){ f = 1ULL << 63; e++; }
+                }
+                result.push_back(DiyFp(f, e));
+            }
+        }
+        return result;
+    }();
+    return powers;
+}
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Move the last digit closer to the exact value while staying within the rounding interval.
+ * \endinternal
+ */
+inline void grisuRound(char digits[], int num_digits, unsigned long long delta, unsigned long long rest,
+                       unsigned long long ten_kappa, unsigned long long distance){
+    while(rest < distance && delta - rest >= ten_kappa &&
+          (rest + ten_kappa < distance || distance - rest > rest + ten_kappa - distance)){
+        digits[num_digits - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Generates the digits of a positive finite double, the value is digits times 10^exponent.
+ *
+ * Grisu2 finds the shortest digits for the vast majority of inputs, but near the boundaries of the rounding interval
+ * the result can have one extra digit, e.g., 1.E+23 gives 9999999999999999 times 10^7, the value still reads back exactly.
+ * \endinternal
+ */
+int grisuDigits(double x, char digits[], int &exponent){
+    static const unsigned int pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+    DiyFp v(x);
+
+    // boundaries of the rounding interval, both are scaled to the same exponent
+    DiyFp upper = DiyFp((v.f << 1) + 1, v.e - 1).normalize();
+    DiyFp lower = (v.f == 0x10000000000000ULL) ? DiyFp((v.f << 2) - 1, v.e - 2) : DiyFp((v.f << 1) - 1, v.e - 1);
+    lower.f <<= lower.e - upper.e;
+    lower.e = upper.e;
+
+    // find the cached power that puts the exponent of the product in [-60, -32]
+    double dk = (-61 - upper.e) * 0.30102999566398114 + 347;
+    int k = (int) dk;
+    if (dk - k > 0.0) k++;
+    size_t index = (size_t) ((k >> 3) + 1);
+    exponent = -(-348 + (int) (index << 3));
+    DiyFp const &c = getCachedPowers()[index];
+
+    DiyFp w = v.normalize() * c;
+    DiyFp wp = upper * c;
+    DiyFp wm = lower * c;
+    wm.f++;
+    wp.f--;
+    unsigned long long delta = wp.f - wm.f;
+    unsigned long long distance = wp.f - w.f;
+
+    DiyFp one(1ULL << (-wp.e), wp.e);
+    unsigned int p1 = (unsigned int) (wp.f >> (-one.e));
+    unsigned long long p2 = wp.f & (one.f - 1);
+    int kappa = 1;
+    while(kappa < 10 && p1 >= pow10[kappa]) kappa++;
+
+    int num_digits = 0;
+    while(kappa > 0){
+        unsigned int d = p1 / pow10[kappa - 1];
+        p1 %= pow10[kappa - 1];
+        if (d != 0 || num_digits != 0) digits[num_digits++] = (char) ('0' + d);
+        kappa--;
+        unsigned long long rest = (((unsigned long long) p1) << (-one.e)) + p2;
+        if (rest <= delta){
+            exponent += kappa;
+            grisuRound(digits, num_digits, delta, rest, ((unsigned long long) pow10[kappa]) << (-one.e), distance);
+            return num_digits;
+        }
+    }
+    for(;;){
+        p2 *= 10;
+        delta *= 10;
+        char d = (char) (p2 >> (-one.e));
+        if (d != 0 || num_digits != 0) digits[num_digits++] = (char) ('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta){
+            exponent += kappa;
+            grisuRound(digits, num_digits, delta, p2, one.f, (-kappa < 10) ? distance * pow10[-kappa] : 0);
+            return num_digits;
+        }
+    }
+}
+
+size_t formatShortest(double x, char buffer[]){
+    if (x != x){
+        std::strcpy(buffer, "nan");
+        return 3;
+    }
+    size_t n = 0;
+    if (std::signbit(x)){
+        buffer[n++] = '-';
+        x = -x;
+    }
+    if (x == 0.0){
+        buffer[n++] = '0';
+        buffer[n] = '\0';
+        return n;
+    }
+    if (x > std::numeric_limits<double>::max()){
+        std::strcpy(buffer + n, "inf");
+        return n + 3;
+    }
+
+    char digits[20];
+    int exponent;
+    int num_digits = grisuDigits(x, digits, exponent);
+    int lead = num_digits + exponent - 1; // exponent of the leading digit
+
+    if (lead >= -5 && lead < 17){ // fixed notation
+        if (exponent >= 0){
+            for(int i=0; i<num_digits; i++) buffer[n++] = digits[i];
+            for(int i=0; i<exponent; i++) buffer[n++] = '0';
+        }else if (lead >= 0){
+            for(int i=0; i<=lead; i++) buffer[n++] = digits[i];
+            buffer[n++] = '.';
+            for(int i=lead+1; i<num_digits; i++) buffer[n++] = digits[i];
+        }else{
+            buffer[n++] = '0';
+            buffer[n++] = '.';
+            for(int i=-1; i>lead; i--) buffer[n++] = '0';
+            for(int i=0; i<num_digits; i++) buffer[n++] = digits[i];
+        }
+    }else{ // scientific notation
+        buffer[n++] = digits[0];
+        if (num_digits > 1){
+            buffer[n++] = '.';
+            for(int i=1; i<num_digits; i++) buffer[n++] = digits[i];
+        }
+        buffer[n++] = 'e';
+        buffer[n++] = (lead < 0) ? '-' : '+';
+        int e = std::abs(lead);
+        if (e >= 100) buffer[n++] = (char) ('0' + e / 100);
+        buffer[n++] = (char) ('0' + (e / 10) % 10);
+        buffer[n++] = (char) ('0' + e % 10);
+    }
+    buffer[n] = '\0';
+    return n;
+}
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Read white-space separated tokens from the stream buffer and convert them with \b parse.
+ *
+ * Tokens of any length are accepted, a token that \b parse cannot convert in full sets the failbit of the stream.
+ * \endinternal
+ */
+template<typename T, class Parser>
+void readAsciiTokens(std::istream &is, size_t num_entries, T x[], Parser parse){
+    if (!is) return;
+    std::streambuf *sb = is.rdbuf();
+    constexpr int eof = std::char_traits<char>::eof();
+    std::string token; // grows to fit the longest token, e.g., numbers with many leading zeros
+    for(size_t i=0; i<num_entries; i++){
+        int c = sb->sgetc();
+        while(c != eof && std::isspace(c)) c = sb->snextc();
+        token.clear();
+        while(c != eof && !std::isspace(c)){
+            token.push_back((char) c);
+            c = sb->snextc();
+        }
+        size_t len = token.size();
+        char *end = nullptr;
+        if (len > 0) x[i] = parse(token.c_str(), &end);
+        if (len == 0 || end != token.c_str() + len){
+            is.setstate((c == eof) ? (std::ios::failbit | std::ios::eofbit) : std::ios::failbit);
+            return;
+        }
+        if (c == eof) is.setstate(std::ios::eofbit);
+    }
+}
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Converts tokens with \b std::strtod() using the '.' decimal point regardless of the \b LC_NUMERIC locale of the process.
+ *
+ * The locale is checked once on construction, hence the object must be created outside of parallel regions.
+ * If the decimal point of the locale is a different character, the token is copied and the points are swapped,
+ * the locale decimal point in the token ends the number same as in the "C" locale.
+ * Locales with multi-byte decimal point use a stream with the classic locale.
+ * \endinternal
+ */
+class ClassicDoubleParser{
+public:
+    ClassicDoubleParser(){
+        char const *decimal_point = std::localeconv()->decimal_point;
+        point = (std::strlen(decimal_point) == 1) ? decimal_point[0] : '\0';
+    }
+    double operator()(char const *token, char **end) const{
+        if (point == '.') return std::strtod(token, end);
+        char const *start = token;
+        while(std::isspace((unsigned char) *start)) start++;
+        size_t len = 0;
+        while(start[len] != '\0' && !std::isspace((unsigned char) start[len])) len++;
+        double value = 0.0;
+        size_t used = 0;
+        if (point != '\0' && len < 128){
+            char buffer[128];
+            for(size_t i=0; i<len; i++)
+                buffer[i] = (start[i] == '.') ? point : ((start[i] == point) ? '\0' : start[i]);
+            buffer[len] = '\0';
+            char *buffer_end = nullptr;
+            value = std::strtod(buffer, &buffer_end);
+            used = (size_t) (buffer_end - buffer);
+        }else{
+            std::istringstream iss(std::string(start, len));
+            iss.imbue(std::locale::classic());
+            iss >> value;
+            used = (iss.fail()) ? 0 : ((iss.eof()) ? len : (size_t) iss.tellg());
+        }
+        *end = const_cast<char*>((used == 0) ? token : start + used);
+        return value;
+    }
+private:
+    char point;
+};
+
+void readAsciiArray(std::istream &is, size_t num_entries, double x[]){
+    readAsciiTokens(is, num_entries, x, ClassicDoubleParser());
+}
+void readAsciiArray(std::istream &is, size_t num_entries, int x[]){
+    readAsciiTokens(is, num_entries, x, [](char const *token, char **end)->int{ return (int) std::strtol(token, end, 10); });
+}
+
+size_t parseAsciiArray(char const *text, size_t num_entries, double x[]){
+    constexpr size_t piece_size = 1048576; // bytes of text per thread task
+    size_t text_size = std::strlen(text);
+
+    // split the text at white-space so that no token crosses between pieces
+    std::vector<char const*> pieces = {text};
+    while(pieces.back() + piece_size < text + text_size){
+        char const *next = pieces.back() + piece_size;
+        while(*next != '\0' && !std::isspace((unsigned char) *next)) next++;
+        pieces.push_back(next);
+    }
+    pieces.push_back(text + text_size);
+    size_t num_pieces = pieces.size() - 1;
+
+    std::vector<size_t> offsets(num_pieces + 1, 0);
+    #pragma omp parallel for schedule(dynamic)
+    for(int p=0; p<(int) num_pieces; p++){
+        size_t count = 0;
+        bool in_token = false;
+        for(char const *c = pieces[p]; c < pieces[p+1]; c++){
+            bool space = (std::isspace((unsigned char) *c) != 0);
+            if (!space && !in_token) count++;
+            in_token = !space;
+        }
+        offsets[p+1] = count;
+    }
+    for(size_t p=0; p<num_pieces; p++) offsets[p+1] += offsets[p];
+
+    ClassicDoubleParser parse;
+    std::vector<size_t> parsed(num_pieces, 0);
+    #pragma omp parallel for schedule(dynamic)
+    for(int p=0; p<(int) num_pieces; p++){
+        char const *c = pieces[p];
+        size_t ibegin = std::min(offsets[p], num_entries), iend = std::min(offsets[p+1], num_entries);
+        size_t i = ibegin;
+        while(i < iend){
+            char *end = nullptr;
+            x[i] = parse(c, &end);
+            if (end == c || (*end != '\0' && !std::isspace((unsigned char) *end))) break;
+            c = end;
+            i++;
+        }
+        parsed[p] = i - ibegin;
+    }
+    // the entries are valid up to the first piece that did not parse completely
+    size_t total = 0;
+    for(size_t p=0; p<num_pieces && offsets[p] < num_entries; p++){
+        total += parsed[p];
+        if (offsets[p] + parsed[p] < std::min(offsets[p+1], num_entries)) break;
+    }
+    return total;
+}
+
+void writeAsciiMatrix(std::ostream &os, size_t num_rows, size_t num_cols, double const x[], int width){
+    constexpr size_t block_entries = 65536; // entries formatted by one thread task
+    size_t rows_per_block = std::max(size_t(1), block_entries / std::max(size_t(1), num_cols));
+    size_t num_blocks = (num_rows + rows_per_block - 1) / rows_per_block;
+    size_t blocks_per_batch = 64; // bounds the memory used by the formatted text
+    std::vector<std::string> text(blocks_per_batch);
+
+    for(size_t batch=0; batch<num_blocks; batch += blocks_per_batch){
+        size_t batch_end = std::min(batch + blocks_per_batch, num_blocks);
+        #pragma omp parallel for schedule(dynamic)
+        for(int b=(int) batch; b<(int) batch_end; b++){
+            std::string &t = text[b - batch];
+            t.clear();
+            char buffer[ascii_number_buffer];
+            size_t row_end = std::min((b + 1) * rows_per_block, num_rows);
+            for(size_t i=b * rows_per_block; i<row_end; i++){
+                double const *r = &x[i * num_cols];
+                for(size_t j=0; j<num_cols; j++){
+                    if (j > 0) t.push_back(' ');
+                    size_t len = formatShortest(r[j], buffer);
+                    if (len < (size_t) std::max(width, 0)) t.append((size_t) width - len, ' ');
+                    t.append(buffer, len);
+                }
+                t.push_back('\n');
+            }
+        }
+        for(size_t b=batch; b<batch_end; b++) os.write(text[b - batch].data(), (std::streamsize) text[b - batch].size());
+    }
+}
+
+MappedFile::MappedFile(const char *filename) : file_data(nullptr), file_size(0){
+    #ifdef Tasmanian_IO_USE_MMAP
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) throw std::runtime_error(std::string("ERROR: cannot open file ") + filename);
+    struct stat info;
+    if (fstat(fd, &info) != 0){
+        close(fd);
+        throw std::runtime_error(std::string("ERROR: cannot read the size of file ") + filename);
+    }
+    file_size = (size_t) info.st_size;
+    if (file_size > 0){
+        void *addr = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd); // the mapping remains valid after the file is closed
+        if (addr == MAP_FAILED) throw std::runtime_error(std::string("ERROR: cannot map file ") + filename);
+        file_data = (char const*) addr;
+    }else{
+        close(fd);
+    }
+    #else
+    std::ifstream ifs(filename, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs) throw std::runtime_error(std::string("ERROR: cannot open file ") + filename);
+    file_size = (size_t) ifs.tellg();
+    buffer.resize(file_size / sizeof(double) + 1); // use doubles to guarantee the alignment
+    ifs.seekg(0);
+    ifs.read((char*) buffer.data(), file_size);
+    file_data = (char const*) buffer.data();
+    #endif
+}
+
+MappedFile::~MappedFile(){
+    #ifdef Tasmanian_IO_USE_MMAP
+    if (file_data != nullptr) munmap(const_cast<char*>(file_data), file_size);
+    #endif
+}
+
+unsigned long long computeChecksum(char const *data, size_t num_bytes){
+    // Fletcher-64 over 32-bit words, the sums are reduced before they can overflow
+    unsigned long long a = 0, b = 0;
+    size_t num_words = num_bytes / sizeof(unsigned int);
+    size_t block = 92680; // largest block for which b cannot overflow 64-bits
+    unsigned int word;
+    for(size_t i=0; i<num_words; i += block){
+        size_t iend = std::min(i + block, num_words);
+        for(size_t j=i; j<iend; j++){
+            std::memcpy(&word, data + j * sizeof(unsigned int), sizeof(unsigned int));
+            a += word;
+            b += a;
+        }
+        a %= 4294967295ULL;
+        b %= 4294967295ULL;
+    }
+    size_t num_tail = num_bytes - num_words * sizeof(unsigned int);
+    if (num_tail > 0){
+        word = 0;
+        std::memcpy(&word, data + num_words * sizeof(unsigned int), num_tail);
+        a = (a + word) % 4294967295ULL;
+        b = (b + a) % 4294967295ULL;
+    }
+    return (b << 32) | a;
+}
+
+void writeChunkedFile(const char *filename, std::string const &metadata, ChunkedWriter const &writer){
+    constexpr size_t page = 4096;
+    size_t num_arrays = writer.arrays.size();
+    // the last two entries are the checksum of the offset and chunk tables and the checksum of the header, set after the chunks are written
+    std::vector<unsigned long long> header = {chunked_chunk_bytes, num_arrays, metadata.size(), computeChecksum(metadata.data(), metadata.size()), 0, 0};
+
+    // list the chunks of all arrays, the first array is aligned after the header, tables and metadata
+    std::vector<std::pair<size_t, size_t>> chunks; // array and first byte within the array
+    for(size_t i=0; i<num_arrays; i++)
+        for(size_t c=0; c<writer.arrays[i].second; c += chunked_chunk_bytes) chunks.push_back({i, c});
+    // the tables hold the offset and size of each array followed by the checksums of all chunks
+    std::vector<unsigned long long> tables(2 * num_arrays + chunks.size());
+    size_t offset = 4 + sizeof(unsigned long long) * (header.size() + tables.size()) + metadata.size();
+    for(size_t i=0; i<num_arrays; i++){
+        offset = ((offset + page - 1) / page) * page;
+        tables[2*i] = offset;
+        tables[2*i+1] = writer.arrays[i].second;
+        offset += writer.arrays[i].second;
+    }
+    unsigned long long *checksums = tables.data() + 2 * num_arrays;
+
+    std::ofstream ofs(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs) throw std::runtime_error(std::string("ERROR: cannot open file ") + filename);
+    ofs.write("TSG7", 4);
+    ofs.write((char const*) header.data(), header.size() * sizeof(unsigned long long)); // place holder, written below
+    ofs.write((char const*) tables.data(), tables.size() * sizeof(unsigned long long));
+    ofs.write(metadata.data(), metadata.size());
+    ofs.close();
+
+    std::vector<int> failed(chunks.size(), 0);
+    #pragma omp parallel
+    {
+        std::fstream fs(filename, std::ios::in | std::ios::out | std::ios::binary); // each thread uses a separate stream
+        #pragma omp for schedule(dynamic)
+        for(int i=0; i<(int) chunks.size(); i++){
+            size_t a = chunks[i].first, c = chunks[i].second;
+            size_t num_bytes = std::min(chunked_chunk_bytes, writer.arrays[a].second - c);
+            checksums[i] = computeChecksum(writer.arrays[a].first + c, num_bytes);
+            fs.seekp((std::streamoff) (tables[2*a] + c));
+            fs.write(writer.arrays[a].first + c, num_bytes);
+            if (!fs) failed[i] = 1;
+        }
+    }
+    if (std::any_of(failed.begin(), failed.end(), [](int f)->bool{ return (f != 0); }))
+        throw std::runtime_error(std::string("ERROR: failed to write file ") + filename);
+
+    header[4] = computeChecksum((char const*) tables.data(), tables.size() * sizeof(unsigned long long));
+    header[5] = computeChecksum((char const*) header.data(), 5 * sizeof(unsigned long long));
+    std::fstream fs(filename, std::ios::in | std::ios::out | std::ios::binary);
+    fs.seekp(4);
+    fs.write((char const*) header.data(), header.size() * sizeof(unsigned long long));
+    fs.write((char const*) tables.data(), tables.size() * sizeof(unsigned long long));
+    if (!fs) throw std::runtime_error(std::string("ERROR: failed to write file ") + filename);
+}
+
+std::string readChunkedFile(const char *filename, ChunkedReader &reader){
+    std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+    if (!ifs) throw std::runtime_error(std::string("ERROR: cannot open file ") + filename);
+    char TSG[4];
+    ifs.read(TSG, 4);
+    if (!ifs || (TSG[0] != 'T') || (TSG[1] != 'S') || (TSG[2] != 'G') || (TSG[3] != '7'))
+        throw std::runtime_error("ERROR: wrong binary file format, the file is not in the chunked format");
+
+    std::vector<unsigned long long> header(6);
+    ifs.read((char*) header.data(), header.size() * sizeof(unsigned long long));
+    if (!ifs) throw std::runtime_error("ERROR: wrong binary file format, the chunked file is truncated");
+    if (computeChecksum((char const*) header.data(), 5 * sizeof(unsigned long long)) != header[5])
+        throw std::runtime_error("ERROR: wrong binary file format, checksum mismatch in the header of the chunked file");
+    size_t chunk_bytes = (size_t) header[0], num_arrays = (size_t) header[1];
+    if (chunk_bytes == 0) throw std::runtime_error("ERROR: wrong binary file format, incorrect chunked header");
+
+    std::vector<unsigned long long> tables(2 * num_arrays); // offset and size of each array, then the checksums of the chunks
+    ifs.read((char*) tables.data(), tables.size() * sizeof(unsigned long long));
+    if (!ifs) throw std::runtime_error("ERROR: wrong binary file format, the chunked file is truncated");
+    ifs.seekg(0, std::ios::end);
+    unsigned long long file_size = (unsigned long long) ifs.tellg();
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for(size_t i=0; i<num_arrays; i++){
+        if ((tables[2*i] > file_size) || (tables[2*i+1] > file_size - tables[2*i])) // check before the tables are verified, avoids huge allocations
+            throw std::runtime_error("ERROR: wrong binary file format, the chunked file is truncated");
+        for(size_t c=0; c<tables[2*i+1]; c += chunk_bytes) chunks.push_back({i, c});
+    }
+    tables.resize(2 * num_arrays + chunks.size());
+    ifs.seekg((std::streamoff) (4 + sizeof(unsigned long long) * (header.size() + 2 * num_arrays)));
+    ifs.read((char*) (tables.data() + 2 * num_arrays), chunks.size() * sizeof(unsigned long long));
+    std::string metadata((size_t) header[2], ' ');
+    ifs.read(&(metadata[0]), metadata.size());
+    if (!ifs) throw std::runtime_error("ERROR: wrong binary file format, the chunked file is truncated");
+    ifs.close();
+    if (computeChecksum((char const*) tables.data(), tables.size() * sizeof(unsigned long long)) != header[4])
+        throw std::runtime_error("ERROR: wrong binary file format, checksum mismatch in the tables of the chunked file");
+    unsigned long long const *offsets = tables.data();
+    unsigned long long const *checksums = tables.data() + 2 * num_arrays;
+    if (computeChecksum(metadata.data(), metadata.size()) != header[3])
+        throw std::runtime_error("ERROR: wrong binary file format, checksum mismatch in the metadata of the chunked file");
+
+    reader.arrays.resize(num_arrays);
+    reader.num_bytes.resize(num_arrays);
+    for(size_t i=0; i<num_arrays; i++){
+        reader.num_bytes[i] = (size_t) offsets[2*i+1];
+        reader.arrays[i] = std::make_shared<std::vector<double>>((reader.num_bytes[i] + sizeof(double) - 1) / sizeof(double));
+    }
+
+    std::vector<int> failed(chunks.size(), 0);
+    #pragma omp parallel
+    {
+        std::ifstream fs(filename, std::ios::in | std::ios::binary); // each thread uses a separate stream
+        #pragma omp for schedule(dynamic)
+        for(int i=0; i<(int) chunks.size(); i++){
+            size_t a = chunks[i].first, c = chunks[i].second;
+            size_t num_bytes = std::min(chunk_bytes, reader.num_bytes[a] - c);
+            char *data = ((char*) reader.arrays[a]->data()) + c;
+            fs.seekg((std::streamoff) (offsets[2*a] + c));
+            fs.read(data, num_bytes);
+            if (!fs){
+                failed[i] = 1;
+                fs.clear();
+            }else if (computeChecksum(data, num_bytes) != checksums[i]){
+                failed[i] = 2;
+            }
+        }
+    }
+    for(size_t i=0; i<chunks.size(); i++){
+        if (failed[i] == 1) throw std::runtime_error("ERROR: wrong binary file format, the chunked file is truncated");
+        if (failed[i] == 2) throw std::runtime_error("ERROR: wrong binary file format, checksum mismatch in chunk " + std::to_string(i) + " of the chunked file");
+    }
+    return metadata;
+}
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Run-length encoding, a control byte below 128 is followed by that many plus one literal bytes, otherwise the next byte is repeated (control - 125) times.
+ * \endinternal
+ */
+std::vector<unsigned char> encodeRuns(std::vector<unsigned char> const &raw){
+    std::vector<unsigned char> packed;
+    packed.reserve(raw.size() / 4 + 16);
+    size_t n = raw.size(), i = 0;
+    auto run_length = [&](size_t j)->size_t{
+        size_t r = 1;
+        while(j + r < n && r < 130 && raw[j + r] == raw[j]) r++;
+        return r;
+    };
+    while(i < n){
+        size_t r = run_length(i);
+        if (r >= 3){
+            packed.push_back((unsigned char) (125 + r));
+            packed.push_back(raw[i]);
+            i += r;
+        }else{
+            size_t start = i;
+            while(i < n && i - start < 128 && (i + 2 >= n || raw[i] != raw[i+1] || raw[i] != raw[i+2])) i++;
+            packed.push_back((unsigned char) (i - start - 1));
+            packed.insert(packed.end(), raw.begin() + start, raw.begin() + i);
+        }
+    }
+    return packed;
+}
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Inverse of \b encodeRuns(), the size of the decoded data must match \b raw_size.
+ * \endinternal
+ */
+std::vector<unsigned char> decodeRuns(std::vector<unsigned char> const &packed, size_t raw_size){
+    std::vector<unsigned char> raw;
+    raw.reserve(raw_size);
+    size_t i = 0;
+    while(i < packed.size()){
+        unsigned char control = packed[i++];
+        if (control < 128){
+            size_t len = (size_t) control + 1;
+            if (i + len > packed.size() || raw.size() + len > raw_size) break;
+            raw.insert(raw.end(), packed.begin() + i, packed.begin() + i + len);
+            i += len;
+        }else{
+            size_t len = (size_t) control - 125;
+            if (i >= packed.size() || raw.size() + len > raw_size) break;
+            raw.insert(raw.end(), len, packed[i++]);
+        }
+    }
+    if (i != packed.size() || raw.size() != raw_size)
+        throw std::runtime_error("ERROR: wrong binary file format, corrupted compressed block");
+    return raw;
+}
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Returns the bytes of the values grouped by significance, used by the lossless mode of the compressed block.
+ * \endinternal
+ */
+std::vector<unsigned char> shuffleBytes(double const x[], size_t num_entries){
+    std::vector<unsigned char> raw(num_entries * sizeof(double));
+    for(size_t i=0; i<num_entries; i++){
+        unsigned char bytes[sizeof(double)];
+        std::memcpy(bytes, &x[i], sizeof(double));
+        for(size_t b=0; b<sizeof(double); b++) raw[b * num_entries + i] = bytes[b];
+    }
+    return raw;
+}
+
+void writeCompressedBlock(double const x[], size_t num_entries, double tolerance, std::ostream &os){
+    // the multiples must be exact in double precision, i.e., at most 2^52, and the rounding in step * q must stay within the tolerance
+    double step = tolerance;
+    bool quantize = (tolerance > 0.0);
+    for(size_t i=0; i<num_entries && quantize; i++)
+        quantize = std::isfinite(x[i]) && (std::abs(x[i]) / step < 4503599627370496.0);
+
+    std::vector<unsigned char> raw;
+    if (quantize){
+        raw.reserve(num_entries);
+        for(size_t i=0; i<num_entries && quantize; i++){
+            long long q = std::llround(x[i] / step);
+            quantize = (std::abs(x[i] - step * (double) q) <= tolerance); // same expression as the reader, the bound is guaranteed
+            unsigned long long z = (((unsigned long long) q) << 1) ^ ((q < 0) ? ~0ULL : 0ULL); // zig-zag, small magnitude means few bytes
+            while(z >= 128){
+                raw.push_back((unsigned char) (z | 128));
+                z >>= 7;
+            }
+            raw.push_back((unsigned char) z);
+        }
+    }
+    std::vector<unsigned char> packed;
+    if (quantize){
+        packed = encodeRuns(raw);
+        std::vector<unsigned char> lossless = encodeRuns(shuffleBytes(x, num_entries));
+        if (lossless.size() <= packed.size() + sizeof(double)){ // quantization does not pay off
+            quantize = false;
+            raw.resize(num_entries * sizeof(double));
+            packed = std::move(lossless);
+        }
+    }else{
+        raw = shuffleBytes(x, num_entries);
+        packed = encodeRuns(raw);
+    }
+
+    char mode = (quantize) ? 'q' : 's';
+    os.write(&mode, sizeof(char));
+    if (quantize) os.write((char const*) &step, sizeof(double));
+    unsigned long long sizes[2] = {raw.size(), packed.size()};
+    os.write((char const*) sizes, 2 * sizeof(unsigned long long));
+    os.write((char const*) packed.data(), (std::streamsize) packed.size());
+}
+
+size_t getRemainingBytes(std::istream &is){
+    std::streampos current = is.tellg();
+    if (!is || current < 0) return std::numeric_limits<size_t>::max();
+    is.seekg(0, std::ios::end);
+    std::streampos last = is.tellg();
+    is.seekg(current);
+    if (!is || last < current) return std::numeric_limits<size_t>::max();
+    return (size_t) (last - current);
+}
+
+void readCompressedBlock(std::istream &is, size_t num_entries, double x[]){
+    char mode = 'n';
+    double step = 0.0;
+    unsigned long long sizes[2] = {0, 0};
+    is.read(&mode, sizeof(char));
+    if (mode == 'q') is.read((char*) &step, sizeof(double));
+    is.read((char*) sizes, 2 * sizeof(unsigned long long));
+    if (!is || (mode != 'q' && mode != 's') || (mode == 's' && sizes[0] != num_entries * sizeof(double)))
+        throw std::runtime_error("ERROR: wrong binary file format, incorrect compressed block");
+    // the quantized entries use between 1 and 10 bytes, the run-length encoding adds at most one byte for every 128 bytes of data
+    // and each pair of bytes expands into at most 130 bytes, all sizes are checked before allocating memory
+    if ((mode == 'q' && (sizes[0] < num_entries || sizes[0] / 10 > num_entries))
+        || (sizes[1] > sizes[0] + sizes[0] / 128 + 1) || (sizes[0] / 65 > sizes[1])
+        || (sizes[1] > (unsigned long long) getRemainingBytes(is)))
+        throw std::runtime_error("ERROR: wrong binary file format, incorrect size of the compressed block");
+    std::vector<unsigned char> packed((size_t) sizes[1]);
+    is.read((char*) packed.data(), (std::streamsize) packed.size());
+    if (!is) throw std::runtime_error("ERROR: wrong binary file format, the compressed block is truncated");
+    std::vector<unsigned char> raw = decodeRuns(packed, (size_t) sizes[0]);
+
+    if (mode == 'q'){
+        size_t k = 0;
+        for(size_t i=0; i<num_entries; i++){
+            unsigned long long z = 0;
+            int shift = 0;
+            do{
+                if (k >= raw.size() || shift > 63) throw std::runtime_error("ERROR: wrong binary file format, corrupted compressed block");
+                z |= ((unsigned long long) (raw[k] & 127)) << shift;
+                shift += 7;
+            }while(raw[k++] >= 128);
+            long long q = (long long) (z >> 1) ^ -((long long) (z & 1));
+            x[i] = step * (double) q;
+        }
+        if (k != raw.size()) throw std::runtime_error("ERROR: wrong binary file format, corrupted compressed block");
+    }else{
+        for(size_t i=0; i<num_entries; i++){
+            unsigned char bytes[sizeof(double)];
+            for(size_t b=0; b<sizeof(double); b++) bytes[b] = raw[b * num_entries + i];
+            std::memcpy(&x[i], bytes, sizeof(double));
+        }
+    }
+}
+
+}
+
+}
+
+#endif
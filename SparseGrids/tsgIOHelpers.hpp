@@ -303,25 +303,113 @@ bool readFlag(std::istream &os){
 
 /*!
  * \ingroup TasmanianIO
- * \brief Write the vector to the stream, the vector cannot be empty.
+ * \brief Size of the buffer used by \b formatShortest(), includes the terminating null character.
+ */
+constexpr size_t ascii_number_buffer = 32;
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Write a short decimal string that reads back to the same double, returns the number of characters.
+ *
+ * The digits are generated with the Grisu2 algorithm that uses only 64-bit integer arithmetic,
+ * the result is the shortest round-trip string except for rare values close to a power of 10,
+ * which get one extra digit, e.g., 1.E+23 is written as 9.999999999999999e+22.
+ * Moderate exponents use fixed notation and the rest use scientific notation, e.g., 0.1, 25 and 1.5e+300.
+ * The \b buffer must hold at least \b ascii_number_buffer characters.
+ */
+size_t formatShortest(double x, char buffer[]);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Write a single number in ascii format, doubles use \b formatShortest() and the rest use the stream operator.
+ */
+template<typename VecType>
+void writeAsciiNumber(std::ostream &os, VecType const &x){ os << x; }
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Overload that writes the short round-trip representation of the double, see \b formatShortest().
+ */
+inline void writeAsciiNumber(std::ostream &os, double x){
+    char buffer[ascii_number_buffer];
+    os.write(buffer, (std::streamsize) formatShortest(x, buffer));
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Read \b num_entries white-space separated doubles, the tokens are taken directly from the stream buffer.
+ *
+ * Same as using the stream operator with the classic locale, but the number is parsed with \b std::strtod(),
+ * the decimal point is always '.' regardless of the locale set with \b setlocale().
+ * Sets the fail bit of the stream if a token cannot be parsed or the stream ends early.
+ */
+void readAsciiArray(std::istream &is, size_t num_entries, double x[]);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Overload that reads integers, see the overload for doubles.
+ */
+void readAsciiArray(std::istream &is, size_t num_entries, int x[]);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Read \b num_entries using the stream operator, used for types without a fast parser.
+ */
+template<typename VecType>
+void readAsciiArray(std::istream &is, size_t num_entries, VecType x[]){
+    for(size_t i=0; i<num_entries; i++) is >> x[i];
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Parse up to \b num_entries white-space separated doubles from the null-terminated \b text, returns the number of parsed entries.
+ *
+ * The text is split into pieces at white-space, each piece is processed by a separate thread,
+ * the threads first count the tokens and then parse into the correct offset in \b x.
+ * Extra tokens after \b num_entries are ignored, parsing stops at the first token that is not a number.
+ * The decimal point is always '.' regardless of the locale set with \b setlocale().
+ */
+size_t parseAsciiArray(char const *text, size_t num_entries, double x[]);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Write the row-major matrix to the stream, one row per line using \b formatShortest().
+ *
+ * The rows are formatted into text by multiple threads and the text is written in the original order.
+ * If \b width is positive, each entry is right aligned to \b width characters (same as \b std::setw()) so that the columns line up.
+ */
+void writeAsciiMatrix(std::ostream &os, size_t num_rows, size_t num_cols, double const x[], int width = 0);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Write the array with \b num_entries to the stream, the array cannot be empty.
  */
 template<bool useAscii, IOPad pad, typename VecType>
-void writeVector(const std::vector<VecType> &x, std::ostream &os){
+void writeArray(VecType const x[], size_t num_entries, std::ostream &os){
     if (useAscii){
         if (pad == pad_lspace)
-            for(auto i : x) os << " " << i;
+            for(size_t i = 0; i < num_entries; i++){ os << " "; writeAsciiNumber(os, x[i]); }
         if (pad == pad_rspace)
-            for(auto i : x) os << i << " ";
+            for(size_t i = 0; i < num_entries; i++){ writeAsciiNumber(os, x[i]); os << " "; }
         if ((pad == pad_none) || (pad == pad_line)){
-            os << x[0];
-            for(size_t i = 1; i < x.size(); i++) os << " " << x[i];
+            writeAsciiNumber(os, x[0]);
+            for(size_t i = 1; i < num_entries; i++){ os << " "; writeAsciiNumber(os, x[i]); }
             if (pad == pad_line) os << std::endl;
         }
     }else{
-        os.write((char*) x.data(), x.size() * sizeof(VecType));
+        os.write((char const*) x, num_entries * sizeof(VecType));
     }
 }
 
+/*!
+ * \ingroup TasmanianIO
+ * \brief Write the vector to the stream, the vector cannot be empty.
+ */
+template<bool useAscii, IOPad pad, typename VecType>
+void writeVector(const std::vector<VecType> &x, std::ostream &os){
+    writeArray<useAscii, pad>(x.data(), x.size(), os);
+}
+
 /*!
  * \ingroup TasmanianIO
  * \brief Read the vector from the stream.
@@ -329,7 +417,7 @@ void writeVector(const std::vector<VecType> &x, std::ostream &os){
 template<bool useAscii, typename VecType>
 void readVector(std::istream &os, std::vector<VecType> &x){
     if (useAscii){
-        for(auto &i : x) os >> i;
+        readAsciiArray(os, x.size(), x.data());
     }else{
         os.read((char*) x.data(), x.size() * sizeof(VecType));
     }
@@ -353,13 +441,388 @@ template<bool useAscii, typename Val>
 Val readNumber(std::istream &os){
     Val v;
     if (useAscii){
-        os >> v;
+        readAsciiArray(os, 1, &v);
     }else{
         os.read((char*) &v, sizeof(Val));
     }
     return v;
 }
 
+/*!
+ * \ingroup TasmanianIO
+ * \brief Alignment (in bytes) of the large arrays in the mapped binary format.
+ */
+constexpr size_t mapped_alignment = 64;
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns the index of the stream word that marks the mapped binary format, see \b std::ios_base::xalloc().
+ *
+ * The mapped format is the binary format with the large arrays aligned relative to the beginning of the stream,
+ * the arrays can be used directly from a memory mapped file, see \b writeMappableArray() and \b readMappableArray().
+ */
+inline int getMappedFormatIndex(){
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns \b true if the stream is set to use the mapped binary format.
+ */
+inline bool isMappedFormat(std::ios_base &s){ return (s.iword(getMappedFormatIndex()) != 0); }
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Set or unset the mapped binary format for the stream.
+ */
+inline void setMappedFormat(std::ios_base &s, bool mapped){ s.iword(getMappedFormatIndex()) = (mapped) ? 1 : 0; }
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Read-only memory mapping of a file, the pages are shared between all processes that map the same file.
+ *
+ * On systems without \b mmap(), the file is read into an aligned buffer.
+ * \endinternal
+ */
+class MappedFile{
+public:
+    //! \brief Map the file, throws \b std::runtime_error if the file cannot be opened.
+    MappedFile(const char *filename);
+    //! \brief Release the mapping.
+    ~MappedFile();
+    //! \brief The mapping cannot be copied.
+    MappedFile(MappedFile const &) = delete;
+    //! \brief The mapping cannot be copied.
+    MappedFile& operator=(MappedFile const &) = delete;
+
+    //! \brief Returns the beginning of the file data.
+    char const* data() const{ return file_data; }
+    //! \brief Returns the size of the file in bytes.
+    size_t size() const{ return file_size; }
+
+private:
+    char const *file_data;
+    size_t file_size;
+    std::vector<double> buffer; // used if mmap() is not available
+};
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Stream buffer that reads directly from a \b MappedFile, allows the arrays to be used without a copy.
+ * \endinternal
+ */
+class MappedBuffer : public std::streambuf{
+public:
+    //! \brief Constructor, sets the buffer to the entire file.
+    MappedBuffer(std::shared_ptr<MappedFile const> const &mapped_file) : file(mapped_file){
+        char *begin = const_cast<char*>(file->data()); // the data is never written, std::streambuf uses char* for all buffers
+        setg(begin, begin, begin + file->size());
+    }
+    //! \brief Returns the mapped file.
+    std::shared_ptr<MappedFile const> const& getFile() const{ return file; }
+    //! \brief Returns the current read location.
+    char const* getCurrent() const{ return gptr(); }
+    //! \brief Returns the number of bytes left in the buffer.
+    size_t getRemaining() const{ return (size_t) (egptr() - gptr()); }
+
+protected:
+    //! \brief Move the read location, used by \b std::istream::seekg() and \b std::istream::tellg().
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in){
+        if (which & std::ios_base::out) return pos_type(off_type(-1));
+        off_type base = (dir == std::ios_base::beg) ? 0 : ((dir == std::ios_base::cur) ? (gptr() - eback()) : (egptr() - eback()));
+        return seekpos(pos_type(base + off), which);
+    }
+    //! \brief Set the read location, used by \b std::istream::seekg().
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in){
+        if ((which & std::ios_base::out) || (off_type(pos) < 0) || (off_type(pos) > (egptr() - eback()))) return pos_type(off_type(-1));
+        setg(eback(), eback() + off_type(pos), egptr());
+        return pos;
+    }
+
+private:
+    std::shared_ptr<MappedFile const> file;
+};
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Arrays with fewer bytes are written inline in the metadata of the chunked binary format.
+ */
+constexpr size_t chunked_min_bytes = 65536;
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief The large arrays in the chunked binary format are split into chunks with this many bytes, each chunk has a checksum.
+ */
+constexpr size_t chunked_chunk_bytes = 16777216;
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Collects the large arrays of a grid when writing the chunked binary format, see \b writeChunkedFile().
+ * \endinternal
+ */
+struct ChunkedWriter{
+    //! \brief Add an array to the list and return the index of the array in the file.
+    long long addArray(void const *data, size_t num_bytes){
+        arrays.push_back({(char const*) data, num_bytes});
+        return (long long) arrays.size() - 1;
+    }
+    //! \brief Location and size in bytes of the arrays, the data must remain valid until the file is written.
+    std::vector<std::pair<char const*, size_t>> arrays;
+};
+
+/*!
+ * \internal
+ * \ingroup TasmanianIO
+ * \brief Holds the large arrays loaded from a file in the chunked binary format, see \b readChunkedFile().
+ * \endinternal
+ */
+struct ChunkedReader{
+    //! \brief The data of each array, using double guarantees the alignment of all types.
+    std::vector<std::shared_ptr<std::vector<double>>> arrays;
+    //! \brief The size in bytes of each array.
+    std::vector<size_t> num_bytes;
+};
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns the index of the stream pointer that holds the \b ChunkedWriter of the chunked binary format.
+ */
+inline int getChunkedWriterIndex(){
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns the index of the stream pointer that holds the \b ChunkedReader of the chunked binary format.
+ */
+inline int getChunkedReaderIndex(){
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns the \b ChunkedWriter associated with the stream, or \b nullptr if the stream does not use the chunked format.
+ */
+inline ChunkedWriter* getChunkedWriter(std::ios_base &s){ return (ChunkedWriter*) s.pword(getChunkedWriterIndex()); }
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns the \b ChunkedReader associated with the stream, or \b nullptr if the stream does not use the chunked format.
+ */
+inline ChunkedReader* getChunkedReader(std::ios_base &s){ return (ChunkedReader*) s.pword(getChunkedReaderIndex()); }
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Set the stream to collect the large arrays in \b writer, use \b nullptr to go back to the regular format.
+ */
+inline void setChunkedWriter(std::ios_base &s, ChunkedWriter *writer){ s.pword(getChunkedWriterIndex()) = (void*) writer; }
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Set the stream to take the large arrays from \b reader, use \b nullptr to go back to the regular format.
+ */
+inline void setChunkedReader(std::ios_base &s, ChunkedReader *reader){ s.pword(getChunkedReaderIndex()) = (void*) reader; }
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns a 64-bit Fletcher checksum of the data, used to verify the chunks of the chunked binary format.
+ */
+unsigned long long computeChecksum(char const *data, size_t num_bytes);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Write a file in the chunked binary format, the large arrays are written by multiple threads.
+ *
+ * The file consists of a header with the chunk size, the number of arrays, the size and checksum of the \b metadata,
+ * the checksum of the tables, and the checksum of the header itself,
+ * followed by the tables with the offset and size of each array and the checksums of all chunks, the \b metadata, and the arrays.
+ * Each array starts at an offset aligned to 4096 bytes, the chunks of all arrays are written in parallel.
+ * The \b metadata is the binary format of the grid with the large arrays replaced by their index in the \b writer.
+ */
+void writeChunkedFile(const char *filename, std::string const &metadata, ChunkedWriter const &writer);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Read a file written with \b writeChunkedFile(), returns the metadata and loads the arrays into the \b reader.
+ *
+ * The chunks are read by multiple threads and throws \b std::runtime_error if the file is truncated or a checksum does not match.
+ */
+std::string readChunkedFile(const char *filename, ChunkedReader &reader);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Write an array that can be moved into a separate block of the chunked binary format, the array cannot be empty.
+ *
+ * In the chunked binary format, large arrays are replaced by their index in the \b ChunkedWriter of the stream,
+ * small arrays are written inline and marked with index -1.
+ * Otherwise, this is the same as \b writeArray(), also in the mapped binary format.
+ */
+template<bool useAscii, IOPad pad, typename VecType>
+void writeChunkableArray(VecType const x[], size_t num_entries, std::ostream &os){
+    ChunkedWriter *writer = (useAscii) ? nullptr : getChunkedWriter(os);
+    if (writer != nullptr){
+        long long index = (num_entries * sizeof(VecType) < chunked_min_bytes) ? -1 : writer->addArray(x, num_entries * sizeof(VecType));
+        os.write((char const*) &index, sizeof(long long));
+        if (index != -1) return;
+    }
+    writeArray<useAscii, pad>(x, num_entries, os);
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Write an array that can be used directly from a memory mapped file, the array cannot be empty.
+ *
+ * In the mapped binary format, the array is preceded by one byte with the number of padding bytes followed by the padding,
+ * so that the data is aligned to \b mapped_alignment relative to the beginning of the stream.
+ * Otherwise, this is the same as \b writeChunkableArray().
+ */
+template<bool useAscii, IOPad pad, typename VecType>
+void writeMappableArray(VecType const x[], size_t num_entries, std::ostream &os){
+    if (!useAscii && (getChunkedWriter(os) == nullptr) && isMappedFormat(os)){
+        size_t offset = (size_t) os.tellp() + 1;
+        std::vector<char> padding((mapped_alignment - offset % mapped_alignment) % mapped_alignment + 1, 0);
+        padding[0] = (char) (padding.size() - 1);
+        os.write(padding.data(), padding.size());
+    }
+    writeChunkableArray<useAscii, pad>(x, num_entries, os);
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Read an array written with \b writeChunkableArray().
+ *
+ * If the array is in a separate block of the chunked binary format, the data is not copied,
+ * the returned pointer is the loaded block and \b owner is set to the block.
+ * Otherwise, the data is copied into \b x and the function returns \b nullptr.
+ */
+template<bool useAscii, typename VecType>
+VecType const* readChunkableArray(std::istream &is, size_t num_entries, std::vector<VecType> &x, std::shared_ptr<void const> &owner){
+    ChunkedReader *reader = (useAscii) ? nullptr : getChunkedReader(is);
+    if (reader != nullptr){
+        long long index = -1;
+        is.read((char*) &index, sizeof(long long));
+        if (index != -1){
+            if ((index < 0) || ((size_t) index >= reader->arrays.size()) || (reader->num_bytes[(size_t) index] != num_entries * sizeof(VecType)))
+                throw std::runtime_error("ERROR: wrong binary file format, incorrect array in the chunked file");
+            owner = reader->arrays[(size_t) index];
+            return reinterpret_cast<VecType const*>(reader->arrays[(size_t) index]->data());
+        }
+    }
+    x.resize(num_entries);
+    readVector<useAscii>(is, x);
+    return nullptr;
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Read an array written with \b writeMappableArray().
+ *
+ * If the stream uses the mapped binary format with a \b MappedBuffer, then the data is not copied,
+ * the returned pointer is the location of the array in the mapped file and \b owner is set to the file.
+ * Otherwise, this is the same as \b readChunkableArray().
+ */
+template<bool useAscii, typename VecType>
+VecType const* readMappableArray(std::istream &is, size_t num_entries, std::vector<VecType> &x, std::shared_ptr<void const> &owner){
+    if (!useAscii && (getChunkedReader(is) == nullptr) && isMappedFormat(is)){
+        char num_pad;
+        is.read(&num_pad, sizeof(char));
+        is.ignore((std::streamsize) num_pad);
+        MappedBuffer *buffer = dynamic_cast<MappedBuffer*>(is.rdbuf());
+        if (buffer != nullptr){
+            if (buffer->getRemaining() < num_entries * sizeof(VecType))
+                throw std::runtime_error("ERROR: wrong binary file format, the mapped file is truncated");
+            VecType const *data = reinterpret_cast<VecType const*>(buffer->getCurrent());
+            is.seekg((std::streamoff) (num_entries * sizeof(VecType)), std::ios::cur);
+            owner = buffer->getFile();
+            return data;
+        }
+    }
+    return readChunkableArray<useAscii>(is, num_entries, x, owner);
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Read an array written with \b writeChunkableArray() into the vector \b x, the data is always copied.
+ */
+template<bool useAscii, typename VecType>
+void readChunkableVector(std::istream &is, size_t num_entries, std::vector<VecType> &x){
+    std::shared_ptr<void const> owner;
+    VecType const *view = readChunkableArray<useAscii>(is, num_entries, x, owner);
+    if (view != nullptr) x = std::vector<VecType>(view, view + num_entries);
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Settings of the compressed binary format, the \b tolerance is the largest error allowed in the stored values.
+ *
+ * Zero tolerance uses lossless compression, i.e., the values are restored exactly.
+ */
+struct CompressedFormat{
+    //! \brief Largest absolute error allowed in the compressed values.
+    double tolerance;
+};
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns the index of the stream pointer that holds the \b CompressedFormat settings.
+ */
+inline int getCompressedFormatIndex(){
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns the \b CompressedFormat associated with the stream, or \b nullptr if the stream does not use the compressed format.
+ */
+inline CompressedFormat const* getCompressedFormat(std::ios_base &s){ return (CompressedFormat const*) s.pword(getCompressedFormatIndex()); }
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns \b true if the stream is set to use the compressed binary format.
+ */
+inline bool isCompressedFormat(std::ios_base &s){ return (getCompressedFormat(s) != nullptr); }
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Set the stream to use the compressed binary format with the given settings, use \b nullptr to go back to the regular format.
+ */
+inline void setCompressedFormat(std::ios_base &s, CompressedFormat const *format){ s.pword(getCompressedFormatIndex()) = (void*) format; }
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Write \b num_entries doubles as a single compressed block.
+ *
+ * If the \b tolerance is positive and the values are finite, the values are rounded to the nearest multiple of the tolerance
+ * and the multiples are stored as variable length integers, small values use a single byte.
+ * The quantization is used only if all reconstructed values are within the tolerance, which fails when the magnitude
+ * of the values is too large compared to the tolerance, and only if the result is smaller than the lossless block.
+ * Otherwise, the bytes of the values are shuffled so that the bytes with the same significance are stored together,
+ * e.g., all exponents come first, which allows for better compression of values with similar magnitude.
+ * In both cases, the bytes are compressed with run-length encoding.
+ */
+void writeCompressedBlock(double const x[], size_t num_entries, double tolerance, std::ostream &os);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Read \b num_entries doubles written with \b writeCompressedBlock(), throws \b std::runtime_error if the block does not match.
+ */
+void readCompressedBlock(std::istream &is, size_t num_entries, double x[]);
+
+/*!
+ * \ingroup TasmanianIO
+ * \brief Returns the number of bytes left in the stream, or the maximum size_t if the stream does not report positions.
+ *
+ * Used to check the sizes read from a file before allocating memory, the read position is not changed.
+ */
+size_t getRemainingBytes(std::istream &is);
+
 /*!
  * \ingroup TasmanianIO
  * \brief Write a rule.
@@ -32,14 +32,59 @@
 #define __TASMANIAN_SPARSE_GRID_INDEX_SETS_CPP
 
 #include "tsgIndexSets.hpp"
+#include "tsgHierarchyManipulator.hpp"
 
 namespace TasGrid{
 
+constexpr size_t MultiIndexHashIndex::hash_min_indexes;
+constexpr size_t MultiIndexHashIndex::hash_lookup_fraction;
+
+MultiIndexHashIndex::Table const* MultiIndexHashIndex::build(size_t num_dimensions, std::vector<int> const &indexes){
+    size_t num_indexes = indexes.size() / num_dimensions;
+    size_t size = 1;
+    while(size < 2 * num_indexes) size *= 2; // keep the table at most half full
+    Table *t = new Table;
+    t->mask = size - 1;
+    t->slots = std::vector<int>(size, -1);
+    for(size_t i=0; i<num_indexes; i++){
+        size_t k = hash(&indexes[i * num_dimensions], num_dimensions) & t->mask;
+        while(t->slots[k] != -1) k = (k + 1) & t->mask;
+        t->slots[k] = (int) i;
+    }
+    return t;
+}
+
+bool MultiIndexHashIndex::find(const int *p, size_t num_dimensions, std::vector<int> const &indexes, int &slot) const{
+    Table const *t = table.load(std::memory_order_acquire);
+    if (t == nullptr){
+        size_t num_indexes = (num_dimensions == 0) ? 0 : indexes.size() / num_dimensions;
+        if (num_indexes < hash_min_indexes || num_lookups.fetch_add(1, std::memory_order_relaxed) < num_indexes / hash_lookup_fraction)
+            return false;
+        std::lock_guard<std::mutex> lock(build_lock);
+        t = table.load(std::memory_order_acquire);
+        if (t == nullptr){
+            t = build(num_dimensions, indexes);
+            table.store(t, std::memory_order_release);
+        }
+    }
+    size_t k = hash(p, num_dimensions) & t->mask;
+    while(t->slots[k] != -1){
+        const int *q = &indexes[((size_t) t->slots[k]) * num_dimensions];
+        if (std::equal(q, q + num_dimensions, p)){
+            slot = t->slots[k];
+            return true;
+        }
+        k = (k + 1) & t->mask;
+    }
+    slot = -1;
+    return true;
+}
+
 template<bool useAscii>
 void MultiIndexSet::write(std::ostream &os) const{
     if (cache_num_indexes > 0){
         IO::writeNumbers<useAscii, IO::pad_rspace>(os, (int) num_dimensions, cache_num_indexes);
-        IO::writeVector<useAscii, IO::pad_line>(indexes, os);
+        IO::writeChunkableArray<useAscii, IO::pad_line>(indexes.data(), indexes.size(), os);
     }else{
         IO::writeNumbers<useAscii, IO::pad_line>(os, (int) num_dimensions, cache_num_indexes);
     }
@@ -47,10 +92,11 @@ void MultiIndexSet::write(std::ostream &os) const{
 
 template<bool useAscii>
 void MultiIndexSet::read(std::istream &is){
+    hash_index.clear();
     num_dimensions = (size_t) IO::readNumber<useAscii, int>(is);
     cache_num_indexes = IO::readNumber<useAscii, int>(is);
-    indexes.resize(num_dimensions * ((size_t) cache_num_indexes));
-    IO::readVector<useAscii>(is, indexes);
+    indexes = std::vector<int>();
+    if (cache_num_indexes > 0) IO::readChunkableVector<useAscii>(is, num_dimensions * ((size_t) cache_num_indexes), indexes);
 }
 
 template void MultiIndexSet::write<true>(std::ostream &) const; // instantiate for faster build
@@ -59,6 +105,7 @@ template void MultiIndexSet::read<true>(std::istream &);
 template void MultiIndexSet::read<false>(std::istream &);
 
 void MultiIndexSet::addSortedIndexes(const std::vector<int> &addition){
+    hash_index.clear();
     if (indexes.empty()){
         indexes = addition;
     }else{
@@ -151,6 +198,8 @@ void MultiIndexSet::setData2D(Data2D<int> const &data){
 }
 
 int MultiIndexSet::getSlot(const int *p) const{
+    int slot;
+    if (hash_index.find(p, num_dimensions, indexes, slot)) return slot;
     int sstart = 0, send = cache_num_indexes - 1;
     int current = (sstart + send) / 2;
     while (sstart <= send){
@@ -221,28 +270,86 @@ MultiIndexSet MultiIndexSet::diffSets(const MultiIndexSet &substract){
 void MultiIndexSet::removeIndex(const std::vector<int> &p){
     int slot = getSlot(p);
     if (slot > -1){
+        hash_index.clear();
         indexes.erase(indexes.begin() + ((size_t) slot) * num_dimensions, indexes.begin() + ((size_t) slot) * num_dimensions + num_dimensions);
         cache_num_indexes--;
     }
 }
 
-StorageSet::StorageSet() : num_outputs(0), num_values(0){}
+StorageSet::StorageSet() : num_outputs(0), num_values(0), view(nullptr){}
 StorageSet::~StorageSet(){}
 
+namespace IO{
+
+void writeLevelArray(double const x[], size_t stride, size_t num_strips, std::vector<int> const &levels, std::ostream &os){
+    double tolerance = getCompressedFormat(os)->tolerance;
+    std::vector<Data2D<double>> split = HierarchyManipulations::splitByLevels(stride, x, num_strips,
+                                            (levels.size() == num_strips) ? levels : std::vector<int>(num_strips, 0));
+    writeNumbers<false, pad_none>(os, (int) split.size());
+    for(auto const &block : split)
+        writeCompressedBlock(block.getStrip(0), block.getTotalEntries(), tolerance, os);
+}
+
+void readLevelArray(std::istream &is, size_t stride, size_t num_strips, std::vector<int> const &levels, double x[]){
+    std::vector<int> const &strip_levels = (levels.size() == num_strips) ? levels : std::vector<int>(num_strips, 0);
+    int file_levels = readNumber<false, int>(is);
+    // each level holds a compressed block with a header of at least 17 bytes, check before allocating
+    if (!is || (file_levels < 0) || ((size_t) file_levels > getRemainingBytes(is) / (1 + 2 * sizeof(unsigned long long))))
+        throw std::runtime_error("ERROR: wrong binary file format, incorrect number of levels in the compressed array");
+    size_t num_levels = (size_t) file_levels;
+    std::vector<size_t> level_strips(num_levels, 0);
+    for(auto l : strip_levels){
+        if ((size_t) l >= num_levels) throw std::runtime_error("ERROR: wrong binary file format, incorrect number of levels in the compressed array");
+        level_strips[(size_t) l]++;
+    }
+
+    std::vector<std::vector<double>> split(num_levels);
+    for(size_t l=0; l<num_levels; l++){
+        split[l].resize(level_strips[l] * stride);
+        readCompressedBlock(is, split[l].size(), split[l].data());
+    }
+
+    // put the strips back in the order of the points
+    std::fill(level_strips.begin(), level_strips.end(), 0);
+    for(size_t i=0; i<num_strips; i++){
+        size_t l = (size_t) strip_levels[i];
+        std::copy_n(split[l].begin() + level_strips[l]++ * stride, stride, x + i * stride);
+    }
+}
+
+}
+
 template<bool useAscii>
-void StorageSet::write(std::ostream &os) const{
+void StorageSet::write(std::ostream &os) const{ write<useAscii>(os, std::vector<int>()); }
+template<bool useAscii>
+void StorageSet::read(std::istream &is){ read<useAscii>(is, std::vector<int>()); }
+
+template<bool useAscii>
+void StorageSet::write(std::ostream &os, std::vector<int> const &levels) const{
     IO::writeNumbers<useAscii, IO::pad_rspace>(os, (int) num_outputs, (int) num_values);
-    IO::writeFlag<useAscii, IO::pad_auto>((values.size() != 0), os);
-    if (values.size() != 0)
-        IO::writeVector<useAscii, IO::pad_line>(values, os);
+    IO::writeFlag<useAscii, IO::pad_auto>((getTotalEntries() != 0), os);
+    if (getTotalEntries() != 0){
+        if (!useAscii && IO::isCompressedFormat(os)){
+            IO::writeLevelArray(getValues(0), num_outputs, num_values, levels, os);
+        }else{
+            IO::writeMappableArray<useAscii, IO::pad_line>(getValues(0), getTotalEntries(), os);
+        }
+    }
 }
 template<bool useAscii>
-void StorageSet::read(std::istream &is){
+void StorageSet::read(std::istream &is, std::vector<int> const &levels){
     num_outputs = (size_t) IO::readNumber<useAscii, int>(is);
     num_values = (size_t) IO::readNumber<useAscii, int>(is);
+    view = nullptr;
+    owner.reset();
+    values = std::vector<double>();
     if (IO::readFlag<useAscii>(is)){
-        values.resize(num_outputs * num_values);
-        IO::readVector<useAscii>(is, values);
+        if (!useAscii && IO::isCompressedFormat(is)){
+            values.resize(num_outputs * num_values);
+            IO::readLevelArray(is, num_outputs, num_values, levels, values.data());
+        }else{
+            view = IO::readMappableArray<useAscii>(is, num_outputs * num_values, values, owner);
+        }
     }
 }
 
@@ -250,21 +357,39 @@ template void StorageSet::write<true>(std::ostream &) const;
 template void StorageSet::write<false>(std::ostream &) const;
 template void StorageSet::read<true>(std::istream &);
 template void StorageSet::read<false>(std::istream &);
+template void StorageSet::write<true>(std::ostream &, std::vector<int> const &) const;
+template void StorageSet::write<false>(std::ostream &, std::vector<int> const &) const;
+template void StorageSet::read<true>(std::istream &, std::vector<int> const &);
+template void StorageSet::read<false>(std::istream &, std::vector<int> const &);
 
 void StorageSet::resize(int cnum_outputs, int cnum_values){
+    view = nullptr;
+    owner.reset();
     values = std::vector<double>();
     num_outputs = cnum_outputs;
     num_values = cnum_values;
 }
 
-const double* StorageSet::getValues(int i) const{ return &(values[i*num_outputs]); }
-double* StorageSet::getValues(int i){ return &(values[i*num_outputs]); }
+const double* StorageSet::getValues(int i) const{ return ((view != nullptr) ? view : values.data()) + Utils::size_mult(i, num_outputs); }
+double* StorageSet::getValues(int i){ copyView(); return values.data() + Utils::size_mult(i, num_outputs); }
+
+void StorageSet::copyView(){
+    if (view != nullptr){
+        values = std::vector<double>(view, view + num_outputs * num_values);
+        view = nullptr;
+        owner.reset();
+    }
+}
 
 void StorageSet::setValues(const double vals[]){
+    view = nullptr;
+    owner.reset();
     values.resize(num_outputs * num_values);
     std::copy_n(vals, num_values * num_outputs, values.data());
 }
 void StorageSet::setValues(std::vector<double> &&vals){
+    view = nullptr;
+    owner.reset();
     num_values = vals.size() / num_outputs;
     values = std::vector<double>(vals); // move assignment
 }
@@ -279,7 +404,7 @@ void StorageSet::addValues(const MultiIndexSet &old_set, const MultiIndexSet &ne
 
     int iold = 0, inew = 0;
     size_t off_vals = 0;
-    auto ivals = values.begin();
+    double const *ivals = (view != nullptr) ? view : values.data(); // no need to copy the view, it is released after the merge
     auto icombined = combined_values.begin();
 
     auto compareIndexes = [&](int const a[], int const b[])->
@@ -312,6 +437,8 @@ void StorageSet::addValues(const MultiIndexSet &old_set, const MultiIndexSet &ne
         std::advance(icombined, num_outputs);
     }
     std::swap(values, combined_values);
+    view = nullptr;
+    owner.reset();
 }
 
 }
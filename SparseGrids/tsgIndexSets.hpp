@@ -32,6 +32,8 @@
 #define __TASMANIAN_SPARSE_GRID_INDEX_SETS_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #include "tsgIOHelpers.hpp"
 
@@ -73,21 +75,28 @@ namespace TasGrid{
  * The data is divided into \b strips of equal \b stride, e.g., number of multi-indexes and number of dimensions.
  * Internally the class uses \b std::vector with type \b T,
  * when used, \b T is almost always \b double or \b int.
+ *
+ * The data can also be a read-only view of an external array, e.g., a memory mapped file, which is kept alive by a shared owner.
+ * The const methods read directly from the view, the non-const methods first make a private copy of the data (copy-on-write).
+ * The only exception is the const \b getVector(), which has no vector to return and throws for a view.
  * \endinternal
  */
 template<typename T>
 class Data2D{
 public:
     //! \brief Default constructor makes an empty data-structure.
-    Data2D() : stride(0), num_strips(0){}
+    Data2D() : stride(0), num_strips(0), view(nullptr){}
     //! \brief Create data-structure with given \b stride and number of \b strips.
-    Data2D(int new_stride, int new_num_strips) : stride((size_t) new_stride), num_strips((size_t) new_num_strips), vec(stride * num_strips){}
+    Data2D(int new_stride, int new_num_strips) : stride((size_t) new_stride), num_strips((size_t) new_num_strips), vec(stride * num_strips), view(nullptr){}
     //! \brief Create data-structure with given \b stride and number of \b strips.
-    Data2D(size_t new_stride, int new_num_strips) : stride(new_stride), num_strips((size_t) new_num_strips), vec(stride * num_strips){}
+    Data2D(size_t new_stride, int new_num_strips) : stride(new_stride), num_strips((size_t) new_num_strips), vec(stride * num_strips), view(nullptr){}
     //! \brief Create data-structure with given \b stride and number of \b strips and initializes with \b val.
-    Data2D(int new_stride, int new_num_strips, T val) : stride((size_t) new_stride), num_strips((size_t) new_num_strips), vec(stride * num_strips, val){}
+    Data2D(int new_stride, int new_num_strips, T val) : stride((size_t) new_stride), num_strips((size_t) new_num_strips), vec(stride * num_strips, val), view(nullptr){}
     //! \brief Create data-structure with given \b stride and number of \b strips and moves \b data into the internal vector.
-    Data2D(int new_stride, int new_num_strips, std::vector<T> &&data) : stride((size_t) new_stride), num_strips((size_t) new_num_strips), vec(data){}
+    Data2D(int new_stride, int new_num_strips, std::vector<T> &&data) : stride((size_t) new_stride), num_strips((size_t) new_num_strips), vec(data), view(nullptr){}
+    //! \brief Create a read-only view of the \b data with given \b stride and number of \b strips, the \b data_owner keeps the data alive.
+    Data2D(size_t new_stride, size_t new_num_strips, T const *data, std::shared_ptr<void const> const &data_owner) :
+        stride(new_stride), num_strips(new_num_strips), view(data), owner(data_owner){}
     //! \brief Default destructor.
     ~Data2D(){}
 
@@ -96,38 +105,53 @@ public:
 
     //! \brief Clear any existing data and allocate a new data-structure with given \b stride and number of \b strips.
     void resize(int new_stride, int new_num_strips){
+        releaseView();
         stride = (size_t) new_stride;
         num_strips = (size_t) new_num_strips;
         vec.resize(stride * num_strips);
     }
 
     //! \brief Returns a reference to the \b i-th strip.
-    T* getStrip(int i){ return &(vec[i*stride]); }
+    T* getStrip(int i){ copyView(); return vec.data() + Utils::size_mult(stride, i); }
     //! \brief Returns a const reference to the \b i-th strip.
-    T const* getStrip(int i) const{ return &(vec[i*stride]); }
+    T const* getStrip(int i) const{ return getData() + Utils::size_mult(stride, i); }
     //! \brief Return iterator set at the \b i-th strip.
-    typename std::vector<T>::iterator getIStrip(int i){ return vec.begin() + Utils::size_mult(stride, i); }
-    //! \brief Return const_iterator set at the \b i-th strip.
-    typename std::vector<T>::const_iterator getIStrip(int i) const{ return vec.cbegin() + Utils::size_mult(stride, i); }
+    typename std::vector<T>::iterator getIStrip(int i){ copyView(); return vec.begin() + Utils::size_mult(stride, i); }
+    //! \brief Return a const random access iterator set at the \b i-th strip, the iterator is a pointer since the data may be a view.
+    T const* getIStrip(int i) const{ return getStrip(i); }
     //! \brief Returns the stride.
     size_t getStride() const{ return stride; }
     //! \brief Returns the number of strips.
     int getNumStrips() const{ return (int) num_strips; }
     //! \brief Returns the total number of entries, stride times number of trips.
-    size_t getTotalEntries() const{ return vec.size(); }
+    size_t getTotalEntries() const{ return (view != nullptr) ? stride * num_strips : vec.size(); }
     //! \brief Returns a reference to the internal data.
-    std::vector<T>& getVector(){ return vec; }
-    //! \brief Returns a const reference to the internal data.
-    const std::vector<T>& getVector() const{ return vec; }
+    std::vector<T>& getVector(){ copyView(); return vec; }
+    //! \brief Returns a const reference to the internal data, cannot be used with a view (use \b getStrip() and \b getTotalEntries()).
+    const std::vector<T>& getVector() const{
+        if (view != nullptr) throw std::runtime_error("ERROR: internal Tasmanian error, Data2D::getVector() const called for a mapped view");
+        return vec;
+    }
+    //! \brief Returns \b true if the data is a read-only view of an external array.
+    bool isView() const{ return (view != nullptr); }
     //! \brief Clear all used data.
     void clear(){
+        releaseView();
         stride = 0;
         num_strips = 0;
-        vec = std::vector<double>();
+        vec = std::vector<T>();
     }
 
     //! \brief Uses std::vector::insert to append the data.
     void appendStrip(typename std::vector<T>::const_iterator const &x){
+        copyView();
+        vec.insert(vec.end(), x, x + stride);
+        num_strips++;
+    }
+
+    //! \brief Uses std::vector::insert to append one stride of entries starting at \b x.
+    void appendStrip(T const x[]){
+        copyView();
         vec.insert(vec.end(), x, x + stride);
         num_strips++;
     }
@@ -139,33 +163,188 @@ public:
 
     //! \brief Uses std::vector::insert to append a strip \b x to the existing data at position \b pos, assumes \b x.size() is one stride.
     void appendStrip(int pos, const std::vector<T> &x){
+        copyView();
         vec.insert(vec.begin() + (((size_t) pos) * stride), x.begin(), x.end());
         num_strips++;
     }
 
     //! \brief Fill the entire vector with the specified \b value.
-    void fill(T value){ std::fill(vec.begin(), vec.end(), value); }
+    void fill(T value){ releaseView(); vec.resize(stride * num_strips); std::fill(vec.begin(), vec.end(), value); }
+
+protected:
+    //! \brief If using a view, copy the data into the internal vector before the data is modified.
+    void copyView(){
+        if (view != nullptr){
+            vec = std::vector<T>(view, view + stride * num_strips);
+            releaseView();
+        }
+    }
+    //! \brief Returns the beginning of the data, either the view or the internal vector.
+    T const* getData() const{ return (view != nullptr) ? view : vec.data(); }
+    //! \brief Drop the view without copying the data.
+    void releaseView(){
+        view = nullptr;
+        owner.reset();
+    }
 
 private:
     size_t stride, num_strips;
     std::vector<T> vec;
+    T const *view;
+    std::shared_ptr<void const> owner;
 };
 
 namespace IO{
+    /*!
+    * \internal
+    * \ingroup TasmanianIO
+    * \brief Write the entries of the Data2D structure to the stream, the structure cannot be empty.
+    *
+    * The entries are written with \b writeMappableArray(), i.e., the data can be mapped directly from a file written in the mapped format.
+    * \endinternal
+    */
+    template<bool useAscii, IOPad pad, typename DataType>
+    void writeData2D(Data2D<DataType> const &data, std::ostream &os){
+        writeMappableArray<useAscii, pad>(data.getStrip(0), data.getTotalEntries(), os);
+    }
     /*!
     * \internal
     * \ingroup TasmanianIO
     * \brief Read the Data2D structure from the stream, assumes the given number of strips and stride.
+    *
+    * Reading from a memory mapped file in the mapped format returns a view into the file.
     * \endinternal
     */
     template<bool useAscii, typename DataType, typename IndexStride, typename IndexNumStrips>
     Data2D<DataType> readData2D(std::istream &is, IndexStride stride, IndexNumStrips num_strips){
-        Data2D<DataType> data(stride, num_strips);
-        readVector<useAscii>(is, data.getVector());
-        return data;
+        std::vector<DataType> x;
+        std::shared_ptr<void const> owner;
+        DataType const *view = readMappableArray<useAscii>(is, Utils::size_mult(stride, num_strips), x, owner);
+        if (view != nullptr) return Data2D<DataType>((size_t) stride, (size_t) num_strips, view, owner);
+        return Data2D<DataType>((int) stride, (int) num_strips, std::move(x));
+    }
+
+    /*!
+    * \internal
+    * \ingroup TasmanianIO
+    * \brief Write the \b num_strips strips of \b x in the compressed format, the strips are grouped by \b levels into separate blocks.
+    *
+    * The hierarchical coefficients decay with the level, grouping by level keeps entries with similar magnitude together,
+    * see \b writeCompressedBlock(). If the size of \b levels does not match \b num_strips, all strips are written in one block.
+    * \endinternal
+    */
+    void writeLevelArray(double const x[], size_t stride, size_t num_strips, std::vector<int> const &levels, std::ostream &os);
+    /*!
+    * \internal
+    * \ingroup TasmanianIO
+    * \brief Read the strips written with \b writeLevelArray(), the \b levels must be the same as the ones used in the write.
+    * \endinternal
+    */
+    void readLevelArray(std::istream &is, size_t stride, size_t num_strips, std::vector<int> const &levels, double x[]);
+
+    /*!
+    * \internal
+    * \ingroup TasmanianIO
+    * \brief Write the hierarchical coefficients with the given levels, uses the compressed format if set for the stream or \b writeData2D() otherwise.
+    * \endinternal
+    */
+    template<bool useAscii, IOPad pad>
+    void writeLevelData2D(Data2D<double> const &data, std::vector<int> const &levels, std::ostream &os){
+        if (!useAscii && isCompressedFormat(os)){
+            writeLevelArray(data.getStrip(0), data.getStride(), (size_t) data.getNumStrips(), levels, os);
+        }else{
+            writeData2D<useAscii, pad>(data, os);
+        }
+    }
+    /*!
+    * \internal
+    * \ingroup TasmanianIO
+    * \brief Read the hierarchical coefficients written with \b writeLevelData2D().
+    * \endinternal
+    */
+    template<bool useAscii, typename IndexStride, typename IndexNumStrips>
+    Data2D<double> readLevelData2D(std::istream &is, IndexStride stride, IndexNumStrips num_strips, std::vector<int> const &levels){
+        if (!useAscii && isCompressedFormat(is)){
+            Data2D<double> data((int) stride, (int) num_strips);
+            readLevelArray(is, (size_t) stride, (size_t) num_strips, levels, data.getStrip(0));
+            return data;
+        }
+        return readData2D<useAscii, double>(is, stride, num_strips);
     }
 }
 
+/*!
+ * \internal
+ * \ingroup TasmanianSets
+ * \brief Open-addressing hash table with the slots of the indexes of a \b MultiIndexSet, gives O(d) lookup regardless of the number of indexes.
+ *
+ * The table is built lazily, i.e., only after enough lookups have been made so that the cost of the build
+ * is amortized over the lookups, until then the set uses binary search.
+ * The table is shared by all threads and the build is guarded by a mutex.
+ * Copies start without a table, moves transfer the table together with the indexes.
+ * \endinternal
+ */
+class MultiIndexHashIndex{
+public:
+    //! \brief Default constructor, no table.
+    MultiIndexHashIndex() : table(nullptr), num_lookups(0){}
+    //! \brief Copy constructor, the copy starts without a table.
+    MultiIndexHashIndex(MultiIndexHashIndex const &) : table(nullptr), num_lookups(0){}
+    //! \brief Move constructor, takes the table of \b other.
+    MultiIndexHashIndex(MultiIndexHashIndex &&other) : table(other.table.exchange(nullptr)), num_lookups(0){}
+    //! \brief Copy assignment, discards the table.
+    MultiIndexHashIndex& operator =(MultiIndexHashIndex const &){ clear(); return *this; }
+    //! \brief Move assignment, takes the table of \b other.
+    MultiIndexHashIndex& operator =(MultiIndexHashIndex &&other){
+        Table const *other_table = other.table.exchange(nullptr);
+        clear();
+        table.store(other_table);
+        return *this;
+    }
+    //! \brief Destructor, deletes the table.
+    ~MultiIndexHashIndex(){ clear(); }
+
+    //! \brief Discard the table, must be called whenever the indexes change and cannot be called concurrently with \b find().
+    void clear(){
+        delete table.exchange(nullptr);
+        num_lookups = 0;
+    }
+
+    /*!
+     * \brief Look for \b p in the \b indexes, returns \b false if the table is not available and the caller should use binary search.
+     *
+     * If the table is available, \b slot is set to the slot of \b p or -1 if \b p is missing.
+     * The table is built during the call once the number of lookups exceeds \b hash_lookup_fraction of the number of indexes.
+     */
+    bool find(const int *p, size_t num_dimensions, std::vector<int> const &indexes, int &slot) const;
+
+    //! \brief Sets smaller than this always use binary search.
+    static constexpr size_t hash_min_indexes = 256;
+    //! \brief The table is built after (number of indexes) / hash_lookup_fraction lookups.
+    static constexpr size_t hash_lookup_fraction = 8;
+
+private:
+    //! \brief Open-addressing table with linear probing, size is a power of 2 and -1 marks an empty entry.
+    struct Table{
+        size_t mask;
+        std::vector<int> slots;
+    };
+    //! \brief Build the table for the \b indexes.
+    static Table const* build(size_t num_dimensions, std::vector<int> const &indexes);
+    //! \brief Hash of the multi-index \b p.
+    static size_t hash(const int *p, size_t num_dimensions){
+        unsigned long long h = 0x9E3779B97F4A7C15ULL;
+        for(size_t j=0; j<num_dimensions; j++) h = (h ^ (unsigned int) p[j]) * 0xFF51AFD7ED558CCDULL;
+        h ^= (h >> 32);
+        h ^= (h >> 17);
+        return (size_t) h;
+    }
+
+    mutable std::atomic<Table const*> table;
+    mutable std::atomic<size_t> num_lookups;
+    mutable std::mutex build_lock;
+};
+
 /*!
  * \internal
  * \ingroup TasmanianSets
@@ -222,9 +401,15 @@ public:
     //! \brief Returns a const reference to the internal data
     inline const std::vector<int>& getVector() const{ return indexes; }
     //! \brief Returns a reference to the internal data, must not modify the lexicographical order or the size of the vector
-    inline std::vector<int>& getVector(){ return indexes; } // used for remapping during tensor generic points
+    inline std::vector<int>& getVector(){ hash_index.clear(); return indexes; } // used for remapping during tensor generic points
 
-    //! \brief Returns the slot containing index **p**, returns `-1` if not found
+    /*!
+     * \brief Returns the slot containing index **p**, returns `-1` if not found
+     *
+     * Small sets and sets with few lookups use O(d log(n)) binary search,
+     * large sets switch to O(d) lookup with a hash table that is built on demand, see \b MultiIndexHashIndex.
+     * The table is discarded when the set is modified.
+     */
     int getSlot(const int *p) const;
     //! \brief Returns the slot containing index **p**, returns `-1` if not found
     inline int getSlot(const std::vector<int> &p) const{ return getSlot(p.data()); }
@@ -256,6 +441,7 @@ private:
     size_t num_dimensions;
     int cache_num_indexes;
     std::vector<int> indexes;
+    MultiIndexHashIndex hash_index;
 };
 
 /*!
@@ -289,6 +475,16 @@ public:
     //! \brief Read the from the stream, must know whether to use ASCII or binary format.
     template<bool useAscii> void read(std::istream &os);
 
+    /*!
+     * \brief Overload that groups the values by the \b levels of the points when using the compressed format, see \b IO::writeLevelArray().
+     *
+     * The \b levels are ignored by the other formats and the same levels must be used when reading the values.
+     */
+    template<bool useAscii> void write(std::ostream &os, std::vector<int> const &levels) const;
+
+    //! \brief Overload that reads the values written with the \b levels of the points.
+    template<bool useAscii> void read(std::istream &os, std::vector<int> const &levels);
+
     //! \brief Clear the existing values and assigns new dimensions, does not allocate memory for the new values.
     void resize(int cnum_outputs, int cnum_values);
 
@@ -297,9 +493,14 @@ public:
     //! \brief Returns reference to the \b i-th value.
     double* getValues(int i);
     //! \brief Returns reference to the internal data vector.
-    std::vector<double>& getVector(){ return values; }
-    //! \brief Returns const reference to the internal data vector.
-    const std::vector<double>& getVector() const{ return values; }
+    std::vector<double>& getVector(){ copyView(); return values; }
+    //! \brief Returns const reference to the internal data vector, cannot be used with a view (use \b getValues() and \b getTotalEntries()).
+    const std::vector<double>& getVector() const{
+        if (view != nullptr) throw std::runtime_error("ERROR: internal Tasmanian error, StorageSet::getVector() const called for a mapped view");
+        return values;
+    }
+    //! \brief Returns the total number of stored entries, i.e., the number of outputs times the number of values.
+    size_t getTotalEntries() const{ return (view != nullptr) ? num_outputs * num_values : values.size(); }
 
     //! \brief Replace the existing values with a copy of **vals**, the size must be at least **num_outputs** times **num_values**
     void setValues(const double vals[]);
@@ -318,9 +519,15 @@ public:
      */
     void addValues(const MultiIndexSet &old_set, const MultiIndexSet &new_set, const double new_vals[]);
 
+protected:
+    //! \brief If the values are a view of a memory mapped file, copy the data before the values are modified, see \b Data2D.
+    void copyView();
+
 private:
     size_t num_outputs, num_values; // kept as size_t to avoid conversions in products, but each one is small individually
     std::vector<double> values;
+    double const *view;
+    std::shared_ptr<void const> owner;
 };
 
 }
@@ -330,75 +330,140 @@ int SparseMatrix::getNumRows() const{ return num_rows; }
 
 void SparseMatrix::computeILU(){
     indxD.resize(num_rows);
-    ilu.resize(pntr[num_rows]);
-    for(int i=0; i<num_rows; i++){
-		int j = pntr[i];
-		while(indx[j] < i){ j++; };
-		indxD[i] = j;
-	}
+    for(int i=0; i<num_rows; i++)
+        indxD[i] = (int) std::distance(indx.begin(), std::lower_bound(indx.begin() + pntr[i], indx.begin() + pntr[i+1], i));
+
+    computeLevels();
 
 	ilu = vals;
 
-    for(int i=0; i<num_rows-1; i++){
-        double u = ilu[indxD[i]];
-        #pragma omp parallel for
-        for(int j=i+1; j<num_rows; j++){ // update the rest of the matrix, each row can be done in parallel
-            int jc = pntr[j];
-            while(indx[jc] < i){ jc++; }
-            if (indx[jc] == i){
-                ilu[jc] /= u;
-                double l = ilu[jc];
-                int ik = indxD[i]+1;
-                int jk = jc+1;
-                while((ik<pntr[i+1]) && (jk<pntr[j+1])){
-                    if (indx[ik] == indx[jk]){
-                        ilu[jk] -= l * ilu[ik];
-                        ik++; jk++;
-                    }else if (indx[ik] < indx[jk]){
-                        ik++;
-                    }else{
-                        jk++;
-                    }
-                }
+    // row-by-row (left-looking) elimination, row i is updated with the rows k < i that appear in the lower part of row i,
+    // each entry receives the same updates in the same order as in the column-by-column (right-looking) algorithm
+    // the position map of row i replaces the merge of the sorted indexes of rows i and k
+    applyByLevel(level_lower, rows_lower, [&](int i)->void{
+        static thread_local std::vector<int> position;
+        if (position.size() < (size_t) num_rows) position.assign((size_t) num_rows, -1);
+        for(int j=pntr[i]; j<pntr[i+1]; j++) position[indx[j]] = j;
+
+        for(int jc=pntr[i]; jc<indxD[i]; jc++){
+            int k = indx[jc];
+            ilu[jc] /= ilu[indxD[k]];
+            double l = ilu[jc];
+            for(int ik=indxD[k]+1; ik<pntr[k+1]; ik++){
+                int jk = position[indx[ik]];
+                if (jk > jc) ilu[jk] -= l * ilu[ik];
             }
         }
+
+        for(int j=pntr[i]; j<pntr[i+1]; j++) position[indx[j]] = -1;
+    });
+}
+
+void SparseMatrix::computeLevels(){
+    // the level of a row is one more than the largest level of the rows it depends on
+    auto group = [&](const std::vector<int> &level, int num_levels, std::vector<int> &offsets, std::vector<int> &rows)->void{
+        offsets = std::vector<int>(num_levels + 1, 0);
+        for(auto l : level) offsets[l+1]++;
+        for(int l=0; l<num_levels; l++) offsets[l+1] += offsets[l];
+        rows.resize(num_rows);
+        std::vector<int> next(offsets.begin(), offsets.end() - 1);
+        for(int i=0; i<num_rows; i++) rows[next[level[i]]++] = i;
+    };
+
+    std::vector<int> level(num_rows);
+    int num_levels = 0;
+    for(int i=0; i<num_rows; i++){
+        int l = 0;
+        for(int j=pntr[i]; j<indxD[i]; j++) l = std::max(l, level[indx[j]] + 1);
+        level[i] = l;
+        num_levels = std::max(num_levels, l + 1);
     }
+    group(level, num_levels, level_lower, rows_lower);
+
+    num_levels = 0;
+    for(int i=num_rows-1; i>=0; i--){
+        int l = 0;
+        for(int j=indxD[i]+1; j<pntr[i+1]; j++) l = std::max(l, level[indx[j]] + 1);
+        level[i] = l;
+        num_levels = std::max(num_levels, l + 1);
+    }
+    group(level, num_levels, level_upper, rows_upper);
+}
+
+template<typename callable> void SparseMatrix::applyByLevel(const std::vector<int> &levels, const std::vector<int> &rows, callable apply) const{
+    int num_levels = (int) levels.size() - 1;
+    if (num_levels * 16 > num_rows){ // few rows per level, the synchronization will cost more than the work
+        for(auto i : rows) apply(i);
+        return;
+    }
+    #pragma omp parallel
+    {
+        for(int l=0; l<num_levels; l++){
+            #pragma omp for schedule(static)
+            for(int r=levels[l]; r<levels[l+1]; r++) apply(rows[r]);
+        }
+    }
+}
+
+void SparseMatrix::applyILU(int num_vectors, double v[]) const{
+    size_t nv = (size_t) num_vectors;
+    applyByLevel(level_lower, rows_lower, [&](int i)->void{
+        double *vi = &(v[i * nv]);
+        for(int j=pntr[i]; j<indxD[i]; j++){
+            const double *vj = &(v[indx[j] * nv]);
+            double l = ilu[j];
+            #pragma omp simd
+            for(size_t c=0; c<nv; c++) vi[c] -= l * vj[c];
+        }
+    });
+    applyByLevel(level_upper, rows_upper, [&](int i)->void{
+        double *vi = &(v[i * nv]);
+        for(int j=indxD[i]+1; j<pntr[i+1]; j++){
+            const double *vj = &(v[indx[j] * nv]);
+            double u = ilu[j];
+            #pragma omp simd
+            for(size_t c=0; c<nv; c++) vi[c] -= u * vj[c];
+        }
+        double d = ilu[indxD[i]];
+        #pragma omp simd
+        for(size_t c=0; c<nv; c++) vi[c] /= d;
+    });
+}
+
+void SparseMatrix::solve(const double b[], double x[], bool transposed, bool use_initial_guess) const{
+    SolverWorkspace workspace;
+    solve(b, x, transposed, use_initial_guess, workspace);
 }
 
-void SparseMatrix::solve(const double b[], double x[], bool transposed) const{ // ustd::sing GMRES
+void SparseMatrix::solve(const double b[], double x[], bool transposed, bool use_initial_guess, SolverWorkspace &workspace) const{ // ustd::sing GMRES
     int max_inner = 30;
     int max_outer = 80;
-    std::vector<double> W((max_inner+1) * num_rows); // Krylov basis
-
-    std::vector<double> H(max_inner * (max_inner+1)); // holds the transformation for the normalized basis
-    std::vector<double> S(max_inner); // std::sin and std::cos of the Givens rotations
-    std::vector<double> C(max_inner+1);
-    std::vector<double> Z(max_inner); // holds the coefficients of the solution
+    std::vector<double> &W = workspace.W;
+    W.resize((max_inner+1) * num_rows); // Krylov basis
+
+    std::vector<double> &H = workspace.H;
+    H.resize(max_inner * (max_inner+1)); // holds the transformation for the normalized basis
+    std::vector<double> &S = workspace.S;
+    S.resize(max_inner); // std::sin and std::cos of the Givens rotations
+    std::vector<double> &C = workspace.C;
+    C.resize(max_inner+1);
+    std::vector<double> &Z = workspace.Z;
+    Z.resize(max_inner); // holds the coefficients of the solution
 
     double alpha, h_k; // temp variables
 
     double outer_res = tol + 1.0; // outer and inner residual
     int outer_itr = 0; // counts the inner and outer iterations
 
-    std::vector<double> pb(num_rows);
+    std::vector<double> &pb = workspace.pb;
+    pb.resize(num_rows);
     if (!transposed){
         std::copy(b, b + num_rows, pb.data());
 
-        // action of the preconditioner
-        for(int i=1; i<num_rows; i++){
-            for(int j=pntr[i]; j<indxD[i]; j++){
-                pb[i] -= ilu[j] * pb[indx[j]];
-            }
-        }
-        for(int i=num_rows-1; i>=0; i--){
-            for(int j=indxD[i]+1; j<pntr[i+1]; j++){
-                pb[i] -= ilu[j] * pb[indx[j]];
-            }
-            pb[i] /= ilu[indxD[i]];
-        }
+        applyILU(1, pb.data()); // action of the preconditioner
     }
 
-    std::fill(x, x + num_rows, 0.0); // zero initial guess, I wonder if we can improve this
+    if (transposed || !use_initial_guess) std::fill(x, x + num_rows, 0.0); // zero initial guess
 
     while ((outer_res > tol) && (outer_itr < max_outer)){
         for(int i=0; i<num_rows; i++) W[i] = 0.0;
@@ -429,17 +494,7 @@ void SparseMatrix::solve(const double b[], double x[], bool transposed) const{ /
                     W[i] += vals[j] * x[indx[j]];
                 }
             }
-            for(int i=1; i<num_rows; i++){
-                for(int j=pntr[i]; j<indxD[i]; j++){
-                    W[i] -= ilu[j] * W[indx[j]];
-                }
-            }
-            for(int i=num_rows-1; i>=0; i--){
-                for(int j=indxD[i]+1; j<pntr[i+1]; j++){
-                    W[i] -= ilu[j] * W[indx[j]];
-                }
-                W[i] /= ilu[indxD[i]];
-            }
+            applyILU(1, W.data());
 
             for(int i=0; i<num_rows; i++){
                 W[i] = pb[i] - W[i];
@@ -481,17 +536,7 @@ void SparseMatrix::solve(const double b[], double x[], bool transposed) const{ /
                         W[inner_itr*num_rows + i] += vals[j] * W[num_rows*(inner_itr-1) + indx[j]];
                     }
                 }
-                for(int i=1; i<num_rows; i++){
-                    for(int j=pntr[i]; j<indxD[i]; j++){
-                        W[inner_itr*num_rows + i] -= ilu[j] * W[inner_itr*num_rows + indx[j]];
-                    }
-                }
-                for(int i=num_rows-1; i>=0; i--){
-                    for(int j=indxD[i]+1; j<pntr[i+1]; j++){
-                        W[inner_itr*num_rows + i] -= ilu[j] * W[inner_itr*num_rows + indx[j]];
-                    }
-                    W[inner_itr*num_rows + i] /= ilu[indxD[i]];
-                }
+                applyILU(1, &(W[inner_itr*num_rows]));
             }
 
             #pragma omp parallel for
@@ -569,6 +614,196 @@ void SparseMatrix::solve(const double b[], double x[], bool transposed) const{ /
     }
 }
 
+void SparseMatrix::solve(int num_rhs, const double B[], double X[], bool use_initial_guess) const{
+    int block_size = 16; // right-hand-sides per block, the vectors of each row of the block are contiguous
+    int num_blocks = num_rhs / block_size + ((num_rhs % block_size == 0) ? 0 : 1);
+
+    #pragma omp parallel
+    {
+        SolverWorkspace workspace; // reused by all blocks of this thread, every entry is set before it is read
+        #pragma omp for schedule(dynamic)
+        for(int b=0; b<num_blocks; b++){
+            int offset = b * block_size;
+            solveBlock(num_rhs, std::min(block_size, num_rhs - offset), &(B[offset]), &(X[offset]), use_initial_guess, workspace);
+        }
+    }
+}
+
+void SparseMatrix::solveBlock(int stride, int num_block, const double B[], double X[], bool use_initial_guess, SolverWorkspace &workspace) const{
+    // GMRES in lockstep, see solve(), all vectors have num_rows strips of size num_block
+    int max_inner = 30;
+    int max_outer = 80;
+    size_t nb = (size_t) num_block;
+    size_t n = (size_t) num_rows * nb;
+
+    std::vector<double> &W = workspace.W;
+    W.resize((max_inner+1) * n); // Krylov basis
+
+    std::vector<double> &H = workspace.H;
+    H.resize(max_inner * (max_inner+1) * nb); // transformations for each vector
+    std::vector<double> &S = workspace.S;
+    S.resize(max_inner * nb); // sin and cos of the Givens rotations
+    std::vector<double> &C = workspace.C;
+    C.resize((max_inner+1) * nb);
+    std::vector<double> &Z = workspace.Z;
+    Z.resize(max_inner * nb); // coefficients of the solutions
+    std::vector<double> &hk = workspace.hk;
+    hk.resize(nb);
+
+    std::vector<double> outer_res(nb, tol + 1.0), inner_res(nb);
+    std::vector<int> outer_itr(nb, 0), inner_itr(nb);
+    std::vector<bool> active(nb), running(nb);
+
+    auto hentry = [&](int i, int j)->double*{ return &(H[(size_t) (i * max_inner + j) * nb]); };
+
+    // r = A v
+    auto multiply = [&](const double v[], double r[])->void{
+        for(int i=0; i<num_rows; i++){
+            double *ri = &(r[i * nb]);
+            std::fill(ri, ri + nb, 0.0);
+            for(int j=pntr[i]; j<pntr[i+1]; j++){
+                const double *vj = &(v[indx[j] * nb]);
+                double a = vals[j];
+                #pragma omp simd
+                for(size_t c=0; c<nb; c++) ri[c] += a * vj[c];
+            }
+        }
+    };
+    // nrm[c] = sqrt(v[:, c] * v[:, c])
+    auto norms = [&](const double v[], double nrm[])->void{
+        std::fill(nrm, nrm + nb, 0.0);
+        for(int i=0; i<num_rows; i++){
+            const double *vi = &(v[i * nb]);
+            #pragma omp simd
+            for(size_t c=0; c<nb; c++) nrm[c] += vi[c] * vi[c];
+        }
+        for(size_t c=0; c<nb; c++) nrm[c] = std::sqrt(nrm[c]);
+    };
+
+    std::vector<double> &pb = workspace.pb;
+    std::vector<double> &x = workspace.x;
+    pb.resize(n);
+    x.resize(n);
+    for(int i=0; i<num_rows; i++) std::copy_n(&(B[i * stride]), nb, &(pb[i * nb]));
+    applyILU(num_block, pb.data()); // action of the preconditioner
+
+    std::fill(x.begin(), x.end(), 0.0);
+    if (use_initial_guess){
+        // keep the initial guess only for the vectors where it reduces the residual, compared to the zero guess
+        for(int i=0; i<num_rows; i++) std::copy_n(&(X[i * stride]), nb, &(W[n + i * nb]));
+        multiply(&(W[n]), W.data());
+        applyILU(num_block, W.data());
+        for(size_t i=0; i<n; i++) W[i] = pb[i] - W[i];
+        norms(W.data(), Z.data());
+        norms(pb.data(), hk.data());
+        for(size_t c=0; c<nb; c++)
+            if (Z[c] < hk[c]) for(int i=0; i<num_rows; i++) x[i * nb + c] = W[n + i * nb + c];
+    }
+
+    for(size_t c=0; c<nb; c++) active[c] = true;
+    while(std::any_of(active.begin(), active.end(), [](bool a)->bool{ return a; })){
+        multiply(x.data(), W.data());
+        applyILU(num_block, W.data());
+        for(size_t i=0; i<n; i++) W[i] = pb[i] - W[i];
+
+        norms(W.data(), Z.data());
+        for(size_t c=0; c<nb; c++){
+            inner_res[c] = Z[c];
+            running[c] = active[c] && (Z[c] > tol) && (max_inner > 1);
+            inner_itr[c] = 0;
+            if (running[c]){
+                for(int i=0; i<num_rows; i++) W[i * nb + c] /= Z[c];
+            }else{
+                for(int i=0; i<num_rows; i++) W[i * nb + c] = 0.0;
+            }
+        }
+
+        int k = 0; // size of the basis, the same for all running vectors
+        while(std::any_of(running.begin(), running.end(), [](bool r)->bool{ return r; })){
+            k++;
+            double *wk = &(W[k * n]);
+            multiply(&(W[(k-1) * n]), wk);
+            applyILU(num_block, wk);
+
+            for(int i=0; i<k; i++){
+                double *h = hentry(i, k-1);
+                const double *wi = &(W[i * n]);
+                std::fill(h, h + nb, 0.0);
+                for(int j=0; j<num_rows; j++){
+                    #pragma omp simd
+                    for(size_t c=0; c<nb; c++) h[c] += wk[j * nb + c] * wi[j * nb + c];
+                }
+            }
+            for(int j=0; j<num_rows; j++){
+                for(int i=0; i<k; i++){
+                    const double *h = hentry(i, k-1);
+                    const double *wi = &(W[i * n + j * nb]);
+                    #pragma omp simd
+                    for(size_t c=0; c<nb; c++) wk[j * nb + c] -= h[c] * wi[c];
+                }
+            }
+
+            norms(wk, hk.data());
+            for(size_t c=0; c<nb; c++){
+                if (!running[c]){ // the vector has converged, keep the rest of the basis at zero
+                    for(int j=0; j<num_rows; j++) wk[j * nb + c] = 0.0;
+                    continue;
+                }
+                double h_k = hk[c];
+                if (h_k > 0.0) for(int j=0; j<num_rows; j++) wk[j * nb + c] /= h_k;
+
+                for(int i=0; i<k-1; i++){ // form the next row of the transformation
+                    double alpha = hentry(i, k-1)[c];
+                    hentry(i, k-1)[c]   = C[i * nb + c] * alpha + S[i * nb + c] * hentry(i+1, k-1)[c];
+                    hentry(i+1, k-1)[c] = S[i * nb + c] * alpha - C[i * nb + c] * hentry(i+1, k-1)[c];
+                }
+
+                double alpha = std::sqrt(h_k * h_k + hentry(k-1, k-1)[c] * hentry(k-1, k-1)[c]);
+
+                // set the next set of Givens rotations
+                S[(k-1) * nb + c] = h_k / alpha;
+                C[(k-1) * nb + c] = hentry(k-1, k-1)[c] / alpha;
+
+                hentry(k-1, k-1)[c] = alpha;
+
+                Z[k * nb + c] = S[(k-1) * nb + c] * Z[(k-1) * nb + c];
+                Z[(k-1) * nb + c] = C[(k-1) * nb + c] * Z[(k-1) * nb + c];
+
+                inner_res[c] = std::abs(Z[k * nb + c]);
+                inner_itr[c] = k;
+                running[c] = (inner_res[c] > tol) && (k < max_inner-1);
+            }
+        }
+
+        for(size_t c=0; c<nb; c++){
+            if (!active[c]) continue;
+            int itr = inner_itr[c] - 1;
+            if (itr > -1){ // if the first guess was not within TOL of the true solution
+                Z[itr * nb + c] /= hentry(itr, itr)[c];
+                for(int i=itr-1; i>-1; i--){
+                    double h_k = 0.0;
+                    for(int j=i+1; j<=itr; j++){
+                        h_k += hentry(i, j)[c] * Z[j * nb + c];
+                    }
+                    Z[i * nb + c] = (Z[i * nb + c] - h_k) / hentry(i, i)[c];
+                }
+
+                for(int i=0; i<=itr; i++){
+                    double z = Z[i * nb + c];
+                    const double *wi = &(W[i * n + c]);
+                    for(int j=0; j<num_rows; j++) x[j * nb + c] += z * wi[j * nb];
+                }
+            }
+
+            outer_res[c] = inner_res[c];
+            outer_itr[c]++;
+            active[c] = (outer_res[c] > tol) && (outer_itr[c] < max_outer);
+        }
+    }
+
+    for(int i=0; i<num_rows; i++) std::copy_n(&(x[i * nb]), nb, &(X[i * stride]));
+}
+
 } /* namespace TasSparse */
 
 }
@@ -32,6 +32,7 @@
 #define __TASMANIAN_LINEAR_SOLVERS_HPP
 
 #include <complex>
+#include <algorithm>
 
 #include "tsgEnumerates.hpp"
 
@@ -123,14 +124,48 @@ public:
     //! \brief Default destructor.
     ~SparseMatrix();
 
+    /*!
+     * \brief Buffers for the GMRES iterations.
+     *
+     * The Krylov basis and the Givens rotations are sized by the number of rows (and right-hand-sides),
+     * a solve with multiple right-hand-sides creates one workspace per thread that is reused by all blocks handled by the thread,
+     * the caller of the single right-hand-side solve() can keep one workspace for a sequence of solves with the same matrix.
+     * Every entry is set before it is read, a workspace can be reused with any matrix.
+     */
+    struct SolverWorkspace{
+        std::vector<double> W, H, S, C, Z; // Krylov basis, transformation, rotations and solution coefficients
+        std::vector<double> pb, x, hk; // preconditioned right-hand-side, current solution and norms (used by solveBlock())
+        std::vector<double> rhs; // copy of the right-hand-side, used by the callers that solve in place
+    };
+
     //! \brief Load the sparse matrix in row-compressed form.
     void load(const std::vector<int> &lpntr, const std::vector<std::vector<int>> &lindx, const std::vector<std::vector<double>> &lvals);
 
     //! \brief Return the number of rows in the matrix.
     int getNumRows() const;
 
-    //! \brief Solve `op(A) x = b` where `op` is either identity (find the coefficients) or transpose (find the interpolation weights).
-	void solve(const double b[], double x[], bool transposed = false) const;
+    /*!
+     * \brief Solve `op(A) x = b` where `op` is either identity (find the coefficients) or transpose (find the interpolation weights).
+     *
+     * If \b use_initial_guess is \b true and \b transposed is \b false, the iterations start from the values of \b x on entry,
+     * e.g., the solution for nearby values, otherwise the initial guess is zero.
+     */
+	void solve(const double b[], double x[], bool transposed = false, bool use_initial_guess = false) const;
+
+    //! \brief Same as solve() but uses the buffers of the caller owned \b workspace, no memory is allocated after the first call with the same matrix.
+    void solve(const double b[], double x[], bool transposed, bool use_initial_guess, SolverWorkspace &workspace) const;
+
+    /*!
+     * \brief Solve `A X = B` for \b num_rhs right-hand-sides, \b B and \b X are stored row-major with stride \b num_rhs.
+     *
+     * The layout matches the values and coefficients of the wavelet grids, i.e., the outputs of each point are contiguous.
+     * The right-hand-sides are split into blocks that are processed in parallel,
+     * within each block the GMRES iterations run in lockstep and the matrix-vector products and the preconditioner
+     * are applied to all vectors of the block in a single pass over the matrix.
+     * The result for each right-hand-side is the same as the one computed by solve(),
+     * \b use_initial_guess has the same meaning as in the non-transposed solve().
+     */
+    void solve(int num_rhs, const double B[], double X[], bool use_initial_guess = false) const;
 
 protected:
     //! \brief Clear the internal data structures (maybe not needed?)
@@ -139,11 +174,30 @@ protected:
     //! \brief Compute the incomplete lower-upper decomposition of the matrix (zero extra fill).
     void computeILU();
 
+    /*!
+     * \brief Group the rows into levels of independent rows, computed from the sparsity pattern.
+     *
+     * The rows in \b rows_lower are sorted so that the rows with index between \b level_lower[l] and \b level_lower[l+1]
+     * depend only on rows in earlier levels of the lower triangular part of the matrix,
+     * \b rows_upper and \b level_upper describe the same structure for the upper triangular part.
+     */
+    void computeLevels();
+
+    //! \brief Calls \b apply(i) for all rows, the rows in each level are processed in parallel and the levels are processed in order.
+    template<typename callable> void applyByLevel(const std::vector<int> &levels, const std::vector<int> &rows, callable apply) const;
+
+    //! \brief Applies the forward and backward sweeps of the preconditioner, \b v holds \b num_vectors entries for each row.
+    void applyILU(int num_vectors, double v[]) const;
+
+    //! \brief Solve for a block of \b num_block right-hand-sides, \b B and \b X are offset to the first entry of the block and have row stride \b stride.
+    void solveBlock(int stride, int num_block, const double B[], double X[], bool use_initial_guess, SolverWorkspace &workspace) const;
+
 private:
     double tol;
     int num_rows;
     std::vector<int> pntr, indx, indxD;
     std::vector<double> vals, ilu;
+    std::vector<int> level_lower, rows_lower, level_upper, rows_upper;
 };
 
 }
@@ -68,6 +68,8 @@ public:
 
     //! \brief Get the canonical coordinate of the node with global index \b j.
     double getNode(int j) const;
+    //! \brief Get the number of nodes across all loaded levels, i.e., one more than the largest global index.
+    int getNumNodes() const{ return (int) unique.size(); }
     //! \brief Get the quadrature weight of the \b j-th node on the \b level (for non-nested rules, using index local to the level)
     double getWeight(int level, int j) const;
 
@@ -40,6 +40,7 @@ RuleWavelet::RuleWavelet(int ord, int iter_depth){
     // Note: Only orders 1 & 3 wavelets are currently implemented.
     iteration_depth = iter_depth;
     num_data_points = (1 << iteration_depth) + 1;
+    step = 2.0 / ((double) (num_data_points - 1));
     order = 0;
     updateOrder(ord);
 }
@@ -50,32 +51,20 @@ void RuleWavelet::updateOrder(int ord){
     if(order == ord) return;
 
     // clear is practically free, call it every time
-    data = std::vector<std::vector<double>>();
-    cachexs = std::vector<double>();
+    tables = std::vector<double>();
 
     order = ord;
+    size_t table_size = (size_t) (4 * (num_data_points - 1));
 
-    if(order == 3){
-
-        data.resize(5); // (xs, level1 (scaling), level2, level3, level4)
-        data[0].resize(num_data_points);
-        double *xs = data[0].data();
-
-        for(int i = 0; i < num_data_points; i++){
-            xs[i] = -1. + 2*(double (i)) / (double (num_data_points - 1));
-        }
+    if (order == 1){
+        // (hat function, boundary wavelet, central wavelet)
+        tables.resize(3 * table_size);
+        tabulateLinear([](double x)->double{ return std::max(0.0, 1.0 - std::abs(x)); }, tables.data());
+        tabulateLinear(linear_boundary_wavelet, &(tables[table_size]));
+        tabulateLinear(linear_central_wavelet, &(tables[2 * table_size]));
+    }else if(order == 3){
 
-        cachexs = std::vector<double>((size_t) 4 * (num_data_points - 3));
-        for(int i = 0; i < num_data_points - 3; i++){
-            double const *s = &(xs[i]);
-            double *c = &(cachexs[4*i]);
-            double alpha = 1.0 / ((s[0] - s[3]) * (s[0] - s[2]));
-            double beta  = 1.0 / ((s[0] - s[3]) * (s[1] - s[3]));
-            c[0] =   alpha / (s[0] - s[1]);
-            c[1] = - alpha / (s[0] - s[1]) - alpha / (s[1] - s[2]) - beta / (s[1] - s[2]);
-            c[2] =   alpha / (s[1] - s[2]) + beta  / (s[1] - s[2]) + beta / (s[2] - s[3]);
-            c[3] = - beta  / (s[2] - s[3]);
-        }
+        std::vector<std::vector<double>> data(5); // (unused, level1 (scaling), level2, level3, level4)
 
         // Coefficients derived by solving linear system involving scaling function
         // integrals and moments.
@@ -164,6 +153,57 @@ void RuleWavelet::updateOrder(int ord){
                 }
             }
         }
+
+        // tables (3 scaling functions, 2 wavelets on level 2, 4 on level 3 and 6 on level 4, see getTable())
+        tables.resize(15 * table_size);
+        double *table = tables.data();
+        for(int level = 1; level <= 4; level++){
+            for(size_t index = 0; index < data[level].size() / ((size_t) num_data_points); index++){
+                tabulateCubic(&(data[level][index * num_data_points]), table);
+                table += table_size;
+            }
+        }
+    }
+}
+
+void RuleWavelet::tabulateCubic(const double y[], double *table) const{
+    // Interval i uses the cubic polynomial through the four nearest samples, starting at i-1 (shifted inward at the ends of the table),
+    // the Lagrange form is expanded in powers of t = x - x_i.
+    for(int i = 0; i < num_data_points - 1; i++){
+        int start = std::min(std::max(i - 1, 0), num_data_points - 4);
+        double xi = -1.0 + step * ((double) i);
+        double d[4]; // (x - s_j) = t + d_j
+        for(int j = 0; j < 4; j++) d[j] = xi - (-1.0 + step * ((double) (start + j)));
+        double *c = &(table[4 * i]);
+        std::fill_n(c, 4, 0.0);
+        for(int k = 0; k < 4; k++){
+            double e[3]; // the three roots of the k-th Lagrange polynomial
+            double denom = 1.0;
+            int n = 0;
+            for(int j = 0; j < 4; j++){
+                if (j != k){
+                    e[n++] = d[j];
+                    denom *= (d[j] - d[k]); // (s_k - s_j)
+                }
+            }
+            double w = y[start + k] / denom;
+            c[0] += w * e[0] * e[1] * e[2];
+            c[1] += w * (e[0] * e[1] + e[0] * e[2] + e[1] * e[2]);
+            c[2] += w * (e[0] + e[1] + e[2]);
+            c[3] += w;
+        }
+    }
+}
+
+void RuleWavelet::tabulateLinear(std::function<double(double)> f, double *table) const{
+    // the functions are linear between the tabulated points, the values at the two ends define the polynomial
+    for(int i = 0; i < num_data_points - 1; i++){
+        double xi = -1.0 + step * ((double) i);
+        double *c = &(table[4 * i]);
+        c[0] = f(xi);
+        c[1] = (f(xi + step) - c[0]) / step;
+        c[2] = 0.0;
+        c[3] = 0.0;
     }
 }
 
@@ -276,6 +316,47 @@ int RuleWavelet::getParent(int point) const{
     return (point+1)/2;
 }
 
+void RuleWavelet::getSupport(int point, double &left, double &right) const{
+    // The intervals follow from the arguments used in eval_linear() and eval_cubic(),
+    // the linear boundary wavelets are supported on [-1, 0], the central on [-1, 0.5], the cubic tables on [-1, 1].
+    constexpr double pad = 1.E-12;
+    left = -1.0;
+    right = 1.0;
+    if (order == 1){
+        if (point < 3){
+            left  = std::max(-1.0, getNode(point) - 1.0 - pad);
+            right = std::min( 1.0, getNode(point) + 1.0 + pad);
+            return;
+        }
+        int l = Maths::intlog2(point - 1);
+        int subindex = (point - 1) % (1 << l);
+        double scale = pow(2,l-2);
+        if (subindex == 0){
+            right = -1.0 + 1.0 / scale + pad;
+        }else if (subindex == (1 << l) - 1){
+            left = 1.0 - 1.0 / scale - pad;
+        }else{
+            double shift = 0.5 * (double (subindex - 1));
+            left  = -1.0 + shift / scale - pad;
+            right = -1.0 + (1.5 + shift) / scale + pad;
+        }
+    }else{
+        if (point < 17) return; // the scaling functions and the first two levels are supported everywhere
+        int l = Maths::intlog2(point - 1);
+        int subindex = (point - 1) % (1 << l);
+        double scale = pow(2,l-4);
+        if (subindex < 5){
+            right = -1.0 + 2.0 / scale + pad;
+        }else if ((1 << l) - 1 - subindex < 5){
+            left = 1.0 - 2.0 / scale - pad;
+        }else{
+            double shift = 0.125 * (double (subindex - 5));
+            left  = -1.0 + shift / scale - pad;
+            right = -1.0 + (2.0 + shift) / scale + pad;
+        }
+    }
+}
+
 double RuleWavelet::getNode(int point) const {
     // Returns the x-coordinate in the canonical domain associated with the given wavelet.
     if (point == 0) return  0.0;
@@ -306,35 +387,43 @@ double RuleWavelet::getWeight(int point) const{
     return 0.0;
 }
 
-double RuleWavelet::eval(int point, double x) const{
-    // Evaluates a wavelet designated by point at coordinate x.
-    if(order == 1){
+const double* RuleWavelet::getTable(int point, double &a, double &b) const{
+    // Returns the table of the mother function and the map a * x + b associated with the wavelet.
+    size_t table_size = (size_t) (4 * (num_data_points - 1));
+    a = 1.0;
+    b = 0.0;
+    if (order == 1){
         // Level 0
         if (point < 3){
-            double w = 1.0 - std::abs(x - getNode(point));
-            return (w < 0.0) ? 0.0 : w;
+            b = -getNode(point);
+            return tables.data();
         }
-        // Level 1+
-        return eval_linear(point, x);
-    }
-    else if(order == 3){
-        return eval_cubic(point, x);
+        // Standard Lifted Wavelets
+        int l = Maths::intlog2(point - 1);
+        int subindex = (point - 1) % (1 << l);
+        double scale = pow(2,l-2);
+        a = scale;
+        b = scale - 1.0;
+        // Left Boundary
+        if (subindex == 0) return &(tables[table_size]);
+        // Right Boundary
+        if (subindex == (1 << l) - 1){
+            a = -scale;
+            return &(tables[table_size]);
+        }
+        b -= 0.5 * (double (subindex - 1));
+        return &(tables[2 * table_size]);
     }
-    return 0.;
-}
-
-inline double RuleWavelet::eval_cubic(int point, double x) const{
-    // Evaluates a third order wavelet at a given point x.
+    // order 3
     if (point < 5){ // Scaling functions
         if (point == 2){ // Reflect across y-axis
             point = 1;
-            x = -x;
+            a = -1.0;
         }else if(point == 4){
             point = 3;
-            x = -x;
+            a = -1.0;
         }
-        const double *phi = &(data[1][((point+1)/2) * num_data_points]);
-        return interpolate(phi, x);
+        return &(tables[((point+1)/2) * table_size]);
     }
     int l = Maths::intlog2(point - 1);
 
@@ -342,58 +431,74 @@ inline double RuleWavelet::eval_cubic(int point, double x) const{
         if (point > 6){
             // i.e. 7 or 8
             // These wavelets are reflections across the y-axis of 6 & 5, respectively
-            x = -x;
+            a = -1.0;
             point = 13 - point;
         }
-        point -= 5;
-        return interpolate(&data[2][point*num_data_points],x);
+        return &(tables[(3 + point - 5) * table_size]);
     }else if(l == 3){
         if (point > 12){
             // i.e. 13, 14, 15, 16
             // These wavelets are reflections of 12, 11, 10, 9, respectively
-            x = -x;
+            a = -1.0;
             point = 25 - point;
         }
-        point -= 9;
-        return interpolate(&data[3][point*num_data_points],x);
+        return &(tables[(5 + point - 9) * table_size]);
     }
     // Standard lifted wavelets.
     int subindex = (point - 1) % (1 << l);
     double scale = pow(2,l-4);
+    a = scale;
+    b = scale - 1.0;
     // Left Boundary
-    if (subindex < 5){
-        return interpolate(&data[4][subindex*num_data_points],scale * (x + 1.) - 1.);
-    }
+    if (subindex < 5) return &(tables[(9 + subindex) * table_size]);
     // Right Boundary
     if ((1 << l) - 1 - subindex < 5){
-        return interpolate(&data[4][((1 << l) - subindex - 1)*num_data_points],scale * (1. - x) - 1.);
+        a = -scale;
+        return &(tables[(9 + (1 << l) - subindex - 1) * table_size]);
     }
     // Center
-    double shift = 0.125 * (double (subindex - 5));
-    return interpolate(&data[4][5*num_data_points], scale * (x + 1.) -1. - shift);
+    b -= 0.125 * (double (subindex - 5));
+    return &(tables[14 * table_size]);
 }
 
-inline double RuleWavelet::eval_linear(int point, double x) const{
-    // Given a wavelet designated by point and a value x, evaluates the wavelet at x.
+inline double RuleWavelet::evalTable(const double *table, double x) const{
+    if (x > 1. || x < -1.) return 0.0; // outside of the table
+    int i = std::min((int) ((x + 1.0) / step), num_data_points - 2);
+    double t = x - (-1.0 + step * ((double) i));
+    const double *c = &(table[4 * i]);
+    return c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+}
 
-    // Standard Lifted Wavelets
-    int l = Maths::intlog2(point - 1);
-    int subindex = (point - 1) % (1 << l);
-    double scale = pow(2,l-2);
+double RuleWavelet::eval(int point, double x) const{
+    // Evaluates a wavelet designated by point at coordinate x.
+    if (tables.empty()) return 0.0;
+    double a, b;
+    const double *table = getTable(point, a, b);
+    return evalTable(table, a * x + b);
+}
 
-    // Left Boundary
-    if (subindex == 0){
-        return linear_boundary_wavelet(scale * (x + 1.) - 1.);
+void RuleWavelet::eval(int point, int num_x, const double x[], double y[]) const{
+    if (tables.empty()){
+        std::fill_n(y, num_x, 0.0);
+        return;
     }
-    // Right Boundary
-    else if (subindex == (1 << l) - 1){
-        return linear_boundary_wavelet(scale * (1. - x) - 1.);
+    double a, b;
+    const double *table = getTable(point, a, b);
+    int last = num_data_points - 2;
+    #pragma omp simd
+    for(int k=0; k<num_x; k++){
+        double z = a * x[k] + b;
+        bool inside = (z >= -1.0) && (z <= 1.0);
+        double zc = (inside) ? z : -1.0;
+        int i = std::min((int) ((zc + 1.0) / step), last);
+        double t = zc - (-1.0 + step * ((double) i));
+        const double *c = &(table[4 * i]);
+        double v = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+        y[k] = (inside) ? v : 0.0;
     }
-    double shift = 0.5 * (double (subindex - 1));
-    return linear_central_wavelet(scale * (x + 1) - 1. - shift);
 }
 
-inline double RuleWavelet::linear_boundary_wavelet(double x) const{
+double RuleWavelet::linear_boundary_wavelet(double x){
     // Evaluates the first order boundary wavelet with support on [-1, 0].
     if (std::abs(x + 0.5) > 0.5) return 0.0;
 
@@ -406,7 +511,7 @@ inline double RuleWavelet::linear_boundary_wavelet(double x) const{
     }
 }
 
-inline double RuleWavelet::linear_central_wavelet(double x) const {
+double RuleWavelet::linear_central_wavelet(double x){
     // Evaluates the first order central wavelet with support on [-1, .5].
     if (std::abs(x + 0.25) > 0.75) return 0.0;
 
@@ -421,60 +526,4 @@ inline double RuleWavelet::linear_central_wavelet(double x) const {
     }
 }
 
-inline int RuleWavelet::find_index(double x) const{
-    // Finds an interval such that x_i <= x < x_i+1 using bisection search and returns i.
-    if (x > 1. || x < -1.){
-        return -1;
-    }
-    // Bisection search
-    const double *xs = data[0].data();
-    int low = 0;
-    int high = num_data_points-1;
-    while(high - low > 1){
-        int test = (high + low)/2;
-        if (x < xs[test]){
-            high = test;
-        }
-        else{
-            low = test;
-        }
-    }
-    return low;
-}
-
-inline double RuleWavelet::interpolate(const double *y, double x) const{
-    // For a given x value and dataset y, calculates the value of the interpolating
-    // polynomial of given order going through the nearby points.
-    constexpr int interpolation_order = 3;
-    int idx = find_index(x);
-
-    if (idx == -1){
-        // Outside of table
-        return 0.0;
-    }
-
-    // Neville's Algorithm
-    if (idx < interpolation_order/2){
-        idx = interpolation_order/2;
-    }else if(num_data_points - idx - 1 < (interpolation_order+1)/2){
-        idx = num_data_points - 1 - (interpolation_order+1)/2;
-    }
-
-    size_t start = (size_t)( idx - interpolation_order / 2 );
-    double const *xs = &(data[0][start]);
-    double const *ps = &(y[start]);
-
-    double const dx0 = x - xs[0];
-    double const dx1 = x - xs[1];
-    double const dx2 = x - xs[2];
-    double const dx3 = x - xs[3];
-
-    double const *c = &(cachexs[4*start]);
-
-    return   c[0] * ps[0] * dx1 * dx2 * dx3
-           + c[1] * ps[1] * dx0 * dx2 * dx3
-           + c[2] * ps[2] * dx0 * dx1 * dx3
-           + c[3] * ps[3] * dx0 * dx1 * dx2;
-}
-
 } // namespace TasGrid
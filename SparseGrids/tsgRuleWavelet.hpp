@@ -52,26 +52,33 @@ public:
 
     double getWeight(int point) const; // get the quadrature weight associated with the point
     double eval(int point, double x) const; // returns the value of point at location x (there is assumed 1-1 correspondence between points and functions)
+    void eval(int point, int num_x, const double x[], double y[]) const; // evaluates the point at all num_x values of x, the loop over x is vectorized
 
     int getLevel(int point) const; // returns the hierarchical level of a point
     void getChildren(int point, int &first, int &second) const; // Given a point, return the children (if any)
     int getParent(int point) const; // Returns the parent of the given node
+    void getSupport(int point, double &left, double &right) const; // Returns an interval that contains the support of the wavelet (padded for round-off)
 
 protected:
-    inline double eval_linear(int pt, double x) const;
-    inline double eval_cubic(int pt, double x) const;
-    inline double linear_boundary_wavelet(double x) const;
-    inline double linear_central_wavelet(double x) const;
+    // Each wavelet is one of the tabulated mother functions composed with an affine map, i.e., table(a * x + b),
+    // the tables hold piecewise cubic polynomials over the uniform grid of num_data_points on [-1, 1], four coefficients per interval.
+    // The cubic wavelets come from the cascade data (the polynomials interpolate the four nearest samples),
+    // the linear ones are exact, since the kinks of the hat and the lifted wavelets fall on the grid (iteration_depth >= 3).
+    // The accuracy of the cubic wavelets is controlled by the iteration_depth of the cascade,
+    // the error decays as 4^-iteration_depth, see GridWavelet::wavelet_cascade_depth for the value used by the grids.
+    const double* getTable(int point, double &a, double &b) const;
+    inline double evalTable(const double *table, double x) const;
+    void tabulateCubic(const double y[], double *table) const;
+    void tabulateLinear(std::function<double(double)> f, double *table) const;
+    static double linear_boundary_wavelet(double x);
+    static double linear_central_wavelet(double x);
     int order;
     int iteration_depth;
     int num_data_points;
+    double step; // distance between the tabulated points
     static void cubic_cascade(double *y, int starting_level, int iteration_depth);
 
-    inline int find_index(double x) const;
-    inline double interpolate(const double *y, double x) const;
-
-    std::vector<std::vector<double>> data;
-    std::vector<double> cachexs;
+    std::vector<double> tables;
 };
 
 } // namespace TasGrid